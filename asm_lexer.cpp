@@ -0,0 +1,115 @@
+#include "asm_lexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+  bool is_space(char c) { return std::isspace(uint8_t(c)); }
+  bool is_alpha(char c) { return std::isalpha(uint8_t(c)); }
+  bool is_alnum(char c) { return std::isalnum(uint8_t(c)); }
+
+  // the quotes are written as UTF-8 in the examples (”“)
+  bool is_operand(char c)
+  {
+    switch(c)
+    {
+      case '-': case '+': case ',': case '#': case '_': case '@': case '(': case ')':
+      case '\xE2': case '\x80': case '\x9C': case '\x9D':
+        return true;
+      default:
+        return is_alnum(c);
+    }
+  }
+
+  class line_scanner
+  {
+  public:
+    explicit line_scanner(std::string_view text) : line(text) { }
+
+    // runs 'match' after the leading white space.  'match' returns the end of
+    // the part (npos if there is none) and the part is taken up to there.
+    template<typename Func>
+    std::string_view take(Func match)
+    {
+      std::size_t start = pos;
+      while(start < line.size() && is_space(line[start]))
+        ++start;
+      const std::size_t end = match(start);
+      if(end == std::string_view::npos)
+        return {};
+      pos = end;
+      return line.substr(start, end - start);
+    }
+
+    std::size_t span(std::size_t start, bool (*accept)(char)) const
+    {
+      while(start < line.size() && accept(line[start]))
+        ++start;
+      return start;
+    }
+
+    std::string_view line;
+    std::size_t pos = 0;
+  };
+
+  constexpr std::size_t none = std::string_view::npos;
+}
+
+asm_line split_assembly_line(std::string_view text, bool listing)
+{
+  asm_line rval;
+  line_scanner s(text);
+  const std::string_view& line = s.line;
+
+  if(listing)
+  {
+    rval.address = s.take([&](std::size_t start)
+    {
+      const std::size_t end = s.span(start, [](char c) -> bool { return std::isxdigit(uint8_t(c)); });
+      return end - start < 4 ? none : start + std::min<std::size_t>(end - start, 8);
+    });
+    if(!rval.address.empty())
+      s.pos = s.span(s.pos, is_space);
+  }
+
+  rval.label = s.take([&](std::size_t start)
+  {
+    if(start >= line.size() || !(is_alpha(line[start]) || line[start] == '_'))
+      return none;
+    const std::size_t end = s.span(start + 1, [](char c) { return is_alnum(c) || c == '_'; });
+    return end < line.size() && line[end] == ':' ? end + 1 : none;
+  });
+
+  rval.mnemonic = s.take([&](std::size_t start)
+  {
+    if(start >= line.size() || !is_alpha(line[start]))
+      return none;
+    const std::size_t end = s.span(start + 1, [](char c) { return is_alnum(c) || c == '/' || c == '.'; });
+    return end > start + 1 ? end : none;
+  });
+
+  rval.directive = s.take([&](std::size_t start)
+  {
+    if(start + 1 >= line.size() || line[start] != '.' || !is_alpha(line[start + 1]))
+      return none;
+    const std::size_t end = s.span(start + 2, [](char c) { return is_alnum(c) || c == '.'; });
+    return end > start + 2 ? end : none;
+  });
+
+  rval.operand = s.take([&](std::size_t start)
+  {
+    const std::size_t end = s.span(start, is_operand);
+    return end > start ? end : none;
+  });
+
+  const std::string_view comment = s.take([&](std::size_t start)
+    { return start < line.size() && line[start] == ';' ? line.size() : none; });
+  if(!comment.empty())
+    rval.comment = comment.substr(1);
+
+  rval.rest = line.substr(s.pos);
+  return rval;
+}
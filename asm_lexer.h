@@ -0,0 +1,24 @@
+#ifndef ASM_LEXER_H
+#define ASM_LEXER_H
+
+#include <string_view>
+
+// the parts of a line of SH assembly, laid out as in the examples of the
+// database ("00001000  loop: add r1,r2 ; comment").  every part is optional
+// and is looked for once, in this order, after the previous one.
+struct asm_line
+{
+  std::string_view address;   // listings only: 4 to 8 hex digits
+  std::string_view label;     // "loop:" with the colon
+  std::string_view mnemonic;  // "mov.l", "cmp/eq"
+  std::string_view directive; // ".data.l"
+  std::string_view operand;   // first run of operand characters ("@(4,r1),r2")
+  std::string_view comment;   // after ';'
+  std::string_view rest;      // text none of the parts took
+};
+
+// 'listing' looks for an address column first.
+// the parts are views into 'line', which must not hold a newline.
+asm_line split_assembly_line(std::string_view line, bool listing);
+
+#endif // ASM_LEXER_H
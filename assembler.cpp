@@ -0,0 +1,611 @@
+#include "assembler.h"
+#include "instruction_names.h"
+#include "operand_extractor.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std::literals::string_literals;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+  // SH-DSP register selections of the operand letters, see dsp_decoder.cpp
+  constexpr const char* sx_names[] = { "x0", "x1", "a0", "a1" };
+  constexpr const char* sy_names[] = { "y0", "y1", "m0", "m1" };
+  constexpr const char* du_names[] = { "x0", "y0", "a0", "a1" };
+  constexpr const char* se_names[] = { "x0", "x1", "y0", "a1" };
+  constexpr const char* sf_names[] = { "y0", "y1", "x0", "a1" };
+  constexpr const char* dg_names[] = { "m0", "m1", "a0", "a1" };
+  constexpr const char* dz_names[] =
+  {
+    "",   "",    "",   "",
+    "",   "a1",  "",   "a0",
+    "x0", "x1",  "y0", "y1",
+    "m0", "a1g", "m1", "a0g",
+  };
+  constexpr const char* ax_names[] = { "r4", "r5" };
+  constexpr const char* ay_names[] = { "r6", "r7" };
+  constexpr const char* as_names[] = { "r4", "r5", "r2", "r3" };
+  constexpr const char* dx_names[] = { "x0", "x1" };
+  constexpr const char* dy_names[] = { "y0", "y1" };
+  constexpr const char* da_names[] = { "a0", "a1" };
+
+  using kind = assembler::operand_kind;
+
+  struct placeholder
+  {
+    std::string_view name;
+    kind k;
+    char letter;
+    const char* const* names;
+    uint8_t name_count;
+  };
+
+  template<std::size_t N>
+  constexpr placeholder dsp_placeholder(std::string_view name, char letter, const char* const (&names)[N])
+    { return { name, kind::dsp, letter, names, uint8_t(N) }; }
+
+  constexpr placeholder placeholders[] =
+  {
+    { "Rn", kind::general, 'n', nullptr, 0 },
+    { "Rm", kind::general, 'm', nullptr, 0 },
+    { "Rn_BANK", kind::banked, 'n', nullptr, 0 },
+    { "Rm_BANK", kind::banked, 'm', nullptr, 0 },
+    { "FRn", kind::single, 'n', nullptr, 0 },
+    { "FRm", kind::single, 'm', nullptr, 0 },
+    { "DRn", kind::pair, 'n', nullptr, 0 },
+    { "DRm", kind::pair, 'm', nullptr, 0 },
+    { "XDn", kind::extended, 'n', nullptr, 0 },
+    { "XDm", kind::extended, 'm', nullptr, 0 },
+    { "FVn", kind::vector, 'n', nullptr, 0 },
+    { "FVm", kind::vector, 'm', nullptr, 0 },
+    { "imm", kind::immediate, 'i', nullptr, 0 },
+    { "imm3", kind::immediate, 'i', nullptr, 0 },
+    { "imm20", kind::immediate, 'i', nullptr, 0 },
+    { "disp", kind::displacement, 'd', nullptr, 0 },
+    { "disp8", kind::displacement, 'd', nullptr, 0 },
+    { "disp12", kind::displacement, 'd', nullptr, 0 },
+    { "label", kind::label, 'd', nullptr, 0 },
+    dsp_placeholder("Sx", 'x', sx_names),
+    dsp_placeholder("Sy", 'y', sy_names),
+    dsp_placeholder("Dz", 'z', dz_names),
+    dsp_placeholder("Du", 'u', du_names),
+    dsp_placeholder("Se", 'e', se_names),
+    dsp_placeholder("Sf", 'f', sf_names),
+    dsp_placeholder("Dg", 'g', dg_names),
+    dsp_placeholder("Ax", 'A', ax_names),
+    dsp_placeholder("Ay", 'A', ay_names),
+    dsp_placeholder("As", 'A', as_names),
+    dsp_placeholder("Dx", 'D', dx_names),
+    dsp_placeholder("Dy", 'D', dy_names),
+    dsp_placeholder("Da", 'D', da_names),
+    dsp_placeholder("Ds", 'D', dz_names),
+  };
+
+  // the index registers are fixed
+  constexpr std::pair<std::string_view, std::string_view> fixed_names[] =
+  {
+    { "Ix", "r8" }, { "Is", "r8" }, { "Iy", "r9" },
+  };
+
+  bool is_identifier_start(char c)
+    { return std::isalpha(uint8_t(c)) || c == '_' || c == '.'; }
+
+  bool is_identifier_char(char c)
+    { return std::isalnum(uint8_t(c)) || c == '_' || c == '.' || c == '/'; }
+
+  std::string lowercase(std::string_view text)
+  {
+    std::string rval(text);
+    for(char& c : rval)
+      c = char(std::tolower(uint8_t(c)));
+    return rval;
+  }
+
+  // "dcf psub " -> "dcf psub"
+  std::string mnemonic_key(std::string_view text)
+  {
+    std::string rval;
+    for(char c : text)
+    {
+      if(c == ' ')
+      {
+        if(!rval.empty() && rval.back() != ' ')
+          rval += ' ';
+      }
+      else
+        rval += char(std::tolower(uint8_t(c)));
+    }
+    if(!rval.empty() && rval.back() == ' ')
+      rval.pop_back();
+    return rval;
+  }
+
+  std::vector<assembler::operand_token> compile_operands(std::string_view text)
+  {
+    std::vector<assembler::operand_token> rval;
+    for(std::size_t pos = 0; pos < text.size(); )
+    {
+      const char c = text[pos];
+      if(std::isspace(uint8_t(c)))
+      {
+        ++pos;
+        continue;
+      }
+      if(!is_identifier_start(c))
+      {
+        rval.push_back({ kind::literal, 0, nullptr, 0, std::string(1, c) });
+        ++pos;
+        continue;
+      }
+
+      std::size_t end = pos;
+      while(end < text.size() && (std::isalnum(uint8_t(text[end])) || text[end] == '_' || text[end] == '.'))
+        ++end;
+      const std::string_view name = text.substr(pos, end - pos);
+      pos = end;
+
+      auto p = std::find_if(std::begin(placeholders), std::end(placeholders),
+                            [&](const placeholder& ph) { return ph.name == name; });
+      if(p != std::end(placeholders))
+      {
+        rval.push_back({ p->k, p->letter, p->names, p->name_count, std::string() });
+        continue;
+      }
+      auto f = std::find_if(std::begin(fixed_names), std::end(fixed_names),
+                            [&](const auto& n) { return n.first == name; });
+      rval.push_back({ kind::literal, 0, nullptr, 0, f != std::end(fixed_names) ? std::string(f->second) : lowercase(name) });
+    }
+    return rval;
+  }
+
+  bool fits(int64_t value, const assembler::form_field& field)
+  {
+    if(field.is_signed)
+      return value >= -(int64_t(1) << (field.width - 1)) && value < (int64_t(1) << (field.width - 1));
+    return value >= 0 && value < (int64_t(1) << field.width);
+  }
+
+  // register number of "r12", "fr3", ... (-1 if 'text' is something else)
+  int register_number(std::string_view text, std::string_view prefix, std::string_view suffix = {})
+  {
+    if(text.size() <= prefix.size() + suffix.size() || text.size() > prefix.size() + suffix.size() + 2)
+      return -1;
+    for(std::size_t i = 0; i < prefix.size(); ++i)
+      if(std::tolower(uint8_t(text[i])) != prefix[i])
+        return -1;
+    for(std::size_t i = 0; i < suffix.size(); ++i)
+      if(std::tolower(uint8_t(text[text.size() - suffix.size() + i])) != suffix[i])
+        return -1;
+
+    const std::string_view digits = text.substr(prefix.size(), text.size() - prefix.size() - suffix.size());
+    int rval = 0;
+    for(char c : digits)
+    {
+      if(!std::isdigit(uint8_t(c)))
+        return -1;
+      rval = rval * 10 + (c - '0');
+    }
+    if((digits.size() == 2 && digits[0] == '0') || rval > 15)
+      return -1;
+    return rval;
+  }
+
+  bool equals_lowercase(std::string_view text, std::string_view lower)
+  {
+    if(text.size() != lower.size())
+      return false;
+    for(std::size_t i = 0; i < text.size(); ++i)
+      if(std::tolower(uint8_t(text[i])) != lower[i])
+        return false;
+    return true;
+  }
+
+  bool is_dsp_move_name(std::string_view name)
+  {
+    return equals_lowercase(name.substr(0, 4), "movx") || equals_lowercase(name.substr(0, 4), "movy") ||
+           equals_lowercase(name, "nopx") || equals_lowercase(name, "nopy");
+  }
+
+  constexpr std::size_t max_source_tokens = 48;
+}
+
+struct assembler::source_token
+{
+  enum type_t : uint8_t { identifier, number, punctuation } type;
+  std::string_view text;
+  int64_t value;
+};
+
+assembler::assembler(isa variant)
+  : target(variant)
+{
+  const std::vector<instruction_entry>& entries = instruction_entries();
+  const std::vector<operand_extractor>& extractors = operand_extractors();
+  const isa sets = cpu_instruction_sets(variant);
+
+  forms.reserve(entries.size());
+  for(const instruction_entry& entry : entries)
+  {
+    const std::string& fmt = entry.source->data<::format>();
+    const std::size_t tab = fmt.find('\t');
+
+    form f;
+    f.id = entry.id;
+    f.available = entry.source->for_isa(sets);
+    f.width = entry.pattern.width;
+    f.match = entry.pattern.match;
+    f.displacement = displacement_of(*entry.source);
+    f.tokens = compile_operands(tab == std::string::npos ? std::string_view() : std::string_view(fmt).substr(tab + 1));
+    f.pc_operand = -1;
+    if(f.displacement.pc_relative)
+      for(std::size_t k = 0; k + 6 <= f.tokens.size(); ++k)
+        if(f.tokens[k].text == "@" && f.tokens[k + 1].text == "(" && f.tokens[k + 2].kind == kind::displacement &&
+           f.tokens[k + 3].text == "," && f.tokens[k + 4].text == "pc" && f.tokens[k + 5].text == ")")
+          f.pc_operand = int(k);
+
+    const std::string name = mnemonic_key(std::string_view(fmt).substr(0, tab));
+    const uint16_t first = uint16_t(f.match >> (f.width - 16));
+    f.dsp_move = f.width == 16 && (first & 0xFC00) == 0xF000 && is_dsp_move_name(name);
+    f.dsp_operation = f.width == 32 && (first & 0xFC00) == 0xF800;
+
+    const operand_extractor& ex = extractors[entry.id];
+    for(std::size_t n = 0; n < entry.pattern.fields.size(); ++n)
+    {
+      const operand_field& field = entry.pattern.fields[n];
+      f.fields.push_back({ field.letter, field.mask, field.width, n < ex.count && ex.sign_bit[n] != 0 });
+    }
+
+    // a few entries name the register Rm with an nnnn field ("lds.l @Rm+,X0")
+    for(operand_token& t : f.tokens)
+    {
+      auto has_field = [&](char letter)
+        { return std::any_of(f.fields.begin(), f.fields.end(), [&](const form_field& ff) { return ff.letter == letter; }); };
+      if((t.letter == 'n' || t.letter == 'm') && !has_field(t.letter))
+        t.letter = t.letter == 'n' ? 'm' : 'n';
+    }
+
+    // the generated mnemonic table must list the form
+    const name_ids ids = find_instruction_mnemonic(name);
+    if(std::find(ids.begin(), ids.end(), entry.id) == ids.end())
+      throw("instruction_names.h does not match the database, run make names"s);
+    forms.push_back(std::move(f));
+  }
+}
+
+
+bool assembler::is_mnemonic(std::string_view name)
+{
+  return !find_instruction_mnemonic(name).empty();
+}
+
+namespace
+{
+  struct operand_match
+  {
+    std::array<std::pair<char, int64_t>, max_operand_fields + 2> values;
+    std::size_t count = 0;
+    std::string_view label; // unresolved label
+    bool out_of_range = false;
+
+    bool set(char letter, int64_t value)
+    {
+      for(std::size_t n = 0; n < count; ++n)
+        if(values[n].first == letter)
+          return values[n].second == value;
+      if(count == values.size())
+        return false;
+      values[count++] = { letter, value };
+      return true;
+    }
+  };
+}
+
+assembled_instruction assembler::assemble_tokens(const source_token* tokens, std::size_t count, uint32_t address,
+                                                 const symbol_table& symbols) const
+{
+  if(count == 0 || tokens[0].type != source_token::identifier)
+    throw("expected a mnemonic"s);
+
+  // "dct padd ...": the condition is part of the mnemonic
+  std::string name = lowercase(tokens[0].text);
+  std::size_t first_operand = 1;
+  if((name == "dct" || name == "dcf") && count > 1 && tokens[1].type == source_token::identifier)
+  {
+    name += ' ' + lowercase(tokens[1].text);
+    first_operand = 2;
+  }
+
+  const name_ids ids = find_instruction_mnemonic(name);
+  if(ids.empty())
+    throw("unknown mnemonic: "s + name);
+
+  bool unavailable = false;
+  bool out_of_range = false;
+  for(uint16_t id : ids)
+  {
+    const form& f = forms[id];
+    operand_match m;
+    std::size_t pos = first_operand;
+    bool matched = true;
+
+    // the offset of label 'text' from the base of the displacement, 0 until
+    // fixup() when it is not defined yet
+    auto label_offset = [&](std::string_view text) -> int64_t
+    {
+      auto sym = symbols.find(std::string(text));
+      if(sym == symbols.end())
+      {
+        m.label = text;
+        return 0;
+      }
+      return int64_t(int32_t(sym->second - f.displacement.target(address, 0)));
+    };
+
+    for(std::size_t k = 0; k < f.tokens.size(); ++k)
+    {
+      const operand_token& t = f.tokens[k];
+      if(pos >= count)
+      {
+        matched = false;
+        break;
+      }
+      const source_token& s = tokens[pos];
+
+      // a label for the whole "@(disp,PC)"
+      if(int(k) == f.pc_operand && s.type == source_token::identifier && register_number(s.text, "r") < 0)
+      {
+        const int64_t value = label_offset(s.text);
+        if(value % f.displacement.scale)
+        {
+          m.out_of_range = true;
+          break;
+        }
+        matched = m.set('d', value / f.displacement.scale);
+        k += 5;
+        ++pos;
+        if(!matched)
+          break;
+        continue;
+      }
+
+      switch(t.kind)
+      {
+        case kind::literal:
+          matched = equals_lowercase(s.text, t.text);
+          ++pos;
+          break;
+
+        case kind::general:
+        case kind::single:
+        case kind::pair:
+        case kind::extended:
+        case kind::vector:
+        {
+          const char* prefix = t.kind == kind::general ? "r" : t.kind == kind::single ? "fr" :
+                               t.kind == kind::pair ? "dr" : t.kind == kind::extended ? "xd" : "fv";
+          const int step = t.kind == kind::vector ? 4 : (t.kind == kind::pair || t.kind == kind::extended) ? 2 : 1;
+          const int r = s.type == source_token::identifier ? register_number(s.text, prefix) : -1;
+          matched = r >= 0 && r % step == 0 && m.set(t.letter, r / step);
+          ++pos;
+          break;
+        }
+
+        case kind::banked:
+        {
+          const int r = s.type == source_token::identifier ? register_number(s.text, "r", "_bank") : -1;
+          matched = r >= 0 && r < 8 && m.set(t.letter, r);
+          ++pos;
+          break;
+        }
+
+        case kind::dsp:
+        {
+          matched = false;
+          if(s.type == source_token::identifier)
+            for(uint8_t r = 0; r < t.name_count && !matched; ++r)
+              if(*t.names[r] && equals_lowercase(s.text, t.names[r]))
+                matched = m.set(t.letter, r);
+          ++pos;
+          break;
+        }
+
+        case kind::immediate:
+        case kind::displacement:
+        case kind::label:
+        {
+          bool negative = false;
+          if(s.type == source_token::punctuation && s.text == "-"sv && pos + 1 < count &&
+             tokens[pos + 1].type == source_token::number)
+          {
+            negative = true;
+            ++pos;
+          }
+          const source_token& v = tokens[pos++];
+          int64_t value = negative ? -v.value : v.value;
+
+          if(t.kind == kind::label || (t.kind == kind::displacement && f.displacement.pc_relative &&
+                                       v.type == source_token::identifier && !negative))
+          {
+            if(v.type == source_token::identifier && !negative)
+              value = label_offset(v.text);
+            else if(v.type != source_token::number)
+            {
+              matched = false;
+              break;
+            }
+            else if(t.kind == kind::label) // a number for a label is an address
+              value = int64_t(int32_t(uint32_t(value) - f.displacement.target(address, 0)));
+          }
+          else if(v.type != source_token::number)
+          {
+            matched = false;
+            break;
+          }
+
+          if(t.kind != kind::immediate)
+          {
+            if(value % f.displacement.scale)
+            {
+              m.out_of_range = true;
+              break;
+            }
+            value /= f.displacement.scale;
+          }
+          matched = m.set(t.letter, value);
+          break;
+        }
+      }
+      if(!matched)
+        break;
+    }
+
+    // SH-DSP: the rest of the line may hold the parallel X and Y moves
+    std::size_t move_start = pos;
+    if(matched && pos < count && !((f.dsp_move || f.dsp_operation) && is_dsp_move_name(tokens[pos].text)))
+      matched = false;
+    if(!matched)
+      continue;
+
+    if(!f.available)
+    {
+      unavailable = true;
+      continue;
+    }
+
+    uint32_t word = f.match;
+    for(std::size_t v = 0; v < m.count && !m.out_of_range; ++v)
+    {
+      auto field = std::find_if(f.fields.begin(), f.fields.end(),
+                                [&](const form_field& ff) { return ff.letter == m.values[v].first; });
+      if(field == f.fields.end())
+        continue;
+      if(!fits(m.values[v].second, *field))
+        m.out_of_range = true;
+      word |= deposit_bits(uint32_t(m.values[v].second), field->mask);
+    }
+    if(m.out_of_range)
+    {
+      out_of_range = true;
+      continue;
+    }
+
+    assembled_instruction rval;
+    rval.word = word;
+    rval.size = uint8_t(f.width / 8);
+    rval.id = f.id;
+    rval.label = std::string(m.label);
+
+    while(move_start < count)
+    {
+      // the next move starts at the next move mnemonic
+      std::size_t end = move_start + 1;
+      while(end < count && !(tokens[end].type == source_token::identifier && is_dsp_move_name(tokens[end].text)))
+        ++end;
+      const assembled_instruction move = assemble_tokens(tokens + move_start, end - move_start, address, symbols);
+      if(!forms[move.id].dsp_move)
+        throw("not a parallel move: "s + std::string(tokens[move_start].text));
+      rval.word |= (move.word & 0x3FF) << (f.width - 16);
+      move_start = end;
+    }
+    return rval;
+  }
+
+  if(out_of_range)
+    throw("operand out of range: "s + name);
+  if(unavailable)
+    throw(name + " is not available on " + cpu_name(target));
+  throw("invalid operands for "s + name);
+}
+
+assembled_instruction assembler::assemble(std::string_view text, uint32_t address, const symbol_table& symbols) const
+{
+  source_token tokens[max_source_tokens];
+  std::size_t count = 0;
+
+  for(std::size_t pos = 0; pos < text.size(); )
+  {
+    const char c = text[pos];
+    if(c == ';' || c == '!') // comments
+      break;
+    if(std::isspace(uint8_t(c)))
+    {
+      ++pos;
+      continue;
+    }
+    if(count == max_source_tokens)
+      throw("line too long"s);
+
+    source_token& t = tokens[count++];
+    const std::size_t start = pos;
+    if((c == 'H' || c == 'h') && pos + 1 < text.size() && text[pos + 1] == '\'')
+    {
+      // H'1F
+      pos += 2;
+      t.type = source_token::number;
+      t.value = 0;
+      const std::size_t digits = pos;
+      for(; pos < text.size() && std::isxdigit(uint8_t(text[pos])); ++pos)
+      {
+        const char d = char(std::tolower(uint8_t(text[pos])));
+        t.value = t.value * 16 + (std::isdigit(uint8_t(d)) ? d - '0' : d - 'a' + 10);
+      }
+      if(pos == digits)
+        throw("invalid number: "s + std::string(text.substr(start, pos - start)));
+    }
+    else if(std::isdigit(uint8_t(c)))
+    {
+      t.type = source_token::number;
+      t.value = 0;
+      int base = 10;
+      if(c == '0' && pos + 1 < text.size() && (text[pos + 1] == 'x' || text[pos + 1] == 'X'))
+      {
+        base = 16;
+        pos += 2;
+      }
+      const std::size_t digits = pos;
+      for(; pos < text.size() && std::isalnum(uint8_t(text[pos])); ++pos)
+      {
+        const char d = char(std::tolower(uint8_t(text[pos])));
+        const int digit = std::isdigit(uint8_t(d)) ? d - '0' : d - 'a' + 10;
+        if(digit >= base)
+          throw("invalid number: "s + std::string(text.substr(start, pos + 1 - start)));
+        t.value = t.value * base + digit;
+      }
+      if(pos == digits)
+        throw("invalid number: "s + std::string(text.substr(start, pos - start)));
+    }
+    else if(is_identifier_start(c))
+    {
+      t.type = source_token::identifier;
+      while(pos < text.size() && is_identifier_char(text[pos]))
+        ++pos;
+    }
+    else
+    {
+      t.type = source_token::punctuation;
+      ++pos;
+    }
+    t.text = text.substr(start, pos - start);
+  }
+
+  return assemble_tokens(tokens, count, address, symbols);
+}
+
+void assembler::fixup(assembled_instruction& insn, uint32_t address, uint32_t target_address) const
+{
+  const form& f = forms[insn.id];
+  auto field = std::find_if(f.fields.begin(), f.fields.end(), [](const form_field& ff) { return ff.letter == 'd'; });
+  if(field == f.fields.end())
+    return;
+
+  const int64_t offset = int64_t(int32_t(target_address - f.displacement.target(address, 0)));
+  if(offset % f.displacement.scale)
+    throw("misaligned label: "s + insn.label);
+  if(!fits(offset / f.displacement.scale, *field))
+    throw("label out of range: "s + insn.label);
+
+  insn.word = (insn.word & ~field->mask) | deposit_bits(uint32_t(offset / f.displacement.scale), field->mask);
+  insn.label.clear();
+}
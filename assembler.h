@@ -0,0 +1,105 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "decoder.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+typedef std::unordered_map<std::string, uint32_t> symbol_table;
+
+struct assembled_instruction
+{
+  uint32_t word = 0;  // the first halfword is in the upper half of 32-bit forms
+  uint8_t size = 0;   // bytes
+  uint16_t id = invalid_instruction;
+  std::string label;  // label operand missing from the symbols, see assembler::fixup()
+};
+
+// assembles single instructions with the format strings of the database as
+// operand templates ("mov.l\t@(disp,Rm),Rn" accepts "mov.l @(8,r4),r1").
+// mnemonics are found through the compile time perfect hash of
+// instruction_names.h, the operands are matched against
+// the templates of the forms available on the CPU variant and packed into the
+// opcode.  the shortest form that holds the operands is chosen.  a PC
+// relative displacement may be given as a label, also in place of the whole
+// operand ("mov.l lit,r1" for "mov.l @(lit,pc),r1").
+// errors are thrown as std::string.
+class assembler
+{
+public:
+  explicit assembler(isa variant);
+
+  isa variant(void) const { return target; }
+
+  // 'text' is one instruction (SH-DSP: one line of parallel parts), 'address'
+  // its location for PC relative operands
+  assembled_instruction assemble(std::string_view text, uint32_t address, const symbol_table& symbols) const;
+
+  // fills in the label operand of 'insn' once its target is known
+  void fixup(assembled_instruction& insn, uint32_t address, uint32_t target) const;
+
+  // true if 'name' is a mnemonic of any instruction of the database
+  static bool is_mnemonic(std::string_view name);
+
+  enum class operand_kind : uint8_t
+  {
+    literal,      // punctuation or a fixed name ("@", "gbr", "r0")
+    general,      // r0 - r15
+    banked,       // r0_bank - r7_bank
+    single,       // fr0 - fr15
+    pair,         // dr0 - dr14
+    extended,     // xd0 - xd14
+    vector,       // fv0 - fv12
+    immediate,
+    displacement,
+    label,
+    dsp,          // SH-DSP register or pointer, see 'names'
+  };
+
+  struct operand_token
+  {
+    operand_kind kind;
+    char letter;              // opcode field of placeholders
+    const char* const* names; // dsp: encodings of the field
+    uint8_t name_count;
+    std::string text;         // literal: lowercase text
+  };
+
+  struct form_field
+  {
+    char letter;
+    uint32_t mask;
+    uint8_t width;
+    bool is_signed;
+  };
+
+  struct form
+  {
+    uint16_t id;
+    bool available;    // on the CPU variant
+    bool dsp_move;     // 16-bit X/Y memory move, combines with other parallel parts
+    bool dsp_operation;
+    uint8_t width;
+    uint32_t match;
+    displacement_info displacement;
+    int pc_operand;    // first token of "@(disp,PC)", which a label may replace, or -1
+    std::vector<operand_token> tokens;
+    std::vector<form_field> fields;
+  };
+
+private:
+  struct source_token;
+
+  assembled_instruction assemble_tokens(const source_token* tokens, std::size_t count, uint32_t address,
+                                        const symbol_table& symbols) const;
+
+  isa target;
+  std::vector<form> forms; // by instruction id
+};
+
+#endif // ASSEMBLER_H
@@ -0,0 +1,219 @@
+#include "batch_decoder.h"
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define HAVE_X86_INTRINSICS
+#endif
+
+using namespace std::literals::string_literals;
+
+void decoded_stream::reserve(std::size_t instructions)
+{
+  if(offset.size() >= instructions)
+    return;
+  offset.resize(instructions);
+  id.resize(instructions);
+  for(auto& values : field)
+    values.resize(instructions);
+}
+
+namespace
+{
+  const operand_extractor no_operands;
+
+  // decodes the instruction at words[pos] and returns its size in halfwords
+  inline std::size_t decode_one(const decode_table& table,
+                                const std::vector<operand_extractor>& extractors,
+                                extract_function extract,
+                                const uint16_t* words, std::size_t pos, std::size_t count,
+                                decoded_stream& out)
+  {
+    const uint16_t first = words[pos];
+    const uint16_t second = pos + 1 < count ? words[pos + 1] : 0;
+
+    uint16_t id = table.decode(first, second);
+    std::size_t halfwords = table.size(id) / 2;
+    if(pos + halfwords > count) // truncated 32-bit instruction
+    {
+      id = invalid_instruction;
+      halfwords = 1;
+    }
+
+    operand_values values;
+    uint32_t word = halfwords == 2 ? (uint32_t(first) << 16) | second : first;
+    extract(id < extractors.size() ? extractors[id] : no_operands, word, values);
+
+    const std::size_t n = out.count++;
+    out.offset[n] = uint32_t(pos * 2);
+    out.id[n] = id;
+    for(std::size_t f = 0; f < max_operand_fields; ++f)
+      out.field[f][n] = values.value[f];
+    return halfwords;
+  }
+}
+
+std::size_t decode_stream_scalar(const decode_table& table, const uint16_t* words,
+                                 std::size_t count, decoded_stream& out)
+{
+  const std::vector<operand_extractor>& extractors = operand_extractors();
+  const extract_function extract = select_operand_extractor();
+
+  out.count = 0;
+  out.reserve(count);
+  for(std::size_t pos = 0; pos < count; )
+    pos += decode_one(table, extractors, extract, words, pos, count, out);
+  return out.count;
+}
+
+#if defined(HAVE_X86_INTRINSICS)
+namespace
+{
+  constexpr std::size_t simd_fields = 3;
+
+  // packed layout of the (at most three, contiguous) operand fields of 16-bit instructions.
+  // each field takes 10 bits: bits 0-3 shift, bits 4-8 width, bit 9 sign extend.
+  // the last element is the empty layout of invalid_instruction.
+  const std::vector<uint32_t>& simd_layouts(void)
+  {
+    static const std::vector<uint32_t> layouts = []
+    {
+      std::vector<uint32_t> rval;
+      for(const instruction_entry& entry : instruction_entries())
+      {
+        uint32_t layout = 0;
+        if(entry.pattern.width == 16)
+        {
+          const operand_extractor& x = operand_extractors()[entry.id];
+          if(x.count > simd_fields)
+            throw("Too many operand fields for the SIMD decoder: "s + entry.source->data<opcode>());
+          for(std::size_t f = 0; f < x.count; ++f)
+          {
+            if(x.high_mask[f])
+              throw("Split operand field in a 16-bit instruction: "s + entry.source->data<opcode>());
+            uint32_t width = 0;
+            for(uint32_t bits = x.low_mask[f]; bits; bits &= bits - 1)
+              ++width;
+            uint32_t packed = x.low_shift[f] | (width << 4) | (x.sign_bit[f] ? 1u << 9 : 0);
+            layout |= packed << (10 * f);
+          }
+        }
+        rval.push_back(layout);
+      }
+      rval.push_back(0);
+      return rval;
+    }();
+    return layouts;
+  }
+
+  __attribute__((target("avx2")))
+  inline __m256i extract_field(__m256i words, __m256i packed)
+  {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i shift = _mm256_and_si256(packed, _mm256_set1_epi32(15));
+    const __m256i width = _mm256_and_si256(_mm256_srli_epi32(packed, 4), _mm256_set1_epi32(31));
+    const __m256i sign_flag = _mm256_and_si256(_mm256_srli_epi32(packed, 9), one);
+
+    __m256i raw = _mm256_and_si256(_mm256_srlv_epi32(words, shift),
+                                   _mm256_sub_epi32(_mm256_sllv_epi32(one, width), one));
+    __m256i sign = _mm256_and_si256(_mm256_sllv_epi32(one, _mm256_sub_epi32(width, one)),
+                                    _mm256_sub_epi32(_mm256_setzero_si256(), sign_flag));
+    return _mm256_sub_epi32(_mm256_xor_si256(raw, sign), sign);
+  }
+}
+
+__attribute__((target("avx2")))
+std::size_t decode_stream_avx2(const decode_table& table, const uint16_t* words,
+                               std::size_t count, decoded_stream& out)
+{
+  const std::vector<operand_extractor>& extractors = operand_extractors();
+  const std::vector<uint32_t>& layouts = simd_layouts();
+  const extract_function extract = select_operand_extractor();
+
+  const int* first_level = reinterpret_cast<const int*>(table.data());
+  const int* layout_data = reinterpret_cast<const int*>(layouts.data());
+
+  const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+  const __m256i flag = _mm256_set1_epi32(decode_table::extended_flag);
+  const __m256i invalid = _mm256_set1_epi32(invalid_instruction);
+  const __m256i last_layout = _mm256_set1_epi32(int(layouts.size() - 1));
+  const __m256i lane_offsets = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+
+  out.count = 0;
+  out.reserve(count);
+
+  std::size_t pos = 0;
+  while(pos + 16 <= count)
+  {
+    const __m256i w0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + pos)));
+    const __m256i w1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + pos + 8)));
+
+    const __m256i e0 = _mm256_and_si256(_mm256_i32gather_epi32(first_level, w0, 2), low16);
+    const __m256i e1 = _mm256_and_si256(_mm256_i32gather_epi32(first_level, w1, 2), low16);
+
+    const __m256i x0 = _mm256_andnot_si256(_mm256_cmpeq_epi32(e0, invalid),
+                                           _mm256_cmpeq_epi32(_mm256_and_si256(e0, flag), flag));
+    const __m256i x1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(e1, invalid),
+                                           _mm256_cmpeq_epi32(_mm256_and_si256(e1, flag), flag));
+
+    // lanes that start a 32-bit instruction.  the lanes before the first one are
+    // stored from the vector results, that instruction is decoded by the scalar path.
+    const unsigned extended = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(x0))) |
+                              unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(x1))) << 8;
+    const std::size_t valid = extended ? std::size_t(__builtin_ctz(extended)) : 16;
+
+    const std::size_t n = out.count;
+
+    const __m256i ids = _mm256_permute4x64_epi64(_mm256_packus_epi32(e0, e1), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.id.data() + n), ids);
+
+    const __m256i base = _mm256_add_epi32(_mm256_set1_epi32(int(pos * 2)), lane_offsets);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.offset.data() + n), base);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.offset.data() + n + 8),
+                        _mm256_add_epi32(base, _mm256_set1_epi32(16)));
+
+    const __m256i l0 = _mm256_i32gather_epi32(layout_data, _mm256_min_epu32(e0, last_layout), 4);
+    const __m256i l1 = _mm256_i32gather_epi32(layout_data, _mm256_min_epu32(e1, last_layout), 4);
+
+    for(std::size_t f = 0; f < simd_fields; ++f)
+    {
+      int32_t* values = out.field[f].data() + n;
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(values),     extract_field(w0, _mm256_srli_epi32(l0, int(10 * f))));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + 8), extract_field(w1, _mm256_srli_epi32(l1, int(10 * f))));
+    }
+    for(std::size_t f = simd_fields; f < max_operand_fields; ++f)
+    {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.field[f].data() + n), _mm256_setzero_si256());
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.field[f].data() + n + 8), _mm256_setzero_si256());
+    }
+
+    out.count += valid;
+    pos += valid;
+    if(extended)
+      pos += decode_one(table, extractors, extract, words, pos, count, out);
+  }
+
+  while(pos < count)
+    pos += decode_one(table, extractors, extract, words, pos, count, out);
+  return out.count;
+}
+
+stream_decode_function select_stream_decoder(void)
+{
+  static const stream_decode_function selected =
+      __builtin_cpu_supports("avx2") ? decode_stream_avx2 : decode_stream_scalar;
+  return selected;
+}
+#else
+std::size_t decode_stream_avx2(const decode_table& table, const uint16_t* words,
+                               std::size_t count, decoded_stream& out)
+{
+  return decode_stream_scalar(table, words, count, out);
+}
+
+stream_decode_function select_stream_decoder(void)
+{
+  return decode_stream_scalar;
+}
+#endif
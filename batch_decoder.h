@@ -0,0 +1,37 @@
+#ifndef BATCH_DECODER_H
+#define BATCH_DECODER_H
+
+#include "decode_table.h"
+#include "operand_extractor.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// structure of arrays output of the batch decoder, one element per instruction
+struct decoded_stream
+{
+  std::size_t count = 0;
+  std::vector<uint32_t> offset; // byte offset from the start of the input
+  std::vector<uint16_t> id;     // instruction id or invalid_instruction
+  std::array<std::vector<int32_t>, max_operand_fields> field; // see operand_extractor::letter
+
+  void reserve(std::size_t instructions);
+};
+
+// 'words' are instruction halfwords in host byte order
+typedef std::size_t (*stream_decode_function)(const decode_table& table, const uint16_t* words,
+                                              std::size_t count, decoded_stream& out);
+
+std::size_t decode_stream_scalar(const decode_table& table, const uint16_t* words,
+                                 std::size_t count, decoded_stream& out);
+
+// decodes 16 halfwords per step by gathering the first level table entries.
+// 32-bit instructions are handed to the scalar decoder.
+std::size_t decode_stream_avx2(const decode_table& table, const uint16_t* words,
+                               std::size_t count, decoded_stream& out);
+
+// AVX2 when the CPU has it, scalar otherwise
+stream_decode_function select_stream_decoder(void);
+
+#endif // BATCH_DECODER_H
@@ -0,0 +1,24 @@
+mov.l   @(16,pc),r1	! 0x00000014
+mov.l   @(20,pc),r2	! 0x00000018
+mov.w   @(20,pc),r3	! 0x0000001c
+mov.w   @(20,pc),r4	! 0x0000001e
+mova    @(12,pc),r0	! 0x00000018
+mova    @(8,pc),r0	! 0x00000014
+mov.l   @(8,pc),r5	! 0x00000018
+bra     0x00000020
+nop
+.word   0x0000
+mov.l   r3,@(16,r2)
+mov.l   @(32,r7),r6
+.word   0x0000
+.word   0x0000
+mov.l   r3,@(16,r2)
+mov.l   @(32,r7),r6
+mov.w   @(4,pc),r6	! 0x00000028
+mova    @(8,pc),r0	! 0x0000002c
+mov.l   @(4,pc),r7	! 0x0000002c
+sleep
+add     #-1,r15
+.word   0x0000
+.word   0x0000
+.word   0x0020
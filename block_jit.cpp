@@ -0,0 +1,1017 @@
+#include "block_jit.h"
+#include "operand_extractor.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) && defined(__linux__)
+# include <sys/mman.h>
+# include <unistd.h>
+# define SH_JIT 1
+#else
+# define SH_JIT 0
+#endif
+
+using namespace std::literals::string_literals;
+
+namespace
+{
+  // what an instruction of the subset does
+  enum class jit_op : uint8_t
+  {
+    none,
+    mov, add, addc, addv, sub, subc, subv, and_, or_, xor_, tst,
+    cmp_eq, cmp_ge, cmp_gt, cmp_hi, cmp_hs, cmp_str,
+    neg, negc, not_, exts_b, exts_w, extu_b, extu_w, swap_b, swap_w, xtrct,
+    mul_l, muls_w, mulu_w, dmuls_l, dmulu_l,
+    mov_imm, add_imm, and_imm, or_imm, xor_imm, tst_imm, cmp_eq_imm,
+    movt, dt, cmp_pl, cmp_pz, rotl, rotr, rotcl, rotcr, shal, shar, shll, shlr,
+    shll2, shll8, shll16, shlr2, shlr8, shlr16, div0u, mova,
+    load, store,
+    bf, bt, bf_s, bt_s, bra, bsr, braf, bsrf, jmp, jsr, rts,
+  };
+
+  enum class address_mode : uint8_t
+  {
+    none, indirect, post_increment, pre_decrement, displacement, indexed, gbr, pc
+  };
+
+  struct jit_form
+  {
+    jit_op op = jit_op::none;
+    uint8_t size = 0;     // bytes of a memory access
+    address_mode mode = address_mode::none;
+    char base = 0;        // register of the address: 'm', 'n' or '0' for R0
+    char value = 0;       // register of the data
+  };
+
+  bool is_branch(jit_op op) { return op >= jit_op::bf; }
+
+  // the formats without a memory operand
+  constexpr std::array<std::pair<std::string_view, jit_op>, 67> register_forms =
+  {{
+    { "mov rm,rn", jit_op::mov }, { "add rm,rn", jit_op::add }, { "addc rm,rn", jit_op::addc },
+    { "addv rm,rn", jit_op::addv }, { "sub rm,rn", jit_op::sub }, { "subc rm,rn", jit_op::subc },
+    { "subv rm,rn", jit_op::subv }, { "and rm,rn", jit_op::and_ }, { "or rm,rn", jit_op::or_ },
+    { "xor rm,rn", jit_op::xor_ }, { "tst rm,rn", jit_op::tst }, { "cmp/eq rm,rn", jit_op::cmp_eq },
+    { "cmp/ge rm,rn", jit_op::cmp_ge }, { "cmp/gt rm,rn", jit_op::cmp_gt }, { "cmp/hi rm,rn", jit_op::cmp_hi },
+    { "cmp/hs rm,rn", jit_op::cmp_hs }, { "cmp/str rm,rn", jit_op::cmp_str }, { "neg rm,rn", jit_op::neg },
+    { "negc rm,rn", jit_op::negc }, { "not rm,rn", jit_op::not_ }, { "exts.b rm,rn", jit_op::exts_b },
+    { "exts.w rm,rn", jit_op::exts_w }, { "extu.b rm,rn", jit_op::extu_b }, { "extu.w rm,rn", jit_op::extu_w },
+    { "swap.b rm,rn", jit_op::swap_b }, { "swap.w rm,rn", jit_op::swap_w }, { "xtrct rm,rn", jit_op::xtrct },
+    { "mul.l rm,rn", jit_op::mul_l }, { "muls.w rm,rn", jit_op::muls_w }, { "mulu.w rm,rn", jit_op::mulu_w },
+    { "dmuls.l rm,rn", jit_op::dmuls_l }, { "dmulu.l rm,rn", jit_op::dmulu_l },
+    { "mov #imm,rn", jit_op::mov_imm }, { "add #imm,rn", jit_op::add_imm }, { "and #imm,r0", jit_op::and_imm },
+    { "or #imm,r0", jit_op::or_imm }, { "xor #imm,r0", jit_op::xor_imm }, { "tst #imm,r0", jit_op::tst_imm },
+    { "cmp/eq #imm,r0", jit_op::cmp_eq_imm },
+    { "movt rn", jit_op::movt }, { "dt rn", jit_op::dt }, { "cmp/pl rn", jit_op::cmp_pl },
+    { "cmp/pz rn", jit_op::cmp_pz }, { "rotl rn", jit_op::rotl }, { "rotr rn", jit_op::rotr },
+    { "rotcl rn", jit_op::rotcl }, { "rotcr rn", jit_op::rotcr }, { "shal rn", jit_op::shal },
+    { "shar rn", jit_op::shar }, { "shll rn", jit_op::shll }, { "shlr rn", jit_op::shlr },
+    { "shll2 rn", jit_op::shll2 }, { "shll8 rn", jit_op::shll8 }, { "shll16 rn", jit_op::shll16 },
+    { "shlr2 rn", jit_op::shlr2 }, { "shlr8 rn", jit_op::shlr8 }, { "shlr16 rn", jit_op::shlr16 },
+    { "div0u", jit_op::div0u }, { "mova @(disp,pc),r0", jit_op::mova },
+    { "bf label", jit_op::bf }, { "bt label", jit_op::bt }, { "bf/s label", jit_op::bf_s },
+    { "bt/s label", jit_op::bt_s }, { "bra label", jit_op::bra }, { "bsr label", jit_op::bsr },
+    { "braf rm", jit_op::braf }, { "bsrf rm", jit_op::bsrf },
+  }};
+
+  constexpr std::array<std::pair<std::string_view, jit_op>, 3> jump_forms =
+  {{
+    { "jmp @rm", jit_op::jmp }, { "jsr @rm", jit_op::jsr }, { "rts", jit_op::rts },
+  }};
+
+  // "rm", "rn", "r0" as the letter of the register field
+  char register_letter(std::string_view text)
+  {
+    return text == "rm" ? 'm' : text == "rn" ? 'n' : text == "r0" ? '0' : 0;
+  }
+
+  // mov.b, mov.w and mov.l with one register and one memory operand
+  jit_form memory_form(std::string_view mnemonic, std::string_view operands)
+  {
+    jit_form rval;
+    if(mnemonic.size() != 5 || mnemonic.substr(0, 4) != "mov.")
+      return rval;
+    const uint8_t size = mnemonic[4] == 'b' ? 1 : mnemonic[4] == 'w' ? 2 : mnemonic[4] == 'l' ? 4 : 0;
+
+    // the comma between the operands is outside of the parentheses
+    const std::size_t close = operands.find(')');
+    const std::size_t comma = operands.find(',', close == std::string_view::npos ? 0 : close);
+    if(!size || comma == std::string_view::npos)
+      return rval;
+    std::string_view source = operands.substr(0, comma);
+    std::string_view target = operands.substr(comma + 1);
+    const bool load = !source.empty() && source[0] == '@';
+    std::string_view memory = load ? source : target;
+    const char value = register_letter(load ? target : source);
+    if(!value || memory.empty() || memory[0] != '@')
+      return rval;
+    memory.remove_prefix(1);
+
+    if(memory.size() > 2 && memory[0] == '(' && memory.back() == ')')
+    {
+      const std::string_view inner = memory.substr(1, memory.size() - 2);
+      if(inner == "disp,gbr")
+        rval.mode = address_mode::gbr;
+      else if(inner == "disp,pc")
+        rval.mode = address_mode::pc;
+      else if(inner.substr(0, 5) == "disp," && register_letter(inner.substr(5)))
+      {
+        rval.mode = address_mode::displacement;
+        rval.base = register_letter(inner.substr(5));
+      }
+      else if(inner.substr(0, 3) == "r0," && register_letter(inner.substr(3)))
+      {
+        rval.mode = address_mode::indexed;
+        rval.base = register_letter(inner.substr(3));
+      }
+    }
+    else if(!memory.empty() && memory.back() == '+' && register_letter(memory.substr(0, memory.size() - 1)))
+    {
+      rval.mode = address_mode::post_increment;
+      rval.base = register_letter(memory.substr(0, memory.size() - 1));
+    }
+    else if(!memory.empty() && memory[0] == '-' && register_letter(memory.substr(1)))
+    {
+      rval.mode = address_mode::pre_decrement;
+      rval.base = register_letter(memory.substr(1));
+    }
+    else if(register_letter(memory))
+    {
+      rval.mode = address_mode::indirect;
+      rval.base = register_letter(memory);
+    }
+
+    if(rval.mode != address_mode::none)
+    {
+      rval.op = load ? jit_op::load : jit_op::store;
+      rval.size = size;
+      rval.value = value;
+    }
+    return rval;
+  }
+
+  // the translation of the format of an SH1 or SH2 instruction of the
+  // integer sections, none for anything else
+  jit_form form_of(const instruction_entry& entry)
+  {
+    static constexpr std::array<std::string_view, 5> sections =
+    {
+      "Data Transfer Instructions", "Arithmetic Operation Instructions", "Logic Operation Instructions",
+      "Shift Instructions", "Branch Instructions",
+    };
+    if(!entry.source->for_isa(SH1 | SH2) ||
+       std::find(sections.begin(), sections.end(), std::string_view(entry.section->section_title)) == sections.end())
+      return {};
+
+    // lowercase with single spaces, as the keys of instruction_names.h
+    std::string text;
+    for(char c : std::string(entry.source->data<format>()))
+      if(std::isspace(uint8_t(c)))
+      {
+        if(!text.empty() && text.back() != ' ')
+          text += ' ';
+      }
+      else
+        text += char(std::tolower(uint8_t(c)));
+    while(!text.empty() && text.back() == ' ')
+      text.pop_back();
+
+    jit_form rval;
+    for(const auto& f : register_forms)
+      if(f.first == text)
+        rval.op = f.second;
+    for(const auto& f : jump_forms)
+      if(f.first == text)
+        rval.op = f.second;
+    if(rval.op != jit_op::none)
+      return rval;
+
+    const std::size_t space = text.find(' ');
+    if(space == std::string::npos)
+      return rval;
+    return memory_form(std::string_view(text).substr(0, space), std::string_view(text).substr(space + 1));
+  }
+
+  const std::vector<jit_form>& jit_forms(void)
+  {
+    static const std::vector<jit_form> forms = []
+    {
+      std::vector<jit_form> rval;
+      for(const instruction_entry& entry : instruction_entries())
+        rval.push_back(form_of(entry));
+      return rval;
+    }();
+    return forms;
+  }
+
+  // ----------------------------------------------------------------------------
+  // x86-64 encoding
+
+  enum host_register : int
+  {
+    rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15
+  };
+
+  enum condition : uint8_t
+  {
+    cc_o = 0x0, cc_b = 0x2, cc_ae = 0x3, cc_e = 0x4, cc_ne = 0x5, cc_a = 0x7, cc_ge = 0xD, cc_g = 0xF
+  };
+
+  // a register, or memory at [base + index + disp]
+  struct x64_operand
+  {
+    int reg = -1;
+    int base = -1;
+    int index = -1;
+    int32_t disp = 0;
+  };
+
+  x64_operand in(int reg) { return { reg, -1, -1, 0 }; }
+  x64_operand at(int base, int32_t disp) { return { -1, base, -1, disp }; }
+  x64_operand at(int base, int index, int32_t disp) { return { -1, base, index, disp }; }
+
+  class x64_writer
+  {
+  public:
+    x64_writer(uint8_t* start, std::size_t size) : first(start), cursor(start), last(start + size) { }
+
+    std::size_t size(void) const { return std::size_t(cursor - first); }
+    bool overflowed(void) const { return overflow; }
+
+    void byte(uint8_t b)
+    {
+      if(cursor < last)
+        *cursor++ = b;
+      else
+        overflow = true;
+    }
+    void dword(uint32_t value)
+    {
+      for(int n = 0; n < 4; ++n)
+        byte(uint8_t(value >> (8 * n)));
+    }
+
+    // [66] [REX] opcode ModRM [SIB] [disp] for 'reg' (or the /digit) and 'rm'
+    void op(std::initializer_list<uint8_t> opcode, int reg, const x64_operand& rm, bool wide = false,
+            bool word = false)
+    {
+      if(word)
+        byte(0x66);
+      const int b = rm.reg >= 0 ? rm.reg : rm.base;
+      const uint8_t rex = uint8_t(0x40 | (wide ? 8 : 0) | (reg & 8 ? 4 : 0) | (rm.index >= 0 && (rm.index & 8) ? 2 : 0) |
+                                  (b & 8 ? 1 : 0));
+      if(rex != 0x40)
+        byte(rex);
+      for(uint8_t o : opcode)
+        byte(o);
+
+      const uint8_t r = uint8_t((reg & 7) << 3);
+      if(rm.reg >= 0)
+      {
+        byte(0xC0 | r | (rm.reg & 7));
+        return;
+      }
+      const bool short_disp = rm.disp >= -128 && rm.disp < 128;
+      const uint8_t mod = rm.disp == 0 && (rm.base & 7) != rbp ? 0x00 : short_disp ? 0x40 : 0x80;
+      if(rm.index >= 0)
+      {
+        byte(mod | r | 4);
+        byte(uint8_t((rm.index & 7) << 3 | (rm.base & 7)));
+      }
+      else
+      {
+        byte(mod | r | (rm.base & 7));
+        if((rm.base & 7) == rsp)
+          byte(0x24);
+      }
+      if(mod == 0x40)
+        byte(uint8_t(rm.disp));
+      else if(mod == 0x80)
+        dword(uint32_t(rm.disp));
+    }
+
+    void mov_imm(int reg, uint32_t value)
+    {
+      if(reg & 8)
+        byte(0x41);
+      byte(uint8_t(0xB8 | (reg & 7)));
+      dword(value);
+    }
+    void mov_imm64(int reg, uint64_t value)
+    {
+      byte(uint8_t(0x48 | (reg & 8 ? 1 : 0)));
+      byte(uint8_t(0xB8 | (reg & 7)));
+      dword(uint32_t(value));
+      dword(uint32_t(value >> 32));
+    }
+    void push(int reg)
+    {
+      if(reg & 8)
+        byte(0x41);
+      byte(uint8_t(0x50 | (reg & 7)));
+    }
+    void pop(int reg)
+    {
+      if(reg & 8)
+        byte(0x41);
+      byte(uint8_t(0x58 | (reg & 7)));
+    }
+    void bswap(int reg)
+    {
+      if(reg & 8)
+        byte(0x41);
+      byte(0x0F);
+      byte(uint8_t(0xC8 | (reg & 7)));
+    }
+    void setcc(condition cc, int reg) { op({ 0x0F, uint8_t(0x90 | cc) }, 0, in(reg)); }
+
+    // rel32 jumps, patched later through the returned position
+    std::size_t jcc(condition cc)
+    {
+      byte(0x0F);
+      byte(uint8_t(0x80 | cc));
+      dword(0);
+      return size() - 4;
+    }
+    std::size_t jmp(void)
+    {
+      byte(0xE9);
+      dword(0);
+      return size() - 4;
+    }
+    void patch(std::size_t at, std::size_t target)
+    {
+      const uint32_t rel = uint32_t(int32_t(target) - int32_t(at + 4));
+      if(at + 4 <= std::size_t(last - first))
+        for(int n = 0; n < 4; ++n)
+          first[at + n] = uint8_t(rel >> (8 * n));
+    }
+
+  private:
+    uint8_t* first;
+    uint8_t* cursor;
+    uint8_t* last;
+    bool overflow = false;
+  };
+
+  // ----------------------------------------------------------------------------
+
+  // rbx holds the registers, r12 the guest memory and r11 SR; the guest
+  // registers used most in the block take the rest, rax, rcx and rdx are
+  // scratch.  nothing is called, so the caller saved registers are free.
+  constexpr int state_register = rbx;
+  constexpr int memory_register = r12;
+  constexpr int sr_register = r11;
+  constexpr std::array<int, 9> guest_hosts = { rbp, rsi, rdi, r8, r9, r10, r13, r14, r15 };
+  constexpr std::array<int, 6> saved_hosts = { rbx, rbp, r12, r13, r14, r15 };
+
+  constexpr int32_t offset_of_R(int n) { return int32_t(offsetof(cpu_state, R) + 4 * std::size_t(n)); }
+  constexpr int32_t offset_of_PC = int32_t(offsetof(cpu_state, PC));
+  constexpr int32_t offset_of_PR = int32_t(offsetof(cpu_state, PR));
+  constexpr int32_t offset_of_SR = int32_t(offsetof(cpu_state, SR));
+  constexpr int32_t offset_of_GBR = int32_t(offsetof(cpu_state, GBR));
+  constexpr int32_t offset_of_MACH = int32_t(offsetof(cpu_state, MACH));
+  constexpr int32_t offset_of_MACL = int32_t(offsetof(cpu_state, MACL));
+
+  // the value of operand field 'letter', sign extended where the database
+  // says so
+  int32_t field(const jit_instruction& i, char letter)
+  {
+    const operand_extractor& extractor = operand_extractors()[i.id];
+    for(std::size_t k = 0; k < extractor.count; ++k)
+      if(extractor.letter[k] == letter)
+      {
+        const uint32_t raw = extract_bits(i.word, extractor.field_mask[k]);
+        return int32_t((raw ^ extractor.sign_bit[k]) - extractor.sign_bit[k]);
+      }
+    return 0;
+  }
+
+  // guest register of an operand letter
+  int guest_register(const jit_instruction& i, char letter)
+  {
+    return letter == '0' ? 0 : field(i, letter);
+  }
+
+  class translator
+  {
+  public:
+    translator(x64_writer& writer, const jit_memory& memory) : out(writer), mem(memory)
+    {
+      host.fill(-1);
+    }
+
+    void allocate(const std::vector<jit_instruction>& code, std::size_t count, const jit_instruction* slot);
+    void prologue(void);
+    void instruction(const jit_instruction& i, uint32_t index, uint32_t bail_address);
+    void finish(uint32_t next_pc, uint32_t completed);
+
+  private:
+    x64_operand guest(int n) const { return host[n] >= 0 ? in(host[n]) : at(state_register, offset_of_R(n)); }
+
+    void load(int reg, int n)
+    {
+      if(host[n] != reg)
+        out.op({ 0x8B }, reg, guest(n));
+    }
+    void store(int n, int reg)
+    {
+      if(host[n] != reg)
+        out.op({ 0x89 }, reg, guest(n));
+    }
+    // a register holding guest register 'n', 'scratch' if it is not mapped
+    int source(int n, int scratch)
+    {
+      if(host[n] >= 0)
+        return host[n];
+      load(scratch, n);
+      return scratch;
+    }
+
+    void set_t(condition cc);
+    void carry_from_t(void) { out.op({ 0x0F, 0xBA }, 4, in(sr_register)); out.byte(0); }
+    void bail(condition cc) { bails.push_back({ out.jcc(cc), current }); }
+    void check_access(uint8_t size);
+    void read(uint8_t size);
+    void write(uint8_t size);
+    void memory_access(const jit_instruction& i, const jit_form& f);
+    void branch(const jit_instruction& i, const jit_form& f);
+
+    struct bail_site
+    {
+      std::size_t jump;
+      uint32_t index;
+    };
+
+    x64_writer& out;
+    jit_memory mem;
+    std::array<int, 16> host;
+    std::vector<bail_site> bails;
+    std::vector<std::pair<uint32_t, uint32_t>> bail_pcs; // of each instruction index
+    uint32_t current = 0;
+  };
+
+  // the nine most used guest registers get a host register
+  void translator::allocate(const std::vector<jit_instruction>& code, std::size_t count, const jit_instruction* slot)
+  {
+    std::array<int, 16> uses = {};
+    auto count_uses = [&](const jit_instruction& i)
+    {
+      const operand_extractor& extractor = operand_extractors()[i.id];
+      for(std::size_t k = 0; k < extractor.count; ++k)
+        if(extractor.letter[k] == 'm' || extractor.letter[k] == 'n')
+          ++uses[extract_bits(i.word, extractor.field_mask[k]) & 15];
+      const jit_form& f = jit_forms()[i.id];
+      if(f.base == '0' || f.value == '0' || f.mode == address_mode::indexed || f.op == jit_op::mova ||
+         (f.op >= jit_op::and_imm && f.op <= jit_op::cmp_eq_imm))
+        ++uses[0];
+    };
+    for(std::size_t n = 0; n < count; ++n)
+      count_uses(code[n]);
+    if(slot)
+      count_uses(*slot);
+
+    std::array<int, 16> order;
+    for(int n = 0; n < 16; ++n)
+      order[n] = n;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return uses[a] > uses[b]; });
+    for(std::size_t k = 0; k < guest_hosts.size() && uses[order[k]]; ++k)
+      host[order[k]] = guest_hosts[k];
+  }
+
+  void translator::prologue(void)
+  {
+    for(int reg : saved_hosts)
+      out.push(reg);
+    out.op({ 0x89 }, rdi, in(state_register), true);
+    out.mov_imm64(memory_register, uint64_t(reinterpret_cast<uintptr_t>(mem.data)));
+    out.op({ 0x8B }, sr_register, at(state_register, offset_of_SR));
+    for(int n = 0; n < 16; ++n)
+      if(host[n] >= 0)
+        out.op({ 0x8B }, host[n], at(state_register, offset_of_R(n)));
+  }
+
+  void translator::set_t(condition cc)
+  {
+    out.setcc(cc, rax);
+    out.op({ 0x0F, 0xB6 }, rax, in(rax));                 // movzx eax, al
+    out.op({ 0x83 }, 4, in(sr_register)); out.byte(0xFE); // and r11d, ~1
+    out.op({ 0x09 }, rax, in(sr_register));               // or r11d, eax
+  }
+
+  // the guest address in eax becomes the offset in the memory block in rdx,
+  // or the block is left at the instruction as the interpreter would fault
+  void translator::check_access(uint8_t size)
+  {
+    out.op({ 0x8B }, rdx, in(rax));
+    out.op({ 0x81 }, 4, in(rdx)); out.dword(0x1FFFFFFF);
+    out.op({ 0x81 }, 5, in(rdx)); out.dword(mem.base);
+    out.op({ 0x81 }, 7, in(rdx)); out.dword(mem.size - size);
+    bail(cc_a);
+    if(size > 1)
+    {
+      out.op({ 0xF7 }, 0, in(rax)); out.dword(size - 1u);
+      bail(cc_ne);
+    }
+  }
+
+  // from the address in eax, sign extended into eax
+  void translator::read(uint8_t size)
+  {
+    check_access(size);
+    const x64_operand bytes = at(memory_register, rdx, 0);
+    if(size == 1)
+      out.op({ 0x0F, 0xBE }, rax, bytes);
+    else if(size == 2)
+    {
+      out.op({ 0x0F, 0xB7 }, rax, bytes);
+      out.op({ 0xC1 }, 0, in(rax), false, true); out.byte(8);
+      out.op({ 0x0F, 0xBF }, rax, in(rax));
+    }
+    else
+    {
+      out.op({ 0x8B }, rax, bytes);
+      out.bswap(rax);
+    }
+  }
+
+  // ecx to the address in eax, then the check of the map of translated code
+  void translator::write(uint8_t size)
+  {
+    check_access(size);
+    const x64_operand bytes = at(memory_register, rdx, 0);
+    if(size == 1)
+      out.op({ 0x88 }, rcx, bytes);
+    else if(size == 2)
+    {
+      out.op({ 0xC1 }, 0, in(rcx), false, true); out.byte(8);
+      out.op({ 0x89 }, rcx, bytes, false, true);
+    }
+    else
+    {
+      out.bswap(rcx);
+      out.op({ 0x89 }, rcx, bytes);
+    }
+
+    out.op({ 0xC1 }, 5, in(rdx)); out.byte(uint8_t(mem.code_granule_bits));
+    out.mov_imm64(rax, uint64_t(reinterpret_cast<uintptr_t>(mem.code_map)));
+    out.op({ 0x80 }, 7, at(rax, rdx, 0)); out.byte(0);
+    out.byte(0x74); // je over the next two instructions
+    out.byte(13);
+    out.mov_imm64(rax, uint64_t(reinterpret_cast<uintptr_t>(mem.code_written)));
+    out.op({ 0xC6 }, 0, at(rax, 0)); out.byte(1);
+  }
+
+  void translator::memory_access(const jit_instruction& i, const jit_form& f)
+  {
+    const int base = f.base ? guest_register(i, f.base) : -1;
+    const int value = guest_register(i, f.value);
+    const displacement_info disp = displacement_of(*instruction_entries()[i.id].source);
+    const int32_t d = field(i, 'd');
+
+    switch(f.mode)
+    {
+      case address_mode::indirect:
+      case address_mode::post_increment:
+        load(rax, base);
+        break;
+      case address_mode::pre_decrement:
+        load(rax, base);
+        out.op({ 0x83 }, 5, in(rax)); out.byte(f.size);
+        break;
+      case address_mode::displacement:
+        load(rax, base);
+        out.op({ 0x81 }, 0, in(rax)); out.dword(uint32_t(d * disp.scale));
+        break;
+      case address_mode::indexed:
+        load(rax, base);
+        out.op({ 0x03 }, rax, guest(0));
+        break;
+      case address_mode::gbr:
+        out.op({ 0x8B }, rax, at(state_register, offset_of_GBR));
+        out.op({ 0x81 }, 0, in(rax)); out.dword(uint32_t(d * disp.scale));
+        break;
+      case address_mode::pc:
+        out.mov_imm(rax, disp.target(i.address, d));
+        break;
+      case address_mode::none:
+        break;
+    }
+
+    if(f.op == jit_op::load)
+    {
+      read(f.size);
+      if(f.mode == address_mode::post_increment && base != value)
+      {
+        out.op({ 0x83 }, 0, guest(base)); out.byte(f.size);
+      }
+      store(value, rax);
+    }
+    else
+    {
+      load(rcx, value);
+      write(f.size);
+      if(f.mode == address_mode::pre_decrement)
+      {
+        out.op({ 0x83 }, 5, guest(base)); out.byte(f.size);
+      }
+      else if(f.mode == address_mode::post_increment)
+      {
+        out.op({ 0x83 }, 0, guest(base)); out.byte(f.size);
+      }
+    }
+  }
+
+  // the PC (and PR) as the snippets set them before their delay slot
+  void translator::branch(const jit_instruction& i, const jit_form& f)
+  {
+    const displacement_info disp = displacement_of(*instruction_entries()[i.id].source);
+    const uint32_t target = disp.target(i.address, field(i, 'd'));
+    const x64_operand pc = at(state_register, offset_of_PC);
+    const x64_operand pr = at(state_register, offset_of_PR);
+
+    switch(f.op)
+    {
+      case jit_op::bf: case jit_op::bt: case jit_op::bf_s: case jit_op::bt_s:
+      {
+        const bool delayed = f.op == jit_op::bf_s || f.op == jit_op::bt_s;
+        const bool on_true = f.op == jit_op::bt || f.op == jit_op::bt_s;
+        out.mov_imm(rax, target);
+        out.mov_imm(rcx, i.address + (delayed ? 4 : 2));
+        out.op({ 0xF7 }, 0, in(sr_register)); out.dword(1);
+        out.op({ 0x0F, uint8_t(0x40 | (on_true ? cc_e : cc_ne)) }, rax, in(rcx)); // cmov
+        out.op({ 0x89 }, rax, pc);
+        break;
+      }
+      case jit_op::bsr:
+        out.op({ 0xC7 }, 0, pr); out.dword(i.address + 4);
+        // fall through
+      case jit_op::bra:
+        out.op({ 0xC7 }, 0, pc); out.dword(target);
+        break;
+      case jit_op::bsrf:
+        out.op({ 0xC7 }, 0, pr); out.dword(i.address + 4);
+        // fall through
+      case jit_op::braf:
+        load(rax, field(i, 'm'));
+        out.op({ 0x81 }, 0, in(rax)); out.dword(i.address + 4);
+        out.op({ 0x89 }, rax, pc);
+        break;
+      case jit_op::jsr:
+        out.op({ 0xC7 }, 0, pr); out.dword(i.address + 4);
+        // fall through
+      case jit_op::jmp:
+        load(rax, field(i, 'm'));
+        out.op({ 0x89 }, rax, pc);
+        break;
+      case jit_op::rts:
+        out.op({ 0x8B }, rax, pr);
+        out.op({ 0x89 }, rax, pc);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // 'index' and 'bail_address' are where a fault leaves the block: the
+  // instruction itself, or the branch of a delay slot
+  void translator::instruction(const jit_instruction& i, uint32_t index, uint32_t bail_address)
+  {
+    current = index;
+    if(bail_pcs.empty() || bail_pcs.back().first != index)
+      bail_pcs.push_back({ index, bail_address });
+
+    const jit_form& f = jit_forms()[i.id];
+    if(f.op == jit_op::load || f.op == jit_op::store)
+    {
+      memory_access(i, f);
+      return;
+    }
+    if(is_branch(f.op))
+    {
+      branch(i, f);
+      return;
+    }
+
+    const int n = guest_register(i, 'n');
+    const int m = guest_register(i, 'm');
+    const int32_t imm = field(i, 'i');
+    auto binary = [&](uint8_t opcode) { out.op({ opcode }, source(m, rcx), guest(n)); };
+    auto with_imm = [&](uint8_t digit, int reg) { out.op({ 0x81 }, digit, guest(reg)); out.dword(uint32_t(imm)); };
+    auto shift = [&](uint8_t digit) { out.op({ 0xD1 }, digit, guest(n)); };
+    auto shift_by = [&](uint8_t digit, uint8_t count) { out.op({ 0xC1 }, digit, guest(n)); out.byte(count); };
+    auto unary = [&](std::initializer_list<uint8_t> opcode, int digit)
+    {
+      load(rax, m);
+      out.op(opcode, digit, in(rax));
+      store(n, rax);
+    };
+
+    switch(f.op)
+    {
+      case jit_op::mov:
+        load(rax, m);
+        store(n, rax);
+        break;
+      case jit_op::add:  binary(0x01); break;
+      case jit_op::sub:  binary(0x29); break;
+      case jit_op::and_: binary(0x21); break;
+      case jit_op::or_:  binary(0x09); break;
+      case jit_op::xor_: binary(0x31); break;
+      case jit_op::addv: binary(0x01); set_t(cc_o); break;
+      case jit_op::subv: binary(0x29); set_t(cc_o); break;
+      case jit_op::addc: case jit_op::subc:
+      {
+        const int reg = source(m, rcx);
+        carry_from_t();
+        out.op({ uint8_t(f.op == jit_op::addc ? 0x11 : 0x19) }, reg, guest(n)); // adc, sbb
+        set_t(cc_b);
+        break;
+      }
+      case jit_op::negc:
+        load(rcx, m);
+        out.op({ 0x31 }, rax, in(rax));
+        carry_from_t();
+        out.op({ 0x19 }, rcx, in(rax));
+        store(n, rax);
+        set_t(cc_b);
+        break;
+      case jit_op::tst:    out.op({ 0x85 }, source(m, rcx), guest(n)); set_t(cc_e); break;
+      case jit_op::cmp_eq: binary(0x39); set_t(cc_e); break;
+      case jit_op::cmp_ge: binary(0x39); set_t(cc_ge); break;
+      case jit_op::cmp_gt: binary(0x39); set_t(cc_g); break;
+      case jit_op::cmp_hi: binary(0x39); set_t(cc_a); break;
+      case jit_op::cmp_hs: binary(0x39); set_t(cc_ae); break;
+      case jit_op::cmp_str:
+        // a zero byte in Rn ^ Rm
+        load(rax, n);
+        out.op({ 0x33 }, rax, guest(m));
+        out.op({ 0x8D }, rdx, at(rax, -0x01010101)); // lea edx, [rax - 0x01010101]
+        out.op({ 0xF7 }, 2, in(rax));
+        out.op({ 0x21 }, rax, in(rdx));
+        out.op({ 0x81 }, 4, in(rdx)); out.dword(0x80808080);
+        set_t(cc_ne);
+        break;
+      case jit_op::neg:    unary({ 0xF7 }, 3); break;
+      case jit_op::not_:   unary({ 0xF7 }, 2); break;
+      case jit_op::exts_b: load(rax, m); out.op({ 0x0F, 0xBE }, rax, in(rax)); store(n, rax); break;
+      case jit_op::exts_w: load(rax, m); out.op({ 0x0F, 0xBF }, rax, in(rax)); store(n, rax); break;
+      case jit_op::extu_b: load(rax, m); out.op({ 0x0F, 0xB6 }, rax, in(rax)); store(n, rax); break;
+      case jit_op::extu_w: load(rax, m); out.op({ 0x0F, 0xB7 }, rax, in(rax)); store(n, rax); break;
+      case jit_op::swap_b:
+        load(rax, m);
+        out.op({ 0xC1 }, 0, in(rax), false, true); out.byte(8);
+        store(n, rax);
+        break;
+      case jit_op::swap_w:
+        load(rax, m);
+        out.op({ 0xC1 }, 0, in(rax)); out.byte(16);
+        store(n, rax);
+        break;
+      case jit_op::xtrct:
+        load(rax, n);
+        out.op({ 0xC1 }, 5, in(rax)); out.byte(16);
+        load(rcx, m);
+        out.op({ 0xC1 }, 4, in(rcx)); out.byte(16);
+        out.op({ 0x09 }, rcx, in(rax));
+        store(n, rax);
+        break;
+      case jit_op::mul_l: case jit_op::muls_w: case jit_op::mulu_w:
+      {
+        const uint8_t extend = f.op == jit_op::muls_w ? 0xBF : 0xB7;
+        load(rax, n);
+        load(rcx, m);
+        if(f.op != jit_op::mul_l)
+        {
+          out.op({ 0x0F, extend }, rax, in(rax));
+          out.op({ 0x0F, extend }, rcx, in(rcx));
+        }
+        out.op({ 0x0F, 0xAF }, rax, in(rcx));
+        out.op({ 0x89 }, rax, at(state_register, offset_of_MACL));
+        break;
+      }
+      case jit_op::dmuls_l: case jit_op::dmulu_l:
+        load(rax, n);
+        load(rcx, m);
+        out.op({ 0xF7 }, f.op == jit_op::dmuls_l ? 5 : 4, in(rcx));
+        out.op({ 0x89 }, rdx, at(state_register, offset_of_MACH));
+        out.op({ 0x89 }, rax, at(state_register, offset_of_MACL));
+        break;
+      case jit_op::mov_imm:    out.op({ 0xC7 }, 0, guest(n)); out.dword(uint32_t(imm)); break;
+      case jit_op::add_imm:    with_imm(0, n); break;
+      case jit_op::and_imm:    with_imm(4, 0); break;
+      case jit_op::or_imm:     with_imm(1, 0); break;
+      case jit_op::xor_imm:    with_imm(6, 0); break;
+      case jit_op::tst_imm:    out.op({ 0xF7 }, 0, guest(0)); out.dword(uint32_t(imm)); set_t(cc_e); break;
+      case jit_op::cmp_eq_imm: with_imm(7, 0); set_t(cc_e); break;
+      case jit_op::movt:
+        out.op({ 0x8B }, rax, in(sr_register));
+        out.op({ 0x83 }, 4, in(rax)); out.byte(1);
+        store(n, rax);
+        break;
+      case jit_op::dt:     out.op({ 0x83 }, 5, guest(n)); out.byte(1); set_t(cc_e); break;
+      case jit_op::cmp_pl: out.op({ 0x83 }, 7, guest(n)); out.byte(0); set_t(cc_g); break;
+      case jit_op::cmp_pz: out.op({ 0x83 }, 7, guest(n)); out.byte(0); set_t(cc_ge); break;
+      case jit_op::rotl:   shift(0); set_t(cc_b); break;
+      case jit_op::rotr:   shift(1); set_t(cc_b); break;
+      case jit_op::rotcl:  carry_from_t(); shift(2); set_t(cc_b); break;
+      case jit_op::rotcr:  carry_from_t(); shift(3); set_t(cc_b); break;
+      case jit_op::shal: case jit_op::shll: shift(4); set_t(cc_b); break;
+      case jit_op::shlr:   shift(5); set_t(cc_b); break;
+      case jit_op::shar:   shift(7); set_t(cc_b); break;
+      case jit_op::shll2:  shift_by(4, 2); break;
+      case jit_op::shll8:  shift_by(4, 8); break;
+      case jit_op::shll16: shift_by(4, 16); break;
+      case jit_op::shlr2:  shift_by(5, 2); break;
+      case jit_op::shlr8:  shift_by(5, 8); break;
+      case jit_op::shlr16: shift_by(5, 16); break;
+      case jit_op::div0u:  out.op({ 0x81 }, 4, in(sr_register)); out.dword(~uint32_t(0x301)); break; // T, Q, M
+      case jit_op::mova:
+      {
+        const displacement_info disp = displacement_of(*instruction_entries()[i.id].source);
+        out.op({ 0xC7 }, 0, guest(0)); out.dword(disp.target(i.address, field(i, 'd')));
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  // the PC after the last instruction (unless a branch has set it), then the
+  // exit that writes the registers back, and the faults that jump to it
+  void translator::finish(uint32_t next_pc, uint32_t completed)
+  {
+    if(next_pc != ~uint32_t(0))
+    {
+      out.op({ 0xC7 }, 0, at(state_register, offset_of_PC));
+      out.dword(next_pc);
+    }
+    out.mov_imm(rax, completed);
+
+    const std::size_t exit = out.size();
+    out.op({ 0x89 }, sr_register, at(state_register, offset_of_SR));
+    for(int n = 0; n < 16; ++n)
+      if(host[n] >= 0)
+        out.op({ 0x89 }, host[n], at(state_register, offset_of_R(n)));
+    for(auto reg = saved_hosts.rbegin(); reg != saved_hosts.rend(); ++reg)
+      out.pop(*reg);
+    out.byte(0xC3);
+
+    for(const auto& [index, address] : bail_pcs)
+    {
+      const std::size_t stub = out.size();
+      bool used = false;
+      for(const bail_site& b : bails)
+        if(b.index == index)
+        {
+          out.patch(b.jump, stub);
+          used = true;
+        }
+      if(!used)
+        continue;
+      out.op({ 0xC7 }, 0, at(state_register, offset_of_PC));
+      out.dword(address);
+      out.mov_imm(rax, index);
+      out.patch(out.jmp(), exit);
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+#if SH_JIT
+namespace
+{
+  // sets the protection of the pages over bytes 'from' to 'to' of 'code'
+  bool protect(uint8_t* code, std::size_t from, std::size_t to, int protection)
+  {
+    const std::size_t page = std::size_t(::sysconf(_SC_PAGESIZE));
+    from &= ~(page - 1);
+    to = (to + page - 1) & ~(page - 1);
+    return ::mprotect(code + from, to - from, protection) == 0;
+  }
+}
+#endif
+
+// the code area is never writable and executable at once: the pages of the
+// translations are executable, the rest writable, and the page that the next
+// translation starts on is writable while it is written.
+block_jit::block_jit(const jit_memory& memory, std::size_t code_size)
+  : mem(memory)
+{
+#if SH_JIT
+  void* area = ::mmap(nullptr, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(area == MAP_FAILED)
+    return;
+  // a system that does not let written pages run code has no jit
+  if(!protect(static_cast<uint8_t*>(area), 0, code_size, PROT_READ | PROT_EXEC) ||
+     !protect(static_cast<uint8_t*>(area), 0, code_size, PROT_READ | PROT_WRITE))
+  {
+    ::munmap(area, code_size);
+    return;
+  }
+  code = static_cast<uint8_t*>(area);
+  capacity = code_size;
+#else
+  (void)code_size;
+#endif
+}
+
+block_jit::~block_jit(void)
+{
+#if SH_JIT
+  if(code)
+    ::munmap(code, capacity);
+#endif
+}
+
+bool block_jit::supports(uint16_t id)
+{
+  return id < jit_forms().size() && jit_forms()[id].op != jit_op::none;
+}
+
+void block_jit::clear(void)
+{
+#if SH_JIT
+  if(code && used && !protect(code, 0, used, PROT_READ | PROT_WRITE))
+    throw("unable to make the code area writable"s);
+#endif
+  used = 0;
+  exhausted = false;
+}
+
+jit_function block_jit::translate(const std::vector<jit_instruction>& block, const jit_instruction* slot,
+                                  uint32_t& translated)
+{
+  translated = 0;
+  if(code && used == capacity)
+    exhausted = true;
+  if(!code || exhausted)
+    return nullptr;
+
+  // the prefix in the subset, a delayed branch only with its slot
+  std::size_t count = 0;
+  const jit_instruction* delay_slot = nullptr;
+  while(count < block.size() && supports(block[count].id))
+  {
+    const jit_op op = jit_forms()[block[count].id].op;
+    if(op == jit_op::bf || op == jit_op::bt)
+    {
+      ++count;
+      break;
+    }
+    if(is_branch(op))
+    {
+      if(slot && supports(slot->id) && !is_branch(jit_forms()[slot->id].op))
+      {
+        delay_slot = slot;
+        ++count;
+      }
+      break;
+    }
+    ++count;
+  }
+  if(count == 0)
+    return nullptr;
+
+#if SH_JIT
+  if(!protect(code, used, used + 1, PROT_READ | PROT_WRITE))
+    throw("unable to make the code area writable"s);
+#endif
+  x64_writer out(code + used, capacity - used);
+  translator t(out, mem);
+  t.allocate(block, count, delay_slot);
+  t.prologue();
+  for(std::size_t n = 0; n < count; ++n)
+    t.instruction(block[n], uint32_t(n), block[n].address);
+  if(delay_slot)
+    t.instruction(*delay_slot, uint32_t(count - 1), block[count - 1].address);
+
+  const jit_instruction& last = block[count - 1];
+  const bool sets_pc = is_branch(jit_forms()[last.id].op);
+  const uint32_t next_pc = count < block.size() ? block[count].address :
+                           last.address + uint32_t(last.word > 0xFFFF ? 4 : 2);
+  t.finish(sets_pc ? ~uint32_t(0) : next_pc, uint32_t(count));
+
+  const std::size_t end = out.overflowed() ? used : used + ((out.size() + 15) & ~std::size_t(15));
+#if SH_JIT
+  if(end && !protect(code, std::min(used, end - 1), end, PROT_READ | PROT_EXEC))
+    throw("unable to make the code area executable"s);
+#endif
+  if(out.overflowed())
+  {
+    exhausted = true;
+    return nullptr;
+  }
+  jit_function rval = reinterpret_cast<jit_function>(code + used);
+  used = end;
+  translated = uint32_t(count);
+  return rval;
+}
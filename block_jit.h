@@ -0,0 +1,78 @@
+#ifndef BLOCK_JIT_H
+#define BLOCK_JIT_H
+
+#include "interpreter.h"
+
+#include <cstdint>
+#include <vector>
+
+// the guest memory as the translated code sees it: the bytes of the block at
+// 'base' and the map of granules that hold translated instructions, which
+// writes check to set 'code_written'
+struct jit_memory
+{
+  uint8_t* data;
+  uint32_t base;
+  uint32_t size;
+  const uint8_t* code_map;
+  int code_granule_bits;
+  bool* code_written;
+};
+
+struct jit_instruction
+{
+  uint16_t id;
+  uint32_t word;
+  uint32_t address;
+};
+
+// runs the translated instructions of a block on the registers and returns
+// how many of them completed.  the PC is left at the next one to run: the
+// first that was not translated, or the one whose memory access faulted.
+typedef uint32_t (*jit_function)(cpu_state* state);
+
+// translates basic blocks of the SH1/SH2 integer instructions (the data
+// transfer, arithmetic, logic, shift and branch sections) into x86-64 code.
+// the instructions are picked and their operands decoded with the formats,
+// operand extractors and displacements of the database.  the most used guest
+// registers of a block live in host registers, memory accesses are checked
+// inline and leave the block at the faulting instruction, so the translated
+// code never calls out.  the jit dispatch of the interpreter hands it the
+// blocks of its block cache that have run a few times, and runs what is left
+// out on the handlers.
+class block_jit
+{
+public:
+  explicit block_jit(const jit_memory& memory, std::size_t code_size = 16 << 20);
+  ~block_jit(void);
+
+  block_jit(const block_jit&) = delete;
+  block_jit& operator =(const block_jit&) = delete;
+
+  // false off x86-64 Linux, or where written pages may not be made executable
+  bool available(void) const { return code != nullptr; }
+
+  // the translated prefix of 'block' in 'translated' (0 when not even the
+  // first instruction is in the subset).  a delayed branch at the end of the
+  // block is taken only with 'slot', its slot instruction, if that one is in
+  // the subset too.  nullptr when nothing is translated or the code area is
+  // full.
+  jit_function translate(const std::vector<jit_instruction>& block, const jit_instruction* slot,
+                         uint32_t& translated);
+
+  // the code area is full: the caller drops every translation and clears
+  bool full(void) const { return exhausted; }
+  void clear(void);
+
+  // instruction ids of the subset
+  static bool supports(uint16_t id);
+
+private:
+  jit_memory mem;
+  uint8_t* code = nullptr;
+  std::size_t capacity = 0;
+  std::size_t used = 0;
+  bool exhausted = false;
+};
+
+#endif // BLOCK_JIT_H
@@ -140,7 +140,7 @@ register Rn.
 {R"(
 void MOVI20 (int i, int n)
 {
-  if (i & 0x00080000) == 0)
+  if ((i & 0x00080000) == 0)
     R[n] = (0x000FFFFF & (long)i);
   else
     R[n] = (0xFFF00000 | (long)i);
@@ -188,7 +188,7 @@ generated.
 {R"(
 void MOVI20S (int i, int n)
 {
-  if (i & 0x00080000) == 0)
+  if ((i & 0x00080000) == 0)
     R[n] = (0x000FFFFF & (long)i);
   else
     R[n] = (0xFFF00000 | (long)i);
@@ -2880,7 +2880,7 @@ exceptions do not occur when access is to non-longword-boundary addresses
 {R"(
 void MOVUAL (int m)
 {
-  Read_Unaligned_32 (R0, R[m]);
+  R[0] = Read_Unaligned_32 (R[m]);
   PC += 2;
 }
 )"},
@@ -2930,7 +2930,7 @@ exceptions do not occur when access is to non-longword-boundary addresses
 {R"(
 void MOVUALP (int m)
 {
-  Read_Unaligned_32 (R0,R[m]);
+  R[0] = Read_Unaligned_32 (R[m]);
 
   if (m != 0)
     R[m] += 4;
@@ -4550,9 +4550,9 @@ void CMPIM (int i)
   long imm;
 
   if ((i & 0x80) == 0)
-    imm = (0x000000FF & (long i));
+    imm = (0x000000FF & (long)i);
   else
-    imm = (0xFFFFFF00 | (long i));
+    imm = (0xFFFFFF00 | (long)i);
 
   if (R[0] == imm)
     T = 1;
@@ -5870,7 +5870,7 @@ void DMULU (int m, int n)
   temp2 = RmL * RnH;
   temp3 = RmH * RnH;
 
-  Res2 = 0
+  Res2 = 0;
   Res1 = temp1 + temp2;
   if (Res1 < temp1)
     Res2 += 0x00010000;
@@ -5907,6 +5907,7 @@ insn { "dt\tRn",
   SH1 | SH2 | SH2E | SH2A | SH3 | SH4 | SH4A,
   abstract { "Rn-1 -> Rn\nIf Rn = 0: 1 -> T\nElse: 0 -> T" },
   opcode { "0100nnnn00010000" },
+  flags { "Result -> T" },
 
   group { SH4A, "EX", SH4, "EX" },
   issue { SH1 | SH2 | SH2E | SH2A | SH3 | SH4 | SH4A, "1" },
@@ -5998,7 +5999,7 @@ void EXTSB (int m, int n)
   R[n] = R[m];
 
   if ((R[m] & 0x00000080) == 0)
-    R[n] & = 0x000000FF;
+    R[n] &= 0x000000FF;
   else
     R[n] |= 0xFFFFFF00;
 
@@ -6053,7 +6054,7 @@ void EXTSW (int m, int n)
   R[n] = R[m];
 
   if ((R[m] & 0x00008000) == 0)
-    R[n] & = 0x0000FFFF;
+    R[n] &= 0x0000FFFF;
   else
     R[n] |= 0xFFFF0000;
 
@@ -6725,7 +6726,7 @@ latency of MAC*/MUL* is 5 cycles.
 {R"(
 void MULU (int m, int n)
 {
-  MACL = ((unsigned long)(unsigned short)R[n]* (unsigned long)(unsigned short)R[m];
+  MACL = (unsigned long)(unsigned short)R[n] * (unsigned long)(unsigned short)R[m];
   PC += 2;
 }
 )"},
@@ -11419,7 +11420,7 @@ void LDRE (int d)
   else
     disp = (0xFFFFFF00 | (long)d);
 
-  RE = PC + (disp << 1);
+  RE = PC + 4 + (disp << 1);
   PC += 2;
 }
 )"},
@@ -11489,7 +11490,7 @@ void LDRS (int d)
   else
     disp = (0xFFFFFF00 | (long)d);
 
-  RS = PC + (disp << 1);
+  RS = PC + 4 + (disp << 1);
   PC += 2;
 }
 )"},
@@ -12069,7 +12070,7 @@ void LDSX0 (int m)
 insn { "lds.l\t@Rm+,X0",
   SH1_DSP | SH2_DSP | SH3_DSP,
   abstract { "(Rm) -> X0, Rm+4 -> Rm" },
-  opcode { "0100nnnn10000110" },
+  opcode { "0100mmmm10000110" },
 
   issue { SH1_DSP | SH2_DSP | SH3_DSP, "1" },
   latency { SH1_DSP | SH2_DSP | SH3_DSP, "1/5" },
@@ -12152,7 +12153,7 @@ void LDSX1 (int m)
 insn { "lds.l\t@Rm+,X1",
   SH1_DSP | SH2_DSP | SH3_DSP,
   abstract { "(Rm) -> X1, Rm+4 -> Rm" },
-  opcode { "0100nnnn10010110" },
+  opcode { "0100mmmm10010110" },
 
   issue { SH1_DSP | SH2_DSP | SH3_DSP, "1" },
   latency { SH1_DSP | SH2_DSP | SH3_DSP, "1/5" },
@@ -12236,7 +12237,7 @@ void LDSY0 (int m)
 insn { "lds.l\t@Rm+,Y0",
   SH1_DSP | SH2_DSP | SH3_DSP,
   abstract { "(Rm) -> Y0, Rm+4 -> Rm" },
-  opcode { "0100nnnn10100110" },
+  opcode { "0100mmmm10100110" },
 
   issue { SH1_DSP | SH2_DSP | SH3_DSP, "1" },
   latency { SH1_DSP | SH2_DSP | SH3_DSP, "1/5" },
@@ -12320,7 +12321,7 @@ void LDSY1 (int m)
 insn { "lds.l\t@Rm+,Y1",
   SH1_DSP | SH2_DSP | SH3_DSP,
   abstract { "(Rm) -> Y1, Rm+4 -> Rm" },
-  opcode { "0100nnnn10110110" },
+  opcode { "0100mmmm10110110" },
 
   issue { SH1_DSP | SH2_DSP | SH3_DSP, "1" },
   latency { SH1_DSP | SH2_DSP | SH3_DSP, "1" },
@@ -13536,7 +13537,7 @@ This instruction can also be issued in user mode.
 
   operation
 {R"(
-STCGBR (int n)
+void STCGBR (int n)
 {
   R[n] = GBR;
   PC += 2;
@@ -14639,7 +14640,7 @@ void STSMMACH (int n)
   if ((MACH & 0x00000200) == 0)
     Write_32 (R[n], MACH & 0x000003FF);
   else
-    Write_32 (R[n], MACH | 0xFFFFFC00)
+    Write_32 (R[n], MACH | 0xFFFFFC00);
 
   #else
   Write_32 (R[n], MACH);
@@ -17312,7 +17313,7 @@ not necessary to adjust the FPSRC.PR setting before this instruction.
 {R"(
 void FABS (int n)
 {
-  FR[n] = FR[n] & 0x7FFFFFFFF;
+  FR[n] = FR[n] & 0x7FFFFFFF;
   PC += 2;
 }
 )"},
@@ -19354,7 +19355,7 @@ not necessary to adjust the FPSRC.PR setting before this instruction.
 {R"(
 void FABS (int n)
 {
-  FR[n] = FR[n] & 0x7FFFFFFFF;
+  FR[n] = FR[n] & 0x7FFFFFFF;
   PC += 2;
 }
 )"},
@@ -0,0 +1,171 @@
+#include "decode_table.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+using namespace std::literals::string_literals;
+
+namespace
+{
+  // calls func for every halfword whose 'fixed' bits equal 'value'
+  template<typename Func>
+  void for_each_halfword(uint16_t fixed, uint16_t value, Func func)
+  {
+    const uint16_t free_bits = uint16_t(~fixed);
+    uint16_t sub = free_bits;
+    do
+    {
+      func(uint16_t(value | sub));
+      sub = uint16_t((sub - 1) & free_bits);
+    } while(sub != free_bits);
+  }
+}
+
+decode_table::decode_table(isa variant, unsigned fpu_mode)
+  : target(variant), mode(fpu_mode),
+    first_level(0x10000 + 1, invalid_instruction)
+{
+  const isa instruction_sets = cpu_instruction_sets(variant);
+  const std::vector<instruction_entry>& entries = instruction_entries();
+
+  sizes.resize(entries.size(), 2);
+
+  std::vector<int> first_specificity(0x10000, -1);
+  std::vector<std::vector<uint16_t>> candidates(0x10000); // 32-bit forms by first halfword
+
+  for(const instruction_entry& entry : entries)
+  {
+    if(!entry.source->for_isa(instruction_sets) || !decodes_in_fpu_mode(entry, fpu_mode))
+      continue;
+
+    const opcode_pattern& p = entry.pattern;
+    const int shift = p.width - 16;
+    const int spec = specificity(p);
+    sizes[entry.id] = uint8_t(p.width / 8);
+
+    for_each_halfword(uint16_t(p.mask >> shift), uint16_t(p.match >> shift),
+      [&](uint16_t word)
+      {
+        if(p.width == 32)
+          candidates[word].push_back(entry.id);
+        else if(first_specificity[word] < spec)
+        {
+          first_specificity[word] = spec;
+          first_level[word] = entry.id;
+        }
+      });
+  }
+
+  // identical candidate lists (with the same 16-bit fallback) share a bucket
+  std::map<std::pair<std::vector<uint16_t>, uint16_t>, uint16_t> buckets;
+
+  for(std::size_t word = 0; word < 0x10000; ++word)
+  {
+    if(candidates[word].empty())
+      continue;
+
+    auto key = std::make_pair(candidates[word], first_level[word]);
+    auto pos = buckets.find(key);
+    if(pos == std::end(buckets))
+    {
+      if(buckets.size() >= extended_flag - 1)
+        throw("Too many 32-bit instruction buckets for "s + cpu_name(variant));
+
+      uint16_t bucket = uint16_t(buckets.size());
+      pos = buckets.emplace(key, bucket).first;
+
+      // halfwords that match no 32-bit form decode as the 16-bit fallback
+      std::size_t base = second_level.size();
+      second_level.resize(base + 0x10000, first_level[word]);
+      std::vector<int> second_specificity(0x10000, -1);
+
+      for(uint16_t id : candidates[word])
+      {
+        const opcode_pattern& p = entries[id].pattern;
+        const int spec = specificity(p);
+        for_each_halfword(uint16_t(p.mask), uint16_t(p.match),
+          [&](uint16_t second)
+          {
+            if(second_specificity[second] < spec)
+            {
+              second_specificity[second] = spec;
+              second_level[base + second] = id;
+            }
+          });
+      }
+    }
+    first_level[word] = extended_flag | pos->second;
+  }
+}
+
+std::size_t decode_table::memory_footprint(void) const
+{
+  return (first_level.size() + second_level.size()) * sizeof(uint16_t) + sizes.size();
+}
+
+compressed_decode_table::compressed_decode_table(const decode_table& table)
+{
+  // a first halfword of every bucket, to read the second levels back
+  std::vector<uint16_t> bucket_word(table.bucket_count());
+  for(std::size_t word = 0; word < 0x10000; ++word)
+  {
+    uint16_t entry = table.lookup(uint16_t(word));
+    if(decode_table::is_extended(entry))
+      bucket_word[entry & ~decode_table::extended_flag] = uint16_t(word);
+  }
+
+  std::map<std::vector<uint16_t>, uint16_t> unique_pages;
+  const std::size_t levels = 1 + bucket_word.size();
+  for(std::size_t level = 0; level < levels; ++level)
+  {
+    for(std::size_t base = 0; base < 0x10000; base += page_size)
+    {
+      std::vector<uint16_t> page(page_size);
+      for(std::size_t pos = 0; pos < page_size; ++pos)
+        page[pos] = level ? table.decode(bucket_word[level - 1], uint16_t(base + pos))
+                          : table.lookup(uint16_t(base + pos));
+
+      auto found = unique_pages.find(page);
+      if(found == std::end(unique_pages))
+      {
+        if(unique_pages.size() > 0xFFFF)
+          throw("Too many distinct pages for "s + cpu_name(table.variant()));
+        found = unique_pages.emplace(page, uint16_t(unique_pages.size())).first;
+        pages.insert(pages.end(), page.begin(), page.end());
+      }
+      directory.push_back(found->second);
+    }
+  }
+}
+
+std::size_t compressed_decode_table::memory_footprint(void) const
+{
+  return (directory.size() + pages.size()) * sizeof(uint16_t);
+}
+
+const decode_table& decode_table_for(isa variant, unsigned fpu_mode)
+{
+  static std::mutex lock;
+  static std::array<std::unique_ptr<decode_table>, isa_count * (fpu_mode_count + 1)> tables;
+
+  if(fpu_mode != any_fpu_mode)
+  {
+    bool has_modes = false;
+    for(const instruction_entry& entry : instruction_entries())
+      for(unsigned mode = 0; mode < fpu_mode_count; ++mode)
+        has_modes |= entry.source->for_isa(cpu_instruction_sets(variant)) && !decodes_in_fpu_mode(entry, mode);
+    if(!has_modes)
+      fpu_mode = any_fpu_mode;
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  std::unique_ptr<decode_table>& table = tables[countr_zero(uint16_t(variant)) % isa_count * (fpu_mode_count + 1) +
+                                                fpu_mode];
+  if(!table)
+    table = std::make_unique<decode_table>(variant, fpu_mode);
+  return *table;
+}
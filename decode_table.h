@@ -0,0 +1,91 @@
+#ifndef DECODE_TABLE_H
+#define DECODE_TABLE_H
+
+#include "decoder.h"
+
+#include <cstdint>
+#include <vector>
+
+// flat decode table of one CPU variant, for one FPU mode or for any.
+// the first halfword indexes a 64K table that holds either the instruction id
+// or the bucket of the 32-bit forms that start with that halfword.  each
+// bucket is a second 64K table indexed by the second halfword.
+class decode_table
+{
+public:
+  static constexpr uint16_t extended_flag = 0x8000;
+
+  explicit decode_table(isa variant, unsigned fpu_mode = any_fpu_mode);
+
+  isa variant(void) const { return target; }
+  unsigned fpu_mode(void) const { return mode; }
+
+  // instruction id, invalid_instruction or (extended_flag | bucket)
+  uint16_t lookup(uint16_t first) const { return first_level[first]; }
+
+  static bool is_extended(uint16_t entry) { return (entry & extended_flag) && entry != invalid_instruction; }
+
+  uint16_t decode(uint16_t first, uint16_t second) const
+  {
+    uint16_t entry = first_level[first];
+    if(!is_extended(entry))
+      return entry;
+    return second_level[(std::size_t(entry & ~extended_flag) << 16) | second];
+  }
+
+  // size in bytes of a decoded instruction (illegal words count as one halfword)
+  uint8_t size(uint16_t id) const { return id < sizes.size() ? sizes[id] : 2; }
+
+  // first level table, padded so that 32-bit gathers may read past the last entry
+  const uint16_t* data(void) const { return first_level.data(); }
+
+  std::size_t bucket_count(void) const { return second_level.size() >> 16; }
+  std::size_t memory_footprint(void) const;
+
+private:
+  isa target;
+  unsigned mode;
+  std::vector<uint16_t> first_level;
+  std::vector<uint16_t> second_level;
+  std::vector<uint8_t> sizes;
+};
+
+// decode_table with the 64K tables cut in pages of 256 entries and the
+// identical pages stored once.  slower by one indirection per level, but a
+// fraction of the size.
+class compressed_decode_table
+{
+public:
+  static constexpr std::size_t page_bits = 8;
+  static constexpr std::size_t page_size = std::size_t(1) << page_bits;
+
+  explicit compressed_decode_table(const decode_table& table);
+
+  uint16_t decode(uint16_t first, uint16_t second) const
+  {
+    uint16_t entry = entry_of(0, first);
+    if(!decode_table::is_extended(entry))
+      return entry;
+    return entry_of(std::size_t(1) + (entry & ~decode_table::extended_flag), second);
+  }
+
+  std::size_t page_count(void) const { return pages.size() / page_size; }
+  std::size_t memory_footprint(void) const;
+
+private:
+  // level 0 is the first level table, level 1 + n the bucket n
+  uint16_t entry_of(std::size_t level, uint16_t word) const
+  {
+    const uint16_t page = directory[(level << (16 - page_bits)) | (word >> page_bits)];
+    return pages[(std::size_t(page) << page_bits) | (word & (page_size - 1))];
+  }
+
+  std::vector<uint16_t> directory; // page of every 256 entries of every level
+  std::vector<uint16_t> pages;
+};
+
+// tables are built once per variant and FPU mode and shared.  the modes of
+// a variant without mode dependent instructions share the table of any mode.
+const decode_table& decode_table_for(isa variant, unsigned fpu_mode = any_fpu_mode);
+
+#endif // DECODE_TABLE_H
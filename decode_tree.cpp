@@ -0,0 +1,104 @@
+#include "decode_tree.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+
+namespace
+{
+  // widest field an inner node switches on
+  constexpr int max_field_width = 8;
+}
+
+decode_tree::decode_tree(isa variant)
+  : target(variant)
+{
+  const isa instruction_sets = cpu_instruction_sets(variant);
+
+  // order of precedence: 32-bit forms, then the most specific pattern (as decode_table)
+  std::vector<const instruction_entry*> entries;
+  for(const instruction_entry& entry : instruction_entries())
+    if(entry.source->for_isa(instruction_sets))
+      entries.push_back(&entry);
+
+  std::stable_sort(entries.begin(), entries.end(),
+    [](const instruction_entry* a, const instruction_entry* b)
+    {
+      if(a->pattern.width != b->pattern.width)
+        return a->pattern.width > b->pattern.width;
+      return specificity(a->pattern) > specificity(b->pattern);
+    });
+
+  std::vector<pattern> candidates;
+  for(const instruction_entry* entry : entries)
+  {
+    const int shift = 32 - entry->pattern.width;
+    candidates.push_back({ entry->pattern.mask << shift, entry->pattern.match << shift, entry->id });
+  }
+
+  nodes.emplace_back();
+  build(0, candidates, 0);
+}
+
+void decode_tree::build(std::size_t index, const std::vector<pattern>& candidates, uint32_t decided)
+{
+  // count how many patterns fix each undecided bit
+  std::array<std::size_t, 32> fixed = {};
+  for(const pattern& p : candidates)
+    for(int bit = 0; bit < 32; ++bit)
+      if((p.mask & ~decided) & (1u << bit))
+        ++fixed[bit];
+
+  const std::size_t best = *std::max_element(fixed.begin(), fixed.end());
+  if(candidates.size() <= 1 || !best)
+  {
+    nodes[index] = { 0, 0, uint16_t(candidates.size()), uint32_t(patterns.size()) };
+    patterns.insert(patterns.end(), candidates.begin(), candidates.end());
+    return;
+  }
+
+  // the highest run of bits fixed by as many patterns as possible
+  int high = 31;
+  while(fixed[high] != best)
+    --high;
+  int low = high;
+  while(low > 0 && high - low + 1 < max_field_width && fixed[low - 1] == best)
+    --low;
+
+  const uint8_t shift = uint8_t(low);
+  const uint8_t width = uint8_t(high - low + 1);
+  const uint32_t field = ((1u << width) - 1) << shift;
+
+  const uint32_t first_child = uint32_t(nodes.size());
+  nodes[index] = { shift, width, 0, first_child };
+  nodes.resize(nodes.size() + (std::size_t(1) << width));
+
+  for(uint32_t value = 0; value < (1u << width); ++value)
+  {
+    std::vector<pattern> subset;
+    for(const pattern& p : candidates)
+      if(((p.match ^ (value << shift)) & p.mask & field) == 0)
+        subset.push_back(p);
+    build(first_child + value, subset, decided | field);
+  }
+}
+
+std::size_t decode_tree::depth(void) const
+{
+  std::function<std::size_t(std::size_t)> walk = [&](std::size_t index) -> std::size_t
+  {
+    const node& n = nodes[index];
+    if(!n.width)
+      return 0;
+    std::size_t deepest = 0;
+    for(uint32_t child = 0; child < (1u << n.width); ++child)
+      deepest = std::max(deepest, walk(n.next + child));
+    return deepest + 1;
+  };
+  return walk(0);
+}
+
+std::size_t decode_tree::memory_footprint(void) const
+{
+  return nodes.size() * sizeof(node) + patterns.size() * sizeof(pattern);
+}
@@ -0,0 +1,61 @@
+#ifndef DECODE_TREE_H
+#define DECODE_TREE_H
+
+#include "decoder.h"
+
+#include <cstdint>
+#include <vector>
+
+// decision tree decoder of one CPU variant.
+// inner nodes switch on a field of opcode bits that most of their patterns fix,
+// leaves test the few remaining patterns in order of precedence.
+// the instruction is handled as one 32-bit word, 16-bit patterns in the upper half.
+class decode_tree
+{
+public:
+  struct node
+  {
+    uint8_t shift;  // position of the switched field
+    uint8_t width;  // bits of the switched field, zero for leaves
+    uint16_t count; // leaves: number of patterns
+    uint32_t next;  // first child, or first pattern of a leaf
+  };
+
+  struct pattern
+  {
+    uint32_t mask;
+    uint32_t match;
+    uint16_t id;
+  };
+
+  explicit decode_tree(isa variant);
+
+  isa variant(void) const { return target; }
+
+  uint16_t decode(uint16_t first, uint16_t second) const
+  {
+    const uint32_t word = (uint32_t(first) << 16) | second;
+    const node* n = &nodes[0];
+    while(n->width)
+      n = &nodes[n->next + ((word >> n->shift) & ((1u << n->width) - 1))];
+    for(const pattern* p = &patterns[n->next], *end = p + n->count; p != end; ++p)
+      if((word & p->mask) == p->match)
+        return p->id;
+    return invalid_instruction;
+  }
+
+  const std::vector<node>& tree(void) const { return nodes; }
+  const std::vector<pattern>& leaf_patterns(void) const { return patterns; }
+
+  std::size_t depth(void) const;
+  std::size_t memory_footprint(void) const;
+
+private:
+  void build(std::size_t index, const std::vector<pattern>& candidates, uint32_t decided);
+
+  isa target;
+  std::vector<node> nodes;
+  std::vector<pattern> patterns;
+};
+
+#endif // DECODE_TREE_H
@@ -0,0 +1,193 @@
+#include "decoder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <regex>
+#include <string_view>
+#include <utility>
+
+using namespace std::literals::string_literals;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+  constexpr std::array<std::pair<std::string_view, isa>, 14> cpu_names =
+  {
+    {
+      { "SH1", SH1 },
+      { "SH1_DSP", SH1_DSP },
+      { "SH2", SH2 },
+      { "SH2_DSP", SH2_DSP },
+      { "SH2E", SH2E },
+      { "SH2A", SH2A },
+      { "SH2A_FPU", SH2A_FPU },
+      { "SH3", SH3 },
+      { "SH3_FPU", SH3_FPU },
+      { "SH3_DSP", SH3_DSP },
+      { "SH4", SH4 },
+      { "SH4A", SH4A },
+      { "SH3E", SH3_FPU }, // aliases
+      { "DSP", SH1_DSP },
+    }
+  };
+}
+
+isa parse_cpu_name(const std::string& name)
+{
+  std::string upper = name;
+  std::transform(std::begin(upper), std::end(upper), std::begin(upper), [](unsigned char c) { return std::toupper(c); });
+  for(const auto& cpu : cpu_names)
+    if(cpu.first == upper)
+      return cpu.second;
+  return SH_NONE;
+}
+
+const char* cpu_name(isa variant)
+{
+  for(const auto& cpu : cpu_names)
+    if(cpu.second == variant)
+      return cpu.first.data();
+  return "";
+}
+
+opcode_pattern compile_opcode(const std::string& code)
+{
+  opcode_pattern pattern;
+
+  if(code.size() != 16 && code.size() != 32)
+    throw("Unsupported opcode length: '"s + code + "'");
+
+  pattern.width = uint8_t(code.size());
+
+  for(std::size_t pos = 0; pos < code.size(); ++pos)
+  {
+    const uint32_t bit = uint32_t(1) << (code.size() - pos - 1);
+    switch(code[pos])
+    {
+      case '1':
+        pattern.match |= bit;
+        [[fallthrough]];
+      case '0':
+        pattern.mask |= bit;
+        break;
+
+      case '*':
+        pattern.ignored |= bit;
+        break;
+
+      default:
+      {
+        auto field = std::find_if(std::begin(pattern.fields), std::end(pattern.fields),
+                                  [&code, pos](const operand_field& f) { return f.letter == code[pos]; });
+        if(field == std::end(pattern.fields))
+          field = pattern.fields.insert(field, { code[pos], 0, 0 });
+        field->mask |= bit;
+        ++field->width;
+        break;
+      }
+    }
+  }
+
+  return pattern;
+}
+
+int specificity(const opcode_pattern& pattern)
+{
+  int count = 0;
+  for(uint32_t bits = pattern.mask; bits; bits &= bits - 1)
+    ++count;
+  return count;
+}
+
+uint32_t extract_bits(uint32_t word, uint32_t mask)
+{
+  uint32_t rval = 0;
+  int pos = 0;
+  for(uint32_t bit = 1; mask; bit <<= 1)
+  {
+    if(mask & bit)
+    {
+      if(word & bit)
+        rval |= uint32_t(1) << pos;
+      ++pos;
+      mask &= ~bit;
+    }
+  }
+  return rval;
+}
+
+uint32_t deposit_bits(uint32_t value, uint32_t mask)
+{
+  uint32_t rval = 0;
+  for(uint32_t bit = 1; mask; bit <<= 1)
+  {
+    if(mask & bit)
+    {
+      if(value & 1)
+        rval |= bit;
+      value >>= 1;
+      mask &= ~bit;
+    }
+  }
+  return rval;
+}
+
+displacement_info displacement_of(const insn& i)
+{
+  displacement_info rval;
+  const std::string& abs = i.data<abstract>();
+  std::smatch match;
+
+  if(std::regex_search(abs, match, std::regex("disp \\* ([[:digit:]]+)", std::regex_constants::extended)))
+    rval.scale = std::stoi(match[1]);
+
+  if(std::regex_search(abs, match, std::regex("disp( \\* [[:digit:]]+)?\\)? \\+ \\(?PC", std::regex_constants::extended)))
+  {
+    rval.pc_relative = true;
+    rval.pc_aligned = abs.find("PC & 0xFFFFFFFC") != std::string::npos;
+
+    std::string rest = match.suffix();
+    if(std::regex_search(rest, match, std::regex("^( & 0xFFFFFFFC\\))? \\+ ([[:digit:]]+)", std::regex_constants::extended)))
+      rval.pc_offset = std::stoi(match[2]);
+  }
+  return rval;
+}
+
+const std::list<insns>& instruction_database(void)
+{
+  static const std::list<insns> database = []
+  {
+    std::list<insns> insn_blocks;
+    build_insn_blocks(insn_blocks);
+    return insn_blocks;
+  }();
+  return database;
+}
+
+const std::vector<instruction_entry>& instruction_entries(void)
+{
+  static const std::vector<instruction_entry> entries = []
+  {
+    std::vector<instruction_entry> rval;
+    for(const insns& block : instruction_database())
+      for(const insn& i : block)
+        rval.push_back({ uint16_t(rval.size()), &i, &block, compile_opcode(i.data<opcode>()) });
+    return rval;
+  }();
+  return entries;
+}
+
+bool decodes_in_fpu_mode(const instruction_entry& entry, unsigned mode)
+{
+  if(mode == any_fpu_mode)
+    return true;
+  const std::string_view title = entry.section->section_title;
+  for(const auto& [name, bit] : { std::make_pair("FPSCR.PR = "sv, fpu_pr), std::make_pair("FPSCR.SZ = "sv, fpu_sz) })
+  {
+    const std::size_t pos = title.find(name);
+    if(pos != std::string_view::npos && pos + name.size() < title.size() &&
+       (title[pos + name.size()] == '1') != bool(mode & bit))
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,110 @@
+#ifndef DECODER_H
+#define DECODER_H
+
+#include "build_instructions.h"
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <vector>
+
+constexpr uint16_t invalid_instruction = 0xFFFF;
+
+// instruction sets executed by a CPU variant.
+// the DSP and FPU variants only list their extensions in the database.
+constexpr isa cpu_instruction_sets(isa variant)
+{
+  switch(variant)
+  {
+    case SH1_DSP:  return SH1 | SH1_DSP;
+    case SH2_DSP:  return SH2 | SH2_DSP;
+    case SH2A_FPU: return SH2A | SH2A_FPU;
+    case SH3_FPU:  return SH3 | SH3_FPU;
+    case SH3_DSP:  return SH3 | SH3_DSP;
+    default:       return variant;
+  }
+}
+
+constexpr std::array<isa, isa_count> cpu_variants =
+{
+  SH1, SH1_DSP, SH2, SH2_DSP, SH2E, SH2A, SH2A_FPU, SH3, SH3_FPU, SH3_DSP, SH4, SH4A,
+};
+
+// "SH2", "SH2A_FPU", ... (SH_NONE if unknown)
+isa parse_cpu_name(const std::string& name);
+const char* cpu_name(isa variant);
+
+struct operand_field
+{
+  char letter;    // operand letter of the opcode string ('n', 'm', 'i', 'z', ...)
+  uint32_t mask;  // bits of the field within the instruction word
+  uint8_t width;  // number of bits in the field
+};
+
+// opcode strings are written with the first halfword in the upper 16 bits
+struct opcode_pattern
+{
+  uint32_t mask = 0;    // fixed bits ('0' and '1')
+  uint32_t match = 0;   // value of the fixed bits
+  uint32_t ignored = 0; // "don't care" bits ('*')
+  uint8_t width = 16;   // 16 or 32 bits
+  std::vector<operand_field> fields; // in order of first appearance
+
+  bool matches(uint32_t word) const { return (word & mask) == match; }
+};
+
+opcode_pattern compile_opcode(const std::string& code);
+
+// number of fixed bits, used to prefer the most specific of overlapping patterns
+int specificity(const opcode_pattern& pattern);
+
+// gathers the bits selected by 'mask' into the low bits of the result
+uint32_t extract_bits(uint32_t word, uint32_t mask);
+
+// the inverse of extract_bits(): spreads the low bits of 'value' over 'mask'
+uint32_t deposit_bits(uint32_t value, uint32_t mask);
+
+// how the 'd' field of an instruction becomes an address,
+// derived from its abstract (e.g. "disp * 4 + (PC & 0xFFFFFFFC) + 4")
+struct displacement_info
+{
+  int scale = 1;
+  bool pc_relative = false;
+  bool pc_aligned = false; // PC & 0xFFFFFFFC
+  int pc_offset = 0;
+
+  uint32_t target(uint32_t pc, int32_t disp) const
+    { return (pc_aligned ? pc & ~uint32_t(3) : pc) + uint32_t(pc_offset) + uint32_t(disp * scale); }
+};
+
+displacement_info displacement_of(const insn& i);
+
+struct instruction_entry
+{
+  uint16_t id;            // position in the database
+  const insn* source;
+  const insns* section;
+  opcode_pattern pattern;
+};
+
+// the unprocessed database (no HTML post processing applied)
+const std::list<insns>& instruction_database(void);
+
+// every instruction of the database with its compiled opcode, indexed by id
+const std::vector<instruction_entry>& instruction_entries(void);
+
+// FPSCR.PR and FPSCR.SZ select between floating-point instructions with the
+// same encoding.  the database keeps them in sections by mode, e.g.
+// "... (FPSCR.SZ = 1)".
+enum fpu_mode_bits : unsigned { fpu_pr = 1, fpu_sz = 2 };
+constexpr unsigned fpu_mode_count = 4;
+constexpr unsigned any_fpu_mode = fpu_mode_count; // no mode: the most specific pattern wins
+
+// the FPU mode of an FPSCR value
+constexpr unsigned fpu_mode_of(uint32_t fpscr) { return (fpscr >> 19) & 3; }
+
+// false for the instructions of a mode section that does not match 'mode'
+bool decodes_in_fpu_mode(const instruction_entry& entry, unsigned mode);
+
+#endif // DECODER_H
@@ -0,0 +1,324 @@
+#include "disassembler.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+  // mnemonics are padded to this column
+  constexpr std::size_t operand_column = 8;
+
+  // operand value standing for a field the opcode does not have
+  constexpr uint8_t no_field = max_operand_fields;
+
+  bool is_token_char(char c)
+    { return std::isalnum(uint8_t(c)) || c == '_'; }
+
+  char* write_text(char* out, const char* text)
+  {
+    while(*text)
+      *out++ = *text++;
+    return out;
+  }
+}
+
+char* write_hex(char* out, uint32_t value, int digits)
+{
+  constexpr char hex[] = "0123456789abcdef";
+  for(int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+    *out++ = hex[(value >> shift) & 15];
+  return out;
+}
+
+void append_hex(std::string& out, uint32_t value, int digits)
+{
+  char buffer[8];
+  out.append(buffer, std::size_t(write_hex(buffer, value, digits) - buffer));
+}
+
+disassembler::disassembler(isa variant)
+  : target(variant),
+    dsp_enabled(cpu_instruction_sets(variant) & (SH1_DSP | SH2_DSP | SH3_DSP))
+{
+  const std::vector<operand_extractor>& extractors = operand_extractors();
+  for(const instruction_entry& entry : instruction_entries())
+  {
+    const std::string& fmt = entry.source->data<::format>();
+    const displacement_info disp = displacement_of(*entry.source);
+    programs.push_back(compile(fmt, extractors[entry.id], disp, false));
+    if(dsp_enabled)
+      dsp_programs.push_back(compile(fmt, extractors[entry.id], disp, true));
+  }
+}
+
+// the format string in lowercase with the mnemonics padded, as literals
+// and slots for the operands
+disassembler::text_program disassembler::compile(const std::string& fmt, const operand_extractor& extractor,
+                                                 const displacement_info& disp, bool dsp_form)
+{
+  text_program rval;
+  rval.first = uint32_t(ops.size());
+  rval.displacement = disp;
+
+  std::string literal;
+  auto slot = [&](text_op::kind_t kind, uint8_t field, int scale)
+  {
+    if(!literal.empty())
+    {
+      ops.push_back({ text_op::literal, 0, 0, uint16_t(pool.size()), uint16_t(literal.size()) });
+      pool += literal;
+      literal.clear();
+    }
+    if(kind != text_op::literal)
+      ops.push_back({ kind, field, int16_t(scale), 0, 0 });
+  };
+
+  auto field = [&](char letter) -> uint8_t
+  {
+    for(uint8_t f = 0; f < extractor.count; ++f)
+      if(extractor.letter[f] == letter)
+        return f;
+    // a few entries name the register Rm with an nnnn field ("lds.l @Rm+,X0")
+    for(uint8_t f = 0; f < extractor.count; ++f)
+      if((letter == 'm' && extractor.letter[f] == 'n') || (letter == 'n' && extractor.letter[f] == 'm'))
+        return f;
+    return no_field;
+  };
+
+  auto reg = [&](const char* prefix, char letter, int scale, const char* suffix = "")
+  {
+    literal += prefix;
+    slot(text_op::decimal, field(letter), scale);
+    literal += suffix;
+  };
+
+  auto resolve = [&](std::string_view token)
+  {
+    if(dsp_form)
+    {
+      if(token == "Sx"sv)
+        slot(text_op::dsp_part, sx, 1);
+      else if(token == "Sy"sv)
+        slot(text_op::dsp_part, sy, 1);
+      else if(token == "Dz"sv || token == "Du"sv)
+        slot(text_op::dsp_part, dz, 1);
+      else if(token == "Se"sv)
+        slot(text_op::dsp_part, se, 1);
+      else if(token == "Sf"sv)
+        slot(text_op::dsp_part, sf, 1);
+      else if(token == "Dg"sv)
+        slot(text_op::dsp_part, dg, 1);
+      else if(token == "imm"sv)
+        slot(text_op::dsp_imm, 0, 1);
+      else if(token == "Ax"sv || token == "Ay"sv || token == "As"sv)
+        slot(text_op::dsp_part, pointer, 1);
+      else if(token == "Dx"sv || token == "Dy"sv || token == "Da"sv || token == "Ds"sv)
+        slot(text_op::dsp_part, data, 1);
+      else if(token == "Ix"sv || token == "Is"sv)
+        literal += "r8";
+      else if(token == "Iy"sv)
+        literal += "r9";
+      else
+        return false;
+      return true;
+    }
+
+    if(token == "Rn"sv)
+      reg("r", 'n', 1);
+    else if(token == "Rm"sv)
+      reg("r", 'm', 1);
+    else if(token == "Rn_BANK"sv)
+      reg("r", 'n', 1, "_bank");
+    else if(token == "Rm_BANK"sv)
+      reg("r", 'm', 1, "_bank");
+    else if(token == "FRn"sv)
+      reg("fr", 'n', 1);
+    else if(token == "FRm"sv)
+      reg("fr", 'm', 1);
+    else if(token == "DRn"sv)
+      reg("dr", 'n', 2);
+    else if(token == "DRm"sv)
+      reg("dr", 'm', 2);
+    else if(token == "XDn"sv)
+      reg("xd", 'n', 2);
+    else if(token == "XDm"sv)
+      reg("xd", 'm', 2);
+    else if(token == "FVn"sv)
+      reg("fv", 'n', 4);
+    else if(token == "FVm"sv)
+      reg("fv", 'm', 4);
+    else if(token == "imm"sv || token == "imm3"sv || token == "imm20"sv)
+      slot(text_op::decimal, field('i'), 1);
+    else if(token == "disp"sv || token == "disp8"sv || token == "disp12"sv)
+      slot(text_op::decimal, field('d'), disp.scale);
+    else if(token == "label"sv)
+    {
+      literal += "0x";
+      slot(text_op::target, field('d'), 1);
+    }
+    else
+      return false;
+    return true;
+  };
+
+  std::size_t column = 0; // since the start of the line
+  bool operands = false;
+  bool labeled = false;
+  auto put = [&](char c)
+  {
+    literal += c;
+    ++column;
+  };
+
+  for(std::size_t pos = 0; pos < fmt.size(); )
+  {
+    const char c = fmt[pos];
+    if(c == '\t')
+    {
+      const std::size_t width = column;
+      literal.append(width < operand_column ? operand_column - width : 1, ' ');
+      operands = true;
+      ++pos;
+    }
+    else if(c == '\n') // combined forms ("padd ...\npmuls ...")
+    {
+      literal += ' ';
+      column = 0;
+      operands = false;
+      ++pos;
+    }
+    else if(c == ' ' && !operands && pos + 1 < fmt.size() && fmt[pos + 1] == '\t')
+      ++pos; // "dcf psub \tSx,Sy,Dz"
+    else if(operands && is_token_char(c) && !std::isdigit(uint8_t(c)))
+    {
+      std::size_t end = pos;
+      while(end < fmt.size() && is_token_char(fmt[end]))
+        ++end;
+      std::string_view token = std::string_view(fmt).substr(pos, end - pos);
+      labeled |= token == "label"sv;
+      if(!resolve(token))
+        for(char t : token)
+          put(char(std::tolower(uint8_t(t))));
+      pos = end;
+    }
+    else
+    {
+      put(char(std::tolower(uint8_t(c))));
+      ++pos;
+    }
+  }
+
+  // PC relative loads show the address they read from
+  if(!dsp_form && disp.pc_relative && !labeled)
+  {
+    literal += "\t! 0x";
+    slot(text_op::target, field('d'), 1);
+  }
+  slot(text_op::literal, 0, 0);
+
+  rval.count = uint32_t(ops.size()) - rval.first;
+  return rval;
+}
+
+char* disassembler::format(char* out, uint16_t id, const operand_values& values, uint32_t address) const
+{
+  const text_program& p = programs[id];
+  for(const text_op* op = ops.data() + p.first, *end = op + p.count; op != end; ++op)
+  {
+    const int32_t value = op->field < no_field ? values.value[op->field] : 0;
+    switch(op->kind)
+    {
+      case text_op::literal:
+        std::memcpy(out, pool.data() + op->offset, op->length);
+        out += op->length;
+        break;
+      case text_op::decimal:
+        out = std::to_chars(out, out + 12, value * op->scale).ptr;
+        break;
+      case text_op::target:
+        out = write_hex(out, p.displacement.target(address, value), 8);
+        break;
+      default:
+        break;
+    }
+  }
+  return out;
+}
+
+char* disassembler::render_dsp(char* out, const text_program& program, const dsp_operation& op, const dsp_move* move,
+                               bool& reserved) const
+{
+  for(const text_op* o = ops.data() + program.first, *end = o + program.count; o != end; ++o)
+  {
+    switch(o->kind)
+    {
+      case text_op::literal:
+        std::memcpy(out, pool.data() + o->offset, o->length);
+        out += o->length;
+        break;
+
+      case text_op::dsp_imm:
+        out = std::to_chars(out, out + 4, int(op.imm)).ptr;
+        break;
+
+      case text_op::dsp_part:
+      {
+        // register encodings without a register make the instruction invalid
+        if(o->field == pointer)
+        {
+          reserved |= !move || move->pointer == dsp_pointer::none;
+          out = write_text(out, dsp_pointer_name(move ? move->pointer : dsp_pointer::none));
+          break;
+        }
+
+        dsp_register r = dsp_register::none;
+        switch(o->field)
+        {
+          case sx: r = op.sx; break;
+          case sy: r = op.sy; break;
+          case dz: r = op.dz; break;
+          case se: r = op.se; break;
+          case sf: r = op.sf; break;
+          case dg: r = op.dg; break;
+          case data: r = move ? move->data : dsp_register::none; break;
+        }
+        reserved |= r == dsp_register::none;
+        out = write_text(out, dsp_register_name(r));
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return out;
+}
+
+char* disassembler::format_dsp(char* out, uint16_t first, uint16_t second) const
+{
+  dsp_instruction insn;
+  if(!dsp.decode(first, second, insn))
+    return nullptr;
+
+  char* const start = out;
+  bool reserved = false;
+  if(insn.operation.id != invalid_instruction)
+    out = render_dsp(out, dsp_programs[insn.operation.id], insn.operation, nullptr, reserved);
+
+  // the parallel forms leave out the moves that do nothing
+  for(const dsp_move* move : { &insn.x, &insn.y })
+  {
+    if(move->id == invalid_instruction ||
+       (insn.size == 4 && move->addressing == dsp_addressing::none))
+      continue;
+    if(out != start)
+      *out++ = ' ';
+    out = render_dsp(out, dsp_programs[move->id], insn.operation, move, reserved);
+  }
+
+  return reserved ? nullptr : out;
+}
@@ -0,0 +1,104 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include "decoder.h"
+#include "dsp_decoder.h"
+#include "operand_extractor.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// text of decoded instructions, built from the format strings of the database
+// ("mov.l\t@(disp,Rm),Rn" -> "mov.l   @(8,r4),r1").
+// every format string is compiled once into literal and operand slots, so
+// that the text of an instruction is a few copies and number conversions into
+// a buffer of the caller.
+class disassembler
+{
+public:
+  // room the text of one instruction may need
+  static constexpr std::size_t max_text = 128;
+
+  explicit disassembler(isa variant);
+
+  isa variant(void) const { return target; }
+
+  // true for the halfwords that the SH-DSP decoder handles on this variant
+  bool is_dsp(uint16_t first) const { return dsp_enabled && dsp_decoder::is_dsp(first); }
+
+  // writes the text of instruction 'id' to 'out' (max_text bytes) and returns its end.
+  // 'values' as produced by its operand extractor.
+  char* format(char* out, uint16_t id, const operand_values& values, uint32_t address) const;
+
+  // writes the text of an SH-DSP data transfer or parallel instruction,
+  // nullptr if the halfwords are not a valid one
+  char* format_dsp(char* out, uint16_t first, uint16_t second) const;
+
+  void format(std::string& out, uint16_t id, const operand_values& values, uint32_t address) const
+  {
+    char buffer[max_text];
+    out.append(buffer, std::size_t(format(buffer, id, values, address) - buffer));
+  }
+
+  bool format_dsp(std::string& out, uint16_t first, uint16_t second) const
+  {
+    char buffer[max_text];
+    const char* end = format_dsp(buffer, first, second);
+    if(end)
+      out.append(buffer, std::size_t(end - buffer));
+    return end != nullptr;
+  }
+
+  // operand slot of a compiled format
+  struct text_op
+  {
+    enum kind_t : uint8_t
+    {
+      literal,  // 'length' characters of the pool at 'offset'
+      decimal,  // operand value 'field' times 'scale'
+      target,   // hex address of displacement 'field'
+      dsp_part, // SH-DSP register or pointer, see dsp_source
+      dsp_imm,  // SH-DSP shift amount
+    };
+
+    kind_t kind;
+    uint8_t field;
+    int16_t scale;
+    uint16_t offset;
+    uint16_t length;
+  };
+
+  enum dsp_source : uint8_t { sx, sy, dz, se, sf, dg, pointer, data };
+
+private:
+  struct text_program
+  {
+    uint32_t first = 0; // in 'ops'
+    uint32_t count = 0;
+    displacement_info displacement;
+  };
+
+  text_program compile(const std::string& fmt, const operand_extractor& extractor, const displacement_info& disp,
+                       bool dsp_form);
+
+  char* render_dsp(char* out, const text_program& program, const dsp_operation& op, const dsp_move* move,
+                   bool& reserved) const;
+
+  isa target;
+  bool dsp_enabled;
+  std::vector<text_program> programs;     // indexed by instruction id
+  std::vector<text_program> dsp_programs; // the SH-DSP forms, by instruction id
+  std::vector<text_op> ops;
+  std::string pool;                       // literal text of the programs
+  dsp_decoder dsp;
+};
+
+// writes the low 'digits' hex digits of 'value' (lowercase, no prefix)
+char* write_hex(char* out, uint32_t value, int digits);
+
+// appends the low 'digits' hex digits of 'value' (lowercase, no prefix)
+void append_hex(std::string& out, uint32_t value, int digits);
+
+#endif // DISASSEMBLER_H
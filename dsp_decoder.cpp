@@ -0,0 +1,264 @@
+#include "dsp_decoder.h"
+
+#include <string>
+#include <string_view>
+
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+  using R = dsp_register;
+  using P = dsp_pointer;
+
+  // register selections of the operand letters (see format_code())
+  constexpr dsp_register no_registers[16] = {};
+  constexpr dsp_register sx_registers[4] = { R::X0, R::X1, R::A0, R::A1 };
+  constexpr dsp_register sy_registers[4] = { R::Y0, R::Y1, R::M0, R::M1 };
+  constexpr dsp_register du_registers[4] = { R::X0, R::Y0, R::A0, R::A1 };
+  constexpr dsp_register se_registers[4] = { R::X0, R::X1, R::Y0, R::A1 };
+  constexpr dsp_register sf_registers[4] = { R::Y0, R::Y1, R::X0, R::A1 };
+  constexpr dsp_register dg_registers[4] = { R::M0, R::M1, R::A0, R::A1 };
+  constexpr dsp_register dz_registers[16] =
+  {
+    R::none, R::none, R::none, R::none,
+    R::none, R::A1,   R::none, R::A0,
+    R::X0,   R::X1,   R::Y0,   R::Y1,
+    R::M0,   R::A1G,  R::M1,   R::A0G,
+  };
+
+  constexpr dsp_pointer ax_pointers[2] = { P::R4, P::R5 };
+  constexpr dsp_pointer ay_pointers[2] = { P::R6, P::R7 };
+  constexpr dsp_pointer as_pointers[4] = { P::R4, P::R5, P::R2, P::R3 };
+
+  constexpr dsp_register dx_registers[2] = { R::X0, R::X1 };
+  constexpr dsp_register dy_registers[2] = { R::Y0, R::Y1 };
+  constexpr dsp_register da_registers[2] = { R::A0, R::A1 };
+
+  enum class unit { none, x, y, single };
+
+  std::string_view mnemonic_of(const instruction_entry& entry)
+  {
+    std::string_view fmt = entry.source->data<format>();
+    return fmt.substr(0, fmt.find('\t'));
+  }
+
+  unit unit_of(const instruction_entry& entry)
+  {
+    std::string_view m = mnemonic_of(entry);
+    if(m.substr(0, 4) == "movx"sv || m == "nopx"sv)
+      return unit::x;
+    if(m.substr(0, 4) == "movy"sv || m == "nopy"sv)
+      return unit::y;
+    if(m.substr(0, 4) == "movs"sv)
+      return unit::single;
+    return unit::none;
+  }
+
+  dsp_addressing addressing_of(std::string_view memory_operand)
+  {
+    if(memory_operand.find("@-") != std::string_view::npos)
+      return dsp_addressing::pre_decrement;
+    if(memory_operand.find("+I") != std::string_view::npos)
+      return dsp_addressing::index_increment;
+    if(memory_operand.back() == '+')
+      return dsp_addressing::post_increment;
+    return dsp_addressing::indirect;
+  }
+
+  uint32_t field_value(const instruction_entry& entry, char letter, uint32_t word)
+  {
+    for(const operand_field& f : entry.pattern.fields)
+      if(f.letter == letter)
+        return extract_bits(word, f.mask);
+    return 0;
+  }
+
+  dsp_move resolve_move(const instruction_entry& entry, unit u, uint16_t word)
+  {
+    dsp_move move;
+    move.id = entry.id;
+
+    std::string_view fmt = entry.source->data<format>();
+    auto tab = fmt.find('\t');
+    if(tab == std::string_view::npos) // nopx / nopy
+      return move;
+
+    std::string_view operands = fmt.substr(tab + 1);
+    auto comma = operands.find(',');
+    std::string_view source = operands.substr(0, comma);
+    std::string_view destination = operands.substr(comma + 1);
+
+    move.store = destination.front() == '@';
+    move.addressing = addressing_of(move.store ? destination : source);
+
+    uint32_t a = field_value(entry, 'A', word);
+    uint32_t d = field_value(entry, 'D', word);
+    switch(u)
+    {
+      case unit::x:
+        move.pointer = ax_pointers[a];
+        move.data = move.store ? da_registers[d] : dx_registers[d];
+        break;
+      case unit::y:
+        move.pointer = ay_pointers[a];
+        move.data = move.store ? da_registers[d] : dy_registers[d];
+        break;
+      case unit::single:
+        move.pointer = as_pointers[a];
+        move.data = dz_registers[d];
+        break;
+      case unit::none:
+        break;
+    }
+    return move;
+  }
+}
+
+dsp_decoder::dsp_decoder(void)
+  : operation_index(0x10000, invalid_instruction)
+{
+  constexpr isa dsp_sets = SH1_DSP | SH2_DSP | SH3_DSP;
+
+  std::vector<int> operation_specificity(0x10000, -1);
+
+  for(const instruction_entry& entry : instruction_entries())
+  {
+    if(!entry.source->for_isa(dsp_sets) ||
+       !is_dsp(uint16_t(entry.pattern.match >> (entry.pattern.width - 16))))
+      continue;
+
+    if(entry.pattern.width == 16)
+    {
+      unit u = unit_of(entry);
+      for(uint16_t low = 0; low < 0x400; ++low)
+      {
+        uint16_t prefix = u == unit::single ? 0xF400 : 0xF000;
+        uint16_t word = prefix | low;
+        if(!entry.pattern.matches(word))
+          continue;
+        switch(u)
+        {
+          case unit::x:      x_moves[low]      = resolve_move(entry, u, word); break;
+          case unit::y:      y_moves[low]      = resolve_move(entry, u, word); break;
+          case unit::single: single_moves[low] = resolve_move(entry, u, word); break;
+          case unit::none: break;
+        }
+      }
+    }
+    else
+    {
+      operation_format op = {};
+      op.id = entry.id;
+
+      std::string_view fmt = entry.source->data<format>();
+      if(fmt.substr(0, 4) == "dct "sv)
+        op.condition = dsp_condition::dct;
+      else if(fmt.substr(0, 4) == "dcf "sv)
+        op.condition = dsp_condition::dcf;
+
+      operand_decoder none = { no_registers, 0, 0 };
+      op.sx = op.sy = op.dz = op.se = op.sf = op.dg = none;
+
+      for(const operand_field& f : entry.pattern.fields)
+      {
+        uint32_t field_mask = f.mask & 0xFFFF;
+        uint8_t shift = uint8_t(countr_zero(field_mask));
+        operand_decoder dec = { no_registers, shift, uint8_t(field_mask >> shift) };
+        switch(f.letter)
+        {
+          case 'x': dec.map = sx_registers; op.sx = dec; break;
+          case 'y': dec.map = sy_registers; op.sy = dec; break;
+          case 'z': dec.map = dz_registers; op.dz = dec; break;
+          case 'u': dec.map = du_registers; op.dz = dec; break;
+          case 'e': dec.map = se_registers; op.se = dec; break;
+          case 'f': dec.map = sf_registers; op.sf = dec; break;
+          case 'g': dec.map = dg_registers; op.dg = dec; break;
+          case 'i':
+            op.imm_shift = shift;
+            op.imm_width = f.width;
+            break;
+        }
+      }
+
+      uint16_t format_index = uint16_t(operation_formats.size());
+      operation_formats.push_back(op);
+
+      // enumerate every second halfword this pattern accepts
+      const uint16_t fixed = uint16_t(entry.pattern.mask);
+      const uint16_t value = uint16_t(entry.pattern.match);
+      const uint16_t free_bits = uint16_t(~fixed);
+      const int spec = specificity(entry.pattern);
+      uint16_t sub = free_bits;
+      do
+      {
+        uint16_t word = value | sub;
+        if(operation_specificity[word] < spec)
+        {
+          operation_specificity[word] = spec;
+          operation_index[word] = format_index;
+        }
+        sub = uint16_t((sub - 1) & free_bits);
+      } while(sub != free_bits);
+    }
+  }
+}
+
+bool dsp_decoder::decode(uint16_t first, uint16_t second, dsp_instruction& out) const
+{
+  out = dsp_instruction();
+  switch(first >> 10)
+  {
+    case 0x3C: // 111100: double data transfer
+      out.size = 2;
+      out.x = x_moves[first & 0x3FF];
+      out.y = y_moves[first & 0x3FF];
+      return out.x.id != invalid_instruction && out.y.id != invalid_instruction;
+
+    case 0x3D: // 111101: single data transfer
+      out.size = 2;
+      out.x = single_moves[first & 0x3FF];
+      return out.x.id != invalid_instruction;
+
+    case 0x3E: // 111110: parallel operation
+    {
+      out.size = 4;
+      out.x = x_moves[first & 0x3FF];
+      out.y = y_moves[first & 0x3FF];
+
+      uint16_t index = operation_index[second];
+      if(index == invalid_instruction)
+        return false;
+
+      const operation_format& f = operation_formats[index];
+      dsp_operation& op = out.operation;
+      op.id = f.id;
+      op.condition = f.condition;
+      op.sx = f.sx.map[(second >> f.sx.shift) & f.sx.mask];
+      op.sy = f.sy.map[(second >> f.sy.shift) & f.sy.mask];
+      op.dz = f.dz.map[(second >> f.dz.shift) & f.dz.mask];
+      op.se = f.se.map[(second >> f.se.shift) & f.se.mask];
+      op.sf = f.sf.map[(second >> f.sf.shift) & f.sf.mask];
+      op.dg = f.dg.map[(second >> f.dg.shift) & f.dg.mask];
+      if(f.imm_width)
+      {
+        uint32_t raw = (second >> f.imm_shift) & ((1u << f.imm_width) - 1);
+        uint32_t sign = 1u << (f.imm_width - 1);
+        op.imm = int8_t((raw ^ sign) - sign);
+      }
+      return out.x.id != invalid_instruction && out.y.id != invalid_instruction;
+    }
+  }
+  return false;
+}
+
+const char* dsp_register_name(dsp_register reg)
+{
+  constexpr const char* names[] = { "", "x0", "x1", "y0", "y1", "m0", "m1", "a0", "a1", "a0g", "a1g" };
+  return names[uint8_t(reg)];
+}
+
+const char* dsp_pointer_name(dsp_pointer ptr)
+{
+  constexpr const char* names[] = { "", "r2", "r3", "r4", "r5", "r6", "r7" };
+  return names[uint8_t(ptr)];
+}
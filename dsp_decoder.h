@@ -0,0 +1,114 @@
+#ifndef DSP_DECODER_H
+#define DSP_DECODER_H
+
+#include "decoder.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+enum class dsp_register : uint8_t
+{
+  none = 0,
+  X0, X1,
+  Y0, Y1,
+  M0, M1,
+  A0, A1,
+  A0G, A1G,
+};
+
+enum class dsp_pointer : uint8_t
+{
+  none = 0,
+  R2, R3, // As only
+  R4, R5, // Ax, As
+  R6, R7, // Ay
+};
+
+enum class dsp_addressing : uint8_t
+{
+  none = 0,
+  indirect,        // @Ax
+  post_increment,  // @Ax+
+  index_increment, // @Ax+Ix (Ix = R8, Iy = R9, Is = R8)
+  pre_decrement,   // @-As
+};
+
+enum class dsp_condition : uint8_t
+{
+  always = 0,
+  dct,  // execute if DC = 1
+  dcf,  // execute if DC = 0
+};
+
+struct dsp_move
+{
+  uint16_t id = invalid_instruction; // nopx/nopy/movx/movy/movs entry
+  dsp_addressing addressing = dsp_addressing::none;
+  dsp_pointer pointer = dsp_pointer::none; // Ax, Ay or As
+  dsp_register data = dsp_register::none;  // Dx, Dy, Da or Ds
+  bool store = false;                      // register to memory
+};
+
+struct dsp_operation
+{
+  uint16_t id = invalid_instruction;
+  dsp_condition condition = dsp_condition::always;
+  dsp_register sx = dsp_register::none;
+  dsp_register sy = dsp_register::none;
+  dsp_register dz = dsp_register::none; // Dz, or Du of the combined multiply forms
+  dsp_register se = dsp_register::none;
+  dsp_register sf = dsp_register::none;
+  dsp_register dg = dsp_register::none;
+  int8_t imm = 0;                       // psha/pshl shift amount
+};
+
+struct dsp_instruction
+{
+  uint8_t size = 0;        // instruction size in bytes
+  dsp_move x;              // X memory move, or the movs single transfer
+  dsp_move y;              // Y memory move
+  dsp_operation operation; // ALU/multiplier part of 32-bit instructions
+};
+
+// decodes SH-DSP instructions into their parallel components.
+// the tables are generated from the DSP sections of the database.
+class dsp_decoder
+{
+public:
+  dsp_decoder(void);
+
+  // 'second' is only examined when 'first' starts a 32-bit instruction
+  bool decode(uint16_t first, uint16_t second, dsp_instruction& out) const;
+
+  static constexpr bool is_dsp(uint16_t first) { return (first & 0xF000) == 0xF000 && (first & 0x0C00) != 0x0C00; }
+  static constexpr bool is_parallel(uint16_t first) { return (first & 0xFC00) == 0xF800; }
+
+private:
+  struct operand_decoder
+  {
+    const dsp_register* map;
+    uint8_t shift;
+    uint8_t mask;
+  };
+
+  struct operation_format
+  {
+    uint16_t id;
+    dsp_condition condition;
+    operand_decoder sx, sy, dz, se, sf, dg;
+    uint8_t imm_shift;
+    uint8_t imm_width; // zero when there is no immediate
+  };
+
+  std::array<dsp_move, 0x400> x_moves;      // indexed by the low 10 bits of a 111100/111110 halfword
+  std::array<dsp_move, 0x400> y_moves;
+  std::array<dsp_move, 0x400> single_moves; // indexed by the low 10 bits of a 111101 halfword
+  std::vector<uint16_t> operation_index;    // indexed by the second halfword
+  std::vector<operation_format> operation_formats;
+};
+
+const char* dsp_register_name(dsp_register reg);
+const char* dsp_pointer_name(dsp_pointer ptr);
+
+#endif // DSP_DECODER_H
@@ -0,0 +1,399 @@
+#include "dsp_unit.h"
+
+#include <algorithm>
+#include <string_view>
+
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+  using R = dsp_register;
+
+  constexpr uint32_t sr_s = 0x00000002;
+  constexpr uint32_t sr_dmx = 0x00000400;
+  constexpr uint32_t sr_dmy = 0x00000800;
+
+  // how the DC bit follows the CS bits of DSR (the *_dc_bit functions of the
+  // manual)
+  enum dc_kind { arithmetic, logical, shift };
+
+  int64_t sign_extend_40(int64_t value) { return int64_t(uint64_t(value) << 24) >> 24; }
+
+  bool fits_32(int64_t value) { return value == int32_t(value); }
+
+  // a + b + carry or a - b - borrow on 40 bits, with the carry or borrow
+  // out of bit 31 and the overflow out of 40 or 32 bits
+  int64_t add(int64_t a, int64_t b, uint32_t carry_in, bool subtract, uint32_t& carry, uint32_t& overflow)
+  {
+    const int64_t exact = subtract ? a - b - carry_in : a + b + carry_in;
+    const uint64_t low = subtract ? uint64_t(uint32_t(a)) - uint32_t(b) - carry_in
+                                  : uint64_t(uint32_t(a)) + uint32_t(b) + carry_in;
+    const int64_t value = sign_extend_40(exact);
+    carry = uint32_t(low >> 32) & 1;
+    overflow = value != exact || !fits_32(value);
+    return value;
+  }
+
+  // overflow protection with SR.S: results out of 32 bits go to the largest
+  // or smallest 32-bit value, and there is no overflow any more
+  int64_t saturate(int64_t value, uint32_t& overflow, bool enabled)
+  {
+    if(!enabled || !overflow)
+      return value;
+    overflow = 0;
+    return fits_32(value) ? value : value < 0 ? INT32_MIN : INT32_MAX;
+  }
+}
+
+dsp_unit::dsp_unit(cpu_state& state, guest_memory& memory, std::function<void(uint32_t)> on_write)
+  : cpu(state), mem(memory), written(std::move(on_write)), operations(instruction_entries().size(), alu::none),
+    multiplies(instruction_entries().size()), long_moves(instruction_entries().size()),
+    registers{ { &no_register, &cpu.X0, &cpu.X1, &cpu.Y0, &cpu.Y1, &cpu.M0, &cpu.M1, &cpu.A0, &cpu.A1, &cpu.A0G,
+                 &cpu.A1G } }
+{
+  static const std::pair<std::string_view, alu> names[] =
+  {
+    { "pabs"sv, alu::pabs }, { "padd"sv, alu::padd }, { "paddc"sv, alu::paddc }, { "pclr"sv, alu::pclr },
+    { "pcmp"sv, alu::pcmp }, { "pcopy"sv, alu::pcopy }, { "pneg"sv, alu::pneg }, { "psub"sv, alu::psub },
+    { "psubc"sv, alu::psubc }, { "pdec"sv, alu::pdec }, { "pinc"sv, alu::pinc }, { "pdmsb"sv, alu::pdmsb },
+    { "prnd"sv, alu::prnd }, { "pand"sv, alu::pand }, { "por"sv, alu::por }, { "pxor"sv, alu::pxor },
+    { "psha"sv, alu::psha }, { "pshl"sv, alu::pshl }, { "plds"sv, alu::plds_mach }, { "psts"sv, alu::psts_mach },
+  };
+
+  for(const instruction_entry& entry : instruction_entries())
+  {
+    std::string_view fmt = entry.source->data<format>();
+    if(fmt.substr(0, 4) == "dct "sv || fmt.substr(0, 4) == "dcf "sv)
+      fmt.remove_prefix(4);
+    const std::string_view mnemonic = fmt.substr(0, fmt.find('\t'));
+    const std::string_view operands = fmt.substr(mnemonic.size());
+
+    multiplies[entry.id] = fmt.find("pmuls"sv) != std::string_view::npos;
+    long_moves[entry.id] = mnemonic == "movs.l"sv;
+    for(const auto& name : names)
+      if(mnemonic == name.first)
+      {
+        alu op = name.second;
+        if((op == alu::psha || op == alu::pshl) && operands.find('#') != std::string_view::npos)
+          op = op == alu::psha ? alu::psha_imm : alu::pshl_imm;
+        else if((op == alu::plds_mach || op == alu::psts_mach) && operands.find("MACL"sv) != std::string_view::npos)
+          op = op == alu::plds_mach ? alu::plds_macl : alu::psts_macl;
+        operations[entry.id] = op;
+      }
+  }
+}
+
+const dsp_unit::step& dsp_unit::decode(uint32_t word)
+{
+  step& s = cache[(word ^ word >> 16) & (cache.size() - 1)];
+  if(s.word == word)
+    return s;
+
+  if(!decoder)
+    decoder.reset(new dsp_decoder());
+  s = step();
+  const bool wide = word > 0xFFFF;
+  if(!decoder->decode(uint16_t(wide ? word >> 16 : word), uint16_t(word), s.insn) || s.insn.size != (wide ? 4 : 2))
+    return s;
+
+  s.single = !wide && (word & 0xFC00) == 0xF400;
+  if(s.single && s.insn.x.data == R::none)
+    return s; // reserved Ds
+  s.operation = wide ? operations[s.insn.operation.id] : alu::none;
+  s.multiply = wide && multiplies[s.insn.operation.id];
+  s.size = s.single && long_moves[s.insn.x.id] ? 4 : 2;
+  s.word = word;
+  return s;
+}
+
+int64_t dsp_unit::value_of(dsp_register r) const
+{
+  const uint32_t low = *registers[uint8_t(r)];
+  if(r == R::A0 || r == R::A1)
+  {
+    const int8_t guard = int8_t(r == R::A0 ? cpu.A0G : cpu.A1G);
+    return int64_t(uint64_t(int64_t(guard)) << 32 | low);
+  }
+  return int32_t(low);
+}
+
+void dsp_unit::set(dsp_register r, int64_t value)
+{
+  if(r == R::A0G || r == R::A1G)
+    value = int8_t(value);
+  *registers[uint8_t(r)] = uint32_t(value);
+  if(r == R::A0)
+    cpu.A0G = uint32_t(int32_t(int8_t(value >> 32)));
+  else if(r == R::A1)
+    cpu.A1G = uint32_t(int32_t(int8_t(value >> 32)));
+}
+
+uint32_t dsp_unit::next_address(uint32_t address, dsp_addressing addressing, uint32_t step, uint32_t index,
+                                bool modulo) const
+{
+  switch(addressing)
+  {
+    case dsp_addressing::post_increment: break;
+    case dsp_addressing::index_increment: step = index; break;
+    default: return address;
+  }
+  // at the modulo end (MOD bits 31-16) back to the start (bits 15-0)
+  if(modulo && (address & 0xFFFF) == cpu.MOD >> 16)
+    return (address & 0xFFFF0000) | (cpu.MOD & 0xFFFF);
+  return address + step;
+}
+
+bool dsp_unit::execute(uint32_t word)
+{
+  const step& s = decode(word);
+  if(s.word != word)
+    return false;
+  const dsp_move& x = s.insn.x;
+  const dsp_move& y = s.insn.y;
+
+  // the transfers: addresses, stores and loads with the registers before
+  // the step
+  uint32_t x_address = 0;
+  uint32_t y_address = 0;
+  uint32_t x_data = 0;
+  uint32_t y_data = 0;
+  if(x.addressing != dsp_addressing::none)
+  {
+    x_address = pointer(x.pointer) - (x.addressing == dsp_addressing::pre_decrement ? s.size : 0);
+    if(x.store)
+    {
+      const uint32_t data = *registers[uint8_t(x.data)];
+      if(s.size == 4)
+        mem.write_32(x_address, data);
+      else
+        mem.write_16(x_address, x.data == R::A0G || x.data == R::A1G ? data : data >> 16);
+      written(x_address);
+    }
+    else
+      x_data = s.size == 4 ? mem.read_32(x_address) : mem.read_16(x_address);
+  }
+  if(y.addressing != dsp_addressing::none)
+  {
+    y_address = pointer(y.pointer);
+    if(y.store)
+    {
+      mem.write_16(y_address, *registers[uint8_t(y.data)] >> 16);
+      written(y_address);
+    }
+    else
+      y_data = mem.read_16(y_address);
+  }
+
+  // the multiplier and the ALU on the same registers
+  dsp_register mul_dg = R::none;
+  int64_t mul_result = 0;
+  if(s.multiply)
+  {
+    const dsp_operation& op = s.insn.operation;
+    const int32_t se = int16_t(*registers[uint8_t(op.se)] >> 16);
+    const int32_t sf = int16_t(*registers[uint8_t(op.sf)] >> 16);
+    mul_dg = op.dg;
+    mul_result = (cpu.SR & sr_s) && se == -0x8000 && sf == -0x8000 ? INT32_MAX : int32_t(uint32_t(se * sf) << 1);
+  }
+  dsp_register alu_dz = R::none;
+  int64_t alu_result = 0;
+  if(s.operation != alu::none)
+    run_alu(s.insn.operation, s.operation, alu_dz, alu_result);
+
+  // then the registers: loaded data, the product and the ALU result
+  if(x.addressing != dsp_addressing::none && !x.store)
+  {
+    if(x.data == R::A0G || x.data == R::A1G)
+      set(x.data, x_data);
+    else
+      set(x.data, int32_t(s.size == 4 ? x_data : x_data << 16));
+  }
+  if(y.addressing != dsp_addressing::none && !y.store)
+    set(y.data, int32_t(y_data << 16));
+  set(mul_dg, mul_result);
+  set(alu_dz, alu_result);
+
+  // and the pointers.  modulo addressing is for X with SR.DMX, for Y with
+  // SR.DMY, and only for Y when both are set
+  if(s.single)
+  {
+    if(x.addressing == dsp_addressing::pre_decrement)
+      pointer(x.pointer) = x_address;
+    else
+      pointer(x.pointer) = next_address(x_address, x.addressing, s.size, cpu.R[8], false);
+  }
+  else
+  {
+    if(x.addressing != dsp_addressing::none)
+      pointer(x.pointer) = next_address(x_address, x.addressing, 2, cpu.R[8], (cpu.SR & (sr_dmx | sr_dmy)) == sr_dmx);
+    if(y.addressing != dsp_addressing::none)
+      pointer(y.pointer) = next_address(y_address, y.addressing, 2, cpu.R[9], cpu.SR & sr_dmy);
+  }
+  no_register = 0;
+  return true;
+}
+
+void dsp_unit::run_alu(const dsp_operation& op, alu operation, dsp_register& dz, int64_t& result)
+{
+  // dct and dcf run with DC set or clear and leave DSR as it is
+  const uint32_t dc = cpu.DSR & 1;
+  const bool conditional = op.condition != dsp_condition::always;
+  if(conditional && dc != (op.condition == dsp_condition::dct))
+    return;
+
+  const bool saturating = cpu.SR & sr_s;
+  const int64_t sx = value_of(op.sx);
+  const int64_t sy = value_of(op.sy);
+  const int64_t source = op.sx != R::none ? sx : sy; // single operand forms
+  const bool wide = op.dz == R::none || op.dz == R::A0 || op.dz == R::A1; // N and Z of 40 bits
+
+  uint32_t carry = 0;
+  uint32_t overflow = 0;
+  int64_t value = 0;
+  dc_kind kind = arithmetic;
+  bool dc_is_carry = false; // paddc and psubc
+  bool writes = true;
+  uint32_t negative = 2;    // 0 or 1 when not from 'value'
+  uint32_t zero = 2;
+
+  switch(operation)
+  {
+    case alu::pabs:
+      value = add(source < 0 ? 0 : source, source < 0 ? source : 0, 0, source < 0, carry, overflow);
+      value = saturate(value, overflow, saturating);
+      break;
+    case alu::padd:
+    case alu::paddc:
+    case alu::psub:
+    case alu::psubc:
+    case alu::pcmp:
+    {
+      const bool with_dc = operation == alu::paddc || operation == alu::psubc;
+      const bool subtract = operation == alu::psub || operation == alu::psubc || operation == alu::pcmp;
+      value = add(sx, sy, with_dc ? dc : 0, subtract, carry, overflow);
+      value = saturate(value, overflow, saturating);
+      dc_is_carry = with_dc;
+      writes = operation != alu::pcmp;
+      break;
+    }
+    case alu::pcopy:
+    case alu::pneg:
+      value = operation == alu::pneg ? add(0, source, 0, true, carry, overflow) : add(source, 0, 0, false, carry, overflow);
+      value = saturate(value, overflow, saturating);
+      break;
+    case alu::pclr:
+      break;
+    case alu::pinc:
+    case alu::pdec:
+      // on the upper word and the guard bits, the lower word cleared
+      value = add(source & ~int64_t(0xFFFF), 0x10000, 0, operation == alu::pdec, carry, overflow);
+      value = saturate(value, overflow, saturating) & ~int64_t(0xFFFF);
+      break;
+    case alu::pdmsb:
+    {
+      // the position of the most significant bit that differs from the sign
+      const uint64_t bits = uint64_t(source < 0 ? ~source : source);
+      int msb = 38;
+      while(msb >= 0 && !(bits >> msb & 1))
+        --msb;
+      value = int64_t(int16_t(30 - msb)) * 0x10000;
+      break;
+    }
+    case alu::prnd:
+      value = add(source, 0x8000, 0, false, carry, overflow) & ~int64_t(0xFFFF);
+      value = saturate(value, overflow, saturating);
+      break;
+    case alu::pand:
+    case alu::por:
+    case alu::pxor:
+    {
+      // the upper words, with the lower word and the guard bits cleared
+      const uint32_t a = uint32_t(sx >> 16) & 0xFFFF;
+      const uint32_t b = uint32_t(sy >> 16) & 0xFFFF;
+      const uint32_t r = operation == alu::pand ? a & b : operation == alu::por ? a | b : a ^ b;
+      value = int64_t(r) << 16;
+      negative = r >> 15;
+      zero = r == 0;
+      kind = logical;
+      break;
+    }
+    case alu::pshl:
+    case alu::pshl_imm:
+    {
+      // logical, of the upper word by -16 to +16 bits
+      const int count = std::clamp(operation == alu::pshl_imm ? op.imm : int8_t(uint8_t(sy >> 14) & 0xFC) >> 2, -16, 16);
+      const uint32_t a = uint32_t((operation == alu::pshl_imm ? value_of(op.dz) : sx) >> 16) & 0xFFFF;
+      uint32_t r;
+      if(count >= 0)
+      {
+        r = a << count & 0xFFFF;
+        carry = count ? a >> (16 - count) & 1 : 0;
+      }
+      else
+      {
+        r = a >> -count;
+        carry = a >> (-count - 1) & 1;
+      }
+      value = int64_t(r) << 16;
+      negative = r >> 15;
+      zero = r == 0;
+      kind = shift;
+      break;
+    }
+    case alu::psha:
+    case alu::psha_imm:
+    {
+      // arithmetic, of the 40 bits by -32 to +32 bits
+      const int count = std::clamp(operation == alu::psha_imm ? op.imm : int8_t(uint8_t(sy >> 15) & 0xFE) >> 1, -32, 32);
+      const int64_t a = operation == alu::psha_imm ? value_of(op.dz) : sx;
+      if(count >= 0)
+      {
+        const uint64_t shifted = uint64_t(a) << count;
+        value = sign_extend_40(int64_t(shifted));
+        carry = uint32_t(shifted >> 32) & 1;
+      }
+      else
+      {
+        value = a >> -count;
+        carry = uint32_t(a) >> (-count - 1) & 1;
+      }
+      overflow = !fits_32(value);
+      value = saturate(value, overflow, saturating);
+      kind = shift;
+      break;
+    }
+    case alu::plds_mach:
+    case alu::plds_macl:
+      (operation == alu::plds_mach ? cpu.MACH : cpu.MACL) = uint32_t(value_of(op.dz));
+      return;
+    case alu::psts_mach:
+    case alu::psts_macl:
+      dz = op.dz;
+      result = int32_t(operation == alu::psts_mach ? cpu.MACH : cpu.MACL);
+      return;
+    case alu::none:
+      return;
+  }
+
+  if(writes)
+  {
+    dz = op.dz;
+    result = value;
+  }
+  if(conditional)
+    return;
+
+  // DSR: GT, Z, N, V and DC as the CS bits select
+  if(negative > 1)
+    negative = wide ? uint32_t(uint64_t(value) >> 39) & 1 : uint32_t(value) >> 31;
+  if(zero > 1)
+    zero = wide ? (value & 0xFFFFFFFFFF) == 0 : uint32_t(value) == 0;
+  const uint32_t greater = kind == arithmetic ? !((negative ^ overflow) | zero) : 0;
+  const uint32_t conditions[8] =
+  {
+    kind == logical ? 0 : carry, negative, zero, kind == logical ? 0 : overflow, greater,
+    kind == arithmetic ? uint32_t(!(negative ^ overflow)) : 0, dc, dc,
+  };
+  const uint32_t new_dc = dc_is_carry ? carry : conditions[(cpu.DSR >> 1) & 7];
+  cpu.DSR = (cpu.DSR & 0x0E) | greater << 7 | zero << 6 | negative << 5 | overflow << 4 | new_dc;
+}
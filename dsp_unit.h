@@ -0,0 +1,84 @@
+#ifndef DSP_UNIT_H
+#define DSP_UNIT_H
+
+#include "dsp_decoder.h"
+#include "interpreter.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// the DSP unit of the SH-DSP variants: runs the X and Y (or single) data
+// transfers and the ALU and multiplier operations of a DSP instruction in one
+// step, on the DSP registers of cpu_state.  as in the operation descriptions
+// of the manual, the operations read their sources and the stores their data
+// before any register is written, and the pointers are updated last.
+//
+// the ALU works on 40 bits (the accumulators with their guard bits, the
+// other registers sign extended) in 64-bit host integers, saturates with
+// SR.S and sets the DSR flags and the DC bit of the CS mode.  instructions
+// are decoded by dsp_decoder once into a small cache by instruction word.
+// the interpreter of the DSP variants creates it at the first DSP
+// instruction; the setrc repeat loops stay with the interpreter.
+class dsp_unit
+{
+public:
+  // 'written' gets the address of every store
+  dsp_unit(cpu_state& cpu, guest_memory& memory, std::function<void(uint32_t)> written);
+
+  // runs a DSP instruction: 16-bit forms in the low half of 'word', 32-bit
+  // ones with the first halfword on top.  false when the word is no DSP
+  // instruction, and nothing has run.
+  bool execute(uint32_t word);
+
+private:
+  // the ALU part of a 32-bit instruction, by the mnemonic of its entry
+  enum class alu : uint8_t
+  {
+    none,
+    pabs, padd, paddc, pclr, pcmp, pcopy, pneg, psub, psubc,
+    pdec, pinc, pdmsb, prnd,
+    pand, por, pxor,
+    psha, psha_imm, pshl, pshl_imm,
+    plds_mach, plds_macl, psts_mach, psts_macl,
+  };
+
+  struct step
+  {
+    uint32_t word = 0; // never a DSP instruction
+    dsp_instruction insn;
+    alu operation = alu::none;
+    bool single = false;   // movs
+    bool multiply = false; // pmuls, alone or with padd/psub
+    uint32_t size = 2;     // of the transfers, 4 for movs.l
+  };
+
+  const step& decode(uint32_t word);
+
+  // a register as a 40-bit value, and set from one: the guard bits of A0
+  // and A1 from bits 39-32, the low byte for A0G and A1G
+  int64_t value_of(dsp_register r) const;
+  void set(dsp_register r, int64_t value);
+
+  // the ALU operation, with the register it writes left in 'dz' and 'result'
+  // (dz is none when it writes nothing)
+  void run_alu(const dsp_operation& op, alu operation, dsp_register& dz, int64_t& result);
+
+  uint32_t& pointer(dsp_pointer p) { return cpu.R[uint8_t(p) + 1]; }
+  uint32_t next_address(uint32_t address, dsp_addressing addressing, uint32_t step, uint32_t index, bool modulo) const;
+
+  cpu_state& cpu;
+  guest_memory& mem;
+  std::function<void(uint32_t)> written;
+  std::unique_ptr<dsp_decoder> decoder;  // built on the first instruction
+  std::vector<alu> operations;           // by instruction id
+  std::vector<bool> multiplies;          // by instruction id
+  std::vector<bool> long_moves;          // by instruction id
+  std::array<uint32_t*, 11> registers;   // by dsp_register
+  uint32_t no_register = 0;
+  std::array<step, 1024> cache;          // direct mapped by instruction word
+};
+
+#endif // DSP_UNIT_H
@@ -0,0 +1,240 @@
+#include "fpu_kernels.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define HAVE_SSE_KERNELS
+#endif
+
+namespace
+{
+  constexpr double pi = 3.14159265358979323846;
+  constexpr uint32_t default_nan = 0x7FBFFFFF;
+
+  // the value of a register, denormals as zero
+  double value_of(uint32_t bits)
+  {
+    if((bits & 0x7F800000) == 0)
+      bits &= 0x80000000;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // rounded to single precision, denormals flushed to zero
+  uint32_t bits_of(double value)
+  {
+    if(std::isnan(value))
+      return default_nan;
+    const float rounded = float(value);
+    uint32_t bits;
+    std::memcpy(&bits, &rounded, sizeof(bits));
+    if((bits & 0x7F800000) == 0)
+      bits &= 0x80000000;
+    return bits;
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void fipr_reference(uint32_t* fr, unsigned m, unsigned n)
+{
+  double sum = 0.0;
+  for(unsigned k = 0; k < 4; ++k)
+    sum += value_of(fr[m + k]) * value_of(fr[n + k]);
+  fr[n + 3] = bits_of(sum);
+}
+
+void ftrv_reference(uint32_t* fr, const uint32_t* xf, unsigned n)
+{
+  double result[4];
+  for(unsigned row = 0; row < 4; ++row)
+  {
+    result[row] = 0.0;
+    for(unsigned column = 0; column < 4; ++column)
+      result[row] += value_of(xf[row + 4 * column]) * value_of(fr[n + column]);
+  }
+  for(unsigned row = 0; row < 4; ++row)
+    fr[n + row] = bits_of(result[row]);
+}
+
+// from the quadrant, so that the multiples of pi / 2 give exact zeros (0 - x
+// keeps them positive)
+void fsca_reference(uint32_t* fr, unsigned n, uint32_t fpul)
+{
+  const uint32_t quadrant = (fpul >> 14) & 3;
+  const double angle = (fpul & 0x3FFF) * (pi / 32768);
+  const double s = std::sin(angle);
+  const double c = std::cos(angle);
+  fr[n] = bits_of(quadrant == 0 ? s : quadrant == 1 ? c : quadrant == 2 ? 0.0 - s : 0.0 - c);
+  fr[n + 1] = bits_of(quadrant == 0 ? c : quadrant == 1 ? 0.0 - s : quadrant == 2 ? 0.0 - c : s);
+}
+
+void fsrra_reference(uint32_t* fr, unsigned n)
+{
+  const double value = value_of(fr[n]);
+  if(value == 0.0)
+    fr[n] = (fr[n] & 0x80000000) | 0x7F800000; // division by zero, infinity of the sign
+  else
+    fr[n] = bits_of(1.0 / std::sqrt(value)); // NaN when negative, 0 for +infinity
+}
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_SSE_KERNELS)
+namespace
+{
+  // lanes that hold an infinity, a NaN or a denormal
+  inline int special_lanes(__m128i bits)
+  {
+    const __m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x7F800000));
+    const __m128i fraction = _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF));
+    const __m128i top = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7F800000));
+    const __m128i denormal = _mm_andnot_si128(_mm_cmpeq_epi32(fraction, _mm_setzero_si128()),
+                                              _mm_cmpeq_epi32(exponent, _mm_setzero_si128()));
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(top, denormal)));
+  }
+
+  // lanes that overflowed (or are NaN)
+  inline int infinite_lanes(__m128 value)
+  {
+    const __m128i exponent = _mm_and_si128(_mm_castps_si128(value), _mm_set1_epi32(0x7F800000));
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7F800000))));
+  }
+
+  // denormal lanes to the zero of their sign
+  inline __m128i flush_denormals(__m128 value)
+  {
+    const __m128i bits = _mm_castps_si128(value);
+    const __m128i tiny = _mm_cmpeq_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7F800000)), _mm_setzero_si128());
+    return _mm_andnot_si128(_mm_and_si128(tiny, _mm_set1_epi32(0x7FFFFFFF)), bits);
+  }
+
+  inline __m128i load(const uint32_t* fr)
+  {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(fr));
+  }
+}
+
+void fipr_sse(uint32_t* fr, unsigned m, unsigned n)
+{
+  const __m128i a = load(fr + m);
+  const __m128i b = load(fr + n);
+  if(special_lanes(a) | special_lanes(b))
+    return fipr_reference(fr, m, n);
+
+  const __m128 product = _mm_mul_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b));
+  __m128 sum = _mm_add_ps(product, _mm_movehl_ps(product, product));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  if(infinite_lanes(sum) & 1)
+    return fipr_reference(fr, m, n);
+  fr[n + 3] = uint32_t(_mm_cvtsi128_si32(flush_denormals(sum)));
+}
+
+void ftrv_sse(uint32_t* fr, const uint32_t* xf, unsigned n)
+{
+  const __m128i vector = load(fr + n);
+  const __m128i column[4] = { load(xf), load(xf + 4), load(xf + 8), load(xf + 12) };
+  if(special_lanes(vector) | special_lanes(column[0]) | special_lanes(column[1]) | special_lanes(column[2]) |
+     special_lanes(column[3]))
+    return ftrv_reference(fr, xf, n);
+
+  // the columns scaled by the elements of the vector
+  const __m128 v = _mm_castsi128_ps(vector);
+  const __m128 low = _mm_add_ps(_mm_mul_ps(_mm_castsi128_ps(column[0]), _mm_shuffle_ps(v, v, 0x00)),
+                                _mm_mul_ps(_mm_castsi128_ps(column[1]), _mm_shuffle_ps(v, v, 0x55)));
+  const __m128 high = _mm_add_ps(_mm_mul_ps(_mm_castsi128_ps(column[2]), _mm_shuffle_ps(v, v, 0xAA)),
+                                 _mm_mul_ps(_mm_castsi128_ps(column[3]), _mm_shuffle_ps(v, v, 0xFF)));
+  const __m128 result = _mm_add_ps(low, high);
+  if(infinite_lanes(result))
+    return ftrv_reference(fr, xf, n);
+  _mm_store_si128(reinterpret_cast<__m128i*>(fr + n), flush_denormals(result));
+}
+
+// sin in lane 0 and cos in lane 1 of the angle within its quadrant, from
+// their Taylor series to the 13th and 12th power (error below 1e-8 up to
+// pi / 2), then moved to the quadrant
+void fsca_sse(uint32_t* fr, unsigned n, uint32_t fpul)
+{
+  alignas(16) static const float series[7][4] =
+  {
+    { 1.0f / 6227020800.0f, 1.0f / 479001600.0f, 0.0f, 0.0f },
+    { -1.0f / 39916800.0f, -1.0f / 3628800.0f, 0.0f, 0.0f },
+    { 1.0f / 362880.0f, 1.0f / 40320.0f, 0.0f, 0.0f },
+    { -1.0f / 5040.0f, -1.0f / 720.0f, 0.0f, 0.0f },
+    { 1.0f / 120.0f, 1.0f / 24.0f, 0.0f, 0.0f },
+    { -1.0f / 6.0f, -1.0f / 2.0f, 0.0f, 0.0f },
+    { 1.0f, 1.0f, 0.0f, 0.0f },
+  };
+  // sin, cos of the quadrants: (s, c), (c, -s), (-s, -c), (-c, s)
+  alignas(16) static const uint32_t signs[4][4] =
+  {
+    { 0, 0, 0, 0 },
+    { 0, 0x80000000, 0, 0 },
+    { 0x80000000, 0x80000000, 0, 0 },
+    { 0x80000000, 0, 0, 0 },
+  };
+
+  const uint32_t angle = fpul & 0xFFFF;
+  const uint32_t quadrant = angle >> 14;
+  const float r = float(angle & 0x3FFF) * float(pi / 32768);
+  const __m128 z = _mm_set1_ps(r * r);
+
+  __m128 p = _mm_load_ps(series[0]);
+  for(int k = 1; k < 7; ++k)
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_load_ps(series[k]));
+  p = _mm_mul_ps(p, _mm_setr_ps(r, 1.0f, 0.0f, 0.0f));
+
+  const __m128 swap = _mm_castsi128_ps(_mm_set1_epi32(-int32_t(quadrant & 1)));
+  p = _mm_or_ps(_mm_and_ps(swap, _mm_shuffle_ps(p, p, 0xE1)), _mm_andnot_ps(swap, p));
+  // zeros stay positive
+  const __m128i sign = _mm_andnot_si128(_mm_castps_si128(_mm_cmpeq_ps(p, _mm_setzero_ps())), load(signs[quadrant]));
+  const __m128i result = _mm_xor_si128(_mm_castps_si128(p), sign);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(fr + n), result);
+}
+
+// one Newton-Raphson step on the 12-bit estimate of rsqrtss
+void fsrra_sse(uint32_t* fr, unsigned n)
+{
+  if(fr[n] - 0x00800000 >= 0x7F000000) // not a positive normal number
+    return fsrra_reference(fr, n);
+
+  const __m128 x = _mm_castsi128_ps(_mm_cvtsi32_si128(int32_t(fr[n])));
+  const __m128 y = _mm_rsqrt_ss(x);
+  const __m128 step = _mm_sub_ss(_mm_set_ss(3.0f), _mm_mul_ss(_mm_mul_ss(x, y), y));
+  const __m128 result = _mm_mul_ss(_mm_mul_ss(_mm_set_ss(0.5f), y), step);
+  fr[n] = uint32_t(_mm_cvtsi128_si32(_mm_castps_si128(result)));
+}
+
+bool has_sse_fpu_kernels(void)
+{
+  return true;
+}
+#else
+void fipr_sse(uint32_t* fr, unsigned m, unsigned n)
+{
+  fipr_reference(fr, m, n);
+}
+
+void ftrv_sse(uint32_t* fr, const uint32_t* xf, unsigned n)
+{
+  ftrv_reference(fr, xf, n);
+}
+
+void fsca_sse(uint32_t* fr, unsigned n, uint32_t fpul)
+{
+  fsca_reference(fr, n, fpul);
+}
+
+void fsrra_sse(uint32_t* fr, unsigned n)
+{
+  fsrra_reference(fr, n);
+}
+
+bool has_sse_fpu_kernels(void)
+{
+  return false;
+}
+#endif
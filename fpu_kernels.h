@@ -0,0 +1,37 @@
+#ifndef FPU_KERNELS_H
+#define FPU_KERNELS_H
+
+#include <cstdint>
+
+// the vector instructions of the SH4 FPU on a bank of FR0-FR15, as bits.
+// the banks are 16 byte aligned so that FVn (n = 0, 4, 8, 12) and XMTRX load
+// as 128-bit vectors.  denormal inputs count as zero and denormal results
+// are flushed to zero (FPSCR.DN = 1), NaN results are the SH4 qNaN
+// 0x7FBFFFFF.  FPSCR cause and flag bits are not computed.
+//
+// the reference versions compute in double precision and round once.  the
+// SSE versions compute in single precision, which stays within the precision
+// the manual gives for the instructions, and hand special inputs (infinity,
+// NaN, denormals) and overflows to the reference versions.
+
+// FR[n + 3] = FVm . FVn
+void fipr_reference(uint32_t* fr, unsigned m, unsigned n);
+void fipr_sse(uint32_t* fr, unsigned m, unsigned n);
+
+// FVn = XMTRX * FVn, with 'xf' the other bank (XF0-XF15, by columns)
+void ftrv_reference(uint32_t* fr, const uint32_t* xf, unsigned n);
+void ftrv_sse(uint32_t* fr, const uint32_t* xf, unsigned n);
+
+// FR[n] = sin, FR[n + 1] = cos of the angle in the low 16 bits of 'fpul'
+// (2 pi / 65536 units)
+void fsca_reference(uint32_t* fr, unsigned n, uint32_t fpul);
+void fsca_sse(uint32_t* fr, unsigned n, uint32_t fpul);
+
+// FR[n] = 1 / sqrt(FR[n])
+void fsrra_reference(uint32_t* fr, unsigned n);
+void fsrra_sse(uint32_t* fr, unsigned n);
+
+// false when the SSE versions are the reference ones (no x86 intrinsics)
+bool has_sse_fpu_kernels(void);
+
+#endif // FPU_KERNELS_H
@@ -0,0 +1,779 @@
+// generated by sh_gen names from the SuperH instruction database, "make names"
+// after changing it.
+
+#ifndef INSTRUCTION_NAMES_H
+#define INSTRUCTION_NAMES_H
+
+#include "name_hash.h"
+
+// keys are lowercase with single spaces: mnemonics ("mov.l", "dcf psub") list
+// their forms shortest first, format strings ("mov.l @(disp,rm),rn") the
+// instructions written the same way on different variants.
+
+constexpr std::array<hashed_name, 229> instruction_mnemonics_list =
+{{
+  { "add", 0, 2 },
+  { "addc", 2, 1 },
+  { "addv", 3, 1 },
+  { "and", 4, 2 },
+  { "and.b", 6, 1 },
+  { "band.b", 7, 1 },
+  { "bandnot.b", 8, 1 },
+  { "bclr", 9, 1 },
+  { "bclr.b", 10, 1 },
+  { "bf", 11, 1 },
+  { "bf/s", 12, 1 },
+  { "bld", 13, 1 },
+  { "bld.b", 14, 1 },
+  { "bldnot.b", 15, 1 },
+  { "bor.b", 16, 1 },
+  { "bornot.b", 17, 1 },
+  { "bra", 18, 1 },
+  { "braf", 19, 1 },
+  { "bset", 20, 1 },
+  { "bset.b", 21, 1 },
+  { "bsr", 22, 1 },
+  { "bsrf", 23, 1 },
+  { "bst", 24, 1 },
+  { "bst.b", 25, 1 },
+  { "bt", 26, 1 },
+  { "bt/s", 27, 1 },
+  { "bxor.b", 28, 1 },
+  { "clips.b", 29, 1 },
+  { "clips.w", 30, 1 },
+  { "clipu.b", 31, 1 },
+  { "clipu.w", 32, 1 },
+  { "clrmac", 33, 1 },
+  { "clrs", 34, 1 },
+  { "clrt", 35, 1 },
+  { "cmp/eq", 36, 2 },
+  { "cmp/ge", 38, 1 },
+  { "cmp/gt", 39, 1 },
+  { "cmp/hi", 40, 1 },
+  { "cmp/hs", 41, 1 },
+  { "cmp/pl", 42, 1 },
+  { "cmp/pz", 43, 1 },
+  { "cmp/str", 44, 1 },
+  { "dcf padd", 45, 1 },
+  { "dcf pand", 46, 1 },
+  { "dcf pclr", 47, 1 },
+  { "dcf pcopy", 48, 2 },
+  { "dcf pdec", 50, 2 },
+  { "dcf pdmsb", 52, 2 },
+  { "dcf pinc", 54, 2 },
+  { "dcf plds", 56, 2 },
+  { "dcf pneg", 58, 2 },
+  { "dcf por", 60, 1 },
+  { "dcf psha", 61, 1 },
+  { "dcf pshl", 62, 1 },
+  { "dcf psts", 63, 2 },
+  { "dcf psub", 65, 1 },
+  { "dcf pxor", 66, 1 },
+  { "dct padd", 67, 1 },
+  { "dct pand", 68, 1 },
+  { "dct pclr", 69, 1 },
+  { "dct pcopy", 70, 2 },
+  { "dct pdec", 72, 2 },
+  { "dct pdmsb", 74, 2 },
+  { "dct pinc", 76, 2 },
+  { "dct plds", 78, 2 },
+  { "dct pneg", 80, 2 },
+  { "dct por", 82, 1 },
+  { "dct psha", 83, 1 },
+  { "dct pshl", 84, 1 },
+  { "dct psts", 85, 2 },
+  { "dct psub", 87, 1 },
+  { "dct pxor", 88, 1 },
+  { "div0s", 89, 1 },
+  { "div0u", 90, 1 },
+  { "div1", 91, 1 },
+  { "divs", 92, 1 },
+  { "divu", 93, 1 },
+  { "dmuls.l", 94, 1 },
+  { "dmulu.l", 95, 1 },
+  { "dt", 96, 1 },
+  { "exts.b", 97, 1 },
+  { "exts.w", 98, 1 },
+  { "extu.b", 99, 1 },
+  { "extu.w", 100, 1 },
+  { "fabs", 101, 2 },
+  { "fadd", 103, 2 },
+  { "fcmp/eq", 105, 2 },
+  { "fcmp/gt", 107, 2 },
+  { "fcnvds", 109, 1 },
+  { "fcnvsd", 110, 1 },
+  { "fdiv", 111, 2 },
+  { "fipr", 113, 1 },
+  { "fldi0", 114, 1 },
+  { "fldi1", 115, 1 },
+  { "flds", 116, 1 },
+  { "float", 117, 2 },
+  { "fmac", 119, 1 },
+  { "fmov", 120, 17 },
+  { "fmov.d", 137, 2 },
+  { "fmov.s", 139, 8 },
+  { "fmul", 147, 2 },
+  { "fneg", 149, 2 },
+  { "fpchg", 151, 1 },
+  { "frchg", 152, 1 },
+  { "fsca", 153, 1 },
+  { "fschg", 154, 1 },
+  { "fsqrt", 155, 2 },
+  { "fsrra", 157, 1 },
+  { "fsts", 158, 1 },
+  { "fsub", 159, 2 },
+  { "ftrc", 161, 2 },
+  { "ftrv", 163, 1 },
+  { "icbi", 164, 1 },
+  { "jmp", 165, 1 },
+  { "jsr", 166, 1 },
+  { "jsr/n", 167, 2 },
+  { "ldbank", 169, 1 },
+  { "ldc", 170, 12 },
+  { "ldc.l", 182, 11 },
+  { "ldre", 193, 1 },
+  { "ldrs", 194, 1 },
+  { "lds", 195, 11 },
+  { "lds.l", 206, 11 },
+  { "ldtlb", 217, 1 },
+  { "mac.l", 218, 1 },
+  { "mac.w", 219, 1 },
+  { "mov", 220, 2 },
+  { "mov.b", 222, 14 },
+  { "mov.l", 236, 15 },
+  { "mov.w", 251, 15 },
+  { "mova", 266, 1 },
+  { "movca.l", 267, 1 },
+  { "movco.l", 268, 1 },
+  { "movi20", 269, 1 },
+  { "movi20s", 270, 1 },
+  { "movli.l", 271, 1 },
+  { "movml.l", 272, 2 },
+  { "movmu.l", 274, 2 },
+  { "movrt", 276, 1 },
+  { "movs.l", 277, 8 },
+  { "movs.w", 285, 8 },
+  { "movt", 293, 1 },
+  { "movu.b", 294, 1 },
+  { "movu.w", 295, 1 },
+  { "movua.l", 296, 2 },
+  { "movx.w", 298, 6 },
+  { "movy.w", 304, 6 },
+  { "mul.l", 310, 1 },
+  { "mulr", 311, 1 },
+  { "muls.w", 312, 1 },
+  { "mulu.w", 313, 1 },
+  { "neg", 314, 1 },
+  { "negc", 315, 1 },
+  { "nop", 316, 1 },
+  { "nopx", 317, 1 },
+  { "nopy", 318, 1 },
+  { "not", 319, 1 },
+  { "nott", 320, 1 },
+  { "ocbi", 321, 1 },
+  { "ocbp", 322, 1 },
+  { "ocbwb", 323, 1 },
+  { "or", 324, 2 },
+  { "or.b", 326, 1 },
+  { "pabs", 327, 2 },
+  { "padd", 329, 2 },
+  { "paddc", 331, 1 },
+  { "pand", 332, 1 },
+  { "pclr", 333, 1 },
+  { "pcmp", 334, 1 },
+  { "pcopy", 335, 2 },
+  { "pdec", 337, 2 },
+  { "pdmsb", 339, 2 },
+  { "pinc", 341, 2 },
+  { "plds", 343, 2 },
+  { "pmuls", 345, 1 },
+  { "pneg", 346, 2 },
+  { "por", 348, 1 },
+  { "pref", 349, 1 },
+  { "prefi", 350, 1 },
+  { "prnd", 351, 2 },
+  { "psha", 353, 2 },
+  { "pshl", 355, 2 },
+  { "psts", 357, 2 },
+  { "psub", 359, 2 },
+  { "psubc", 361, 1 },
+  { "pxor", 362, 1 },
+  { "resbank", 363, 1 },
+  { "rotcl", 364, 1 },
+  { "rotcr", 365, 1 },
+  { "rotl", 366, 1 },
+  { "rotr", 367, 1 },
+  { "rte", 368, 1 },
+  { "rts", 369, 1 },
+  { "rts/n", 370, 1 },
+  { "rtv/n", 371, 1 },
+  { "setrc", 372, 2 },
+  { "sets", 374, 1 },
+  { "sett", 375, 1 },
+  { "shad", 376, 1 },
+  { "shal", 377, 1 },
+  { "shar", 378, 1 },
+  { "shld", 379, 1 },
+  { "shll", 380, 1 },
+  { "shll16", 381, 1 },
+  { "shll2", 382, 1 },
+  { "shll8", 383, 1 },
+  { "shlr", 384, 1 },
+  { "shlr16", 385, 1 },
+  { "shlr2", 386, 1 },
+  { "shlr8", 387, 1 },
+  { "sleep", 388, 1 },
+  { "stbank", 389, 1 },
+  { "stc", 390, 12 },
+  { "stc.l", 402, 11 },
+  { "sts", 413, 11 },
+  { "sts.l", 424, 11 },
+  { "sub", 435, 1 },
+  { "subc", 436, 1 },
+  { "subv", 437, 1 },
+  { "swap.b", 438, 1 },
+  { "swap.w", 439, 1 },
+  { "synco", 440, 1 },
+  { "tas.b", 441, 1 },
+  { "trapa", 442, 1 },
+  { "tst", 443, 2 },
+  { "tst.b", 445, 1 },
+  { "xor", 446, 2 },
+  { "xor.b", 448, 1 },
+  { "xtrct", 449, 1 },
+}};
+
+inline constexpr name_hash_table<229> instruction_mnemonics(instruction_mnemonics_list);
+
+constexpr std::array<hashed_name, 450> instruction_formats_list =
+{{
+  { "add #imm,rn", 450, 1 },
+  { "add rm,rn", 451, 1 },
+  { "addc rm,rn", 452, 1 },
+  { "addv rm,rn", 453, 1 },
+  { "and #imm,r0", 454, 1 },
+  { "and rm,rn", 455, 1 },
+  { "and.b #imm,@(r0,gbr)", 456, 1 },
+  { "band.b #imm3,@disp12,rn", 457, 1 },
+  { "bandnot.b #imm3,@(disp12,rn)", 458, 1 },
+  { "bclr #imm3,rn", 459, 1 },
+  { "bclr.b #imm3,@(disp12,rn)", 460, 1 },
+  { "bf label", 461, 1 },
+  { "bf/s label", 462, 1 },
+  { "bld #imm3,rn", 463, 1 },
+  { "bld.b #imm3,@(disp12,rn)", 464, 1 },
+  { "bldnot.b #imm3,@(disp12,rn)", 465, 1 },
+  { "bor.b #imm3,@(disp12,rn)", 466, 1 },
+  { "bornot.b #imm3,@(disp12,rn)", 467, 1 },
+  { "bra label", 468, 1 },
+  { "braf rm", 469, 1 },
+  { "bset #imm3,rn", 470, 1 },
+  { "bset.b #imm3,@(disp12,rn)", 471, 1 },
+  { "bsr label", 472, 1 },
+  { "bsrf rm", 473, 1 },
+  { "bst #imm3,rn", 474, 1 },
+  { "bst.b #imm3,@(disp12,rn)", 475, 1 },
+  { "bt label", 476, 1 },
+  { "bt/s label", 477, 1 },
+  { "bxor.b #imm3,@(disp12,rn)", 478, 1 },
+  { "clips.b rn", 479, 1 },
+  { "clips.w rn", 480, 1 },
+  { "clipu.b rn", 481, 1 },
+  { "clipu.w rn", 482, 1 },
+  { "clrmac", 483, 1 },
+  { "clrs", 484, 1 },
+  { "clrt", 485, 1 },
+  { "cmp/eq #imm,r0", 486, 1 },
+  { "cmp/eq rm,rn", 487, 1 },
+  { "cmp/ge rm,rn", 488, 1 },
+  { "cmp/gt rm,rn", 489, 1 },
+  { "cmp/hi rm,rn", 490, 1 },
+  { "cmp/hs rm,rn", 491, 1 },
+  { "cmp/pl rn", 492, 1 },
+  { "cmp/pz rn", 493, 1 },
+  { "cmp/str rm,rn", 494, 1 },
+  { "dcf padd sx,sy,dz", 495, 1 },
+  { "dcf pand sx,sy,dz", 496, 1 },
+  { "dcf pclr dz", 497, 1 },
+  { "dcf pcopy sx,dz", 498, 1 },
+  { "dcf pcopy sy,dz", 499, 1 },
+  { "dcf pdec sx,dz", 500, 1 },
+  { "dcf pdec sy,dz", 501, 1 },
+  { "dcf pdmsb sx,dz", 502, 1 },
+  { "dcf pdmsb sy,dz", 503, 1 },
+  { "dcf pinc sx,dz", 504, 1 },
+  { "dcf pinc sy,dz", 505, 1 },
+  { "dcf plds dz,mach", 506, 1 },
+  { "dcf plds dz,macl", 507, 1 },
+  { "dcf pneg sx,dz", 508, 1 },
+  { "dcf pneg sy,dz", 509, 1 },
+  { "dcf por sx,sy,dz", 510, 1 },
+  { "dcf psha sx,sy,dz", 511, 1 },
+  { "dcf pshl sx,sy,dz", 512, 1 },
+  { "dcf psts mach,dz", 513, 1 },
+  { "dcf psts macl,dz", 514, 1 },
+  { "dcf psub sx,sy,dz", 515, 1 },
+  { "dcf pxor sx,sy,dz", 516, 1 },
+  { "dct padd sx,sy,dz", 517, 1 },
+  { "dct pand sx,sy,dz", 518, 1 },
+  { "dct pclr dz", 519, 1 },
+  { "dct pcopy sx,dz", 520, 1 },
+  { "dct pcopy sy,dz", 521, 1 },
+  { "dct pdec sx,dz", 522, 1 },
+  { "dct pdec sy,dz", 523, 1 },
+  { "dct pdmsb sx,dz", 524, 1 },
+  { "dct pdmsb sy,dz", 525, 1 },
+  { "dct pinc sx,dz", 526, 1 },
+  { "dct pinc sy,dz", 527, 1 },
+  { "dct plds dz,mach", 528, 1 },
+  { "dct plds dz,macl", 529, 1 },
+  { "dct pneg sx,dz", 530, 1 },
+  { "dct pneg sy,dz", 531, 1 },
+  { "dct por sx,sy,dz", 532, 1 },
+  { "dct psha sx,sy,dz", 533, 1 },
+  { "dct pshl sx,sy,dz", 534, 1 },
+  { "dct psts mach,dz", 535, 1 },
+  { "dct psts macl,dz", 536, 1 },
+  { "dct psub sx,sy,dz", 537, 1 },
+  { "dct pxor sx,sy,dz", 538, 1 },
+  { "div0s rm,rn", 539, 1 },
+  { "div0u", 540, 1 },
+  { "div1 rm,rn", 541, 1 },
+  { "divs r0,rn", 542, 1 },
+  { "divu r0,rn", 543, 1 },
+  { "dmuls.l rm,rn", 544, 1 },
+  { "dmulu.l rm,rn", 545, 1 },
+  { "dt rn", 546, 1 },
+  { "exts.b rm,rn", 547, 1 },
+  { "exts.w rm,rn", 548, 1 },
+  { "extu.b rm,rn", 549, 1 },
+  { "extu.w rm,rn", 550, 1 },
+  { "fabs drn", 551, 1 },
+  { "fabs frn", 552, 1 },
+  { "fadd drm,drn", 553, 1 },
+  { "fadd frm,frn", 554, 1 },
+  { "fcmp/eq drm,drn", 555, 1 },
+  { "fcmp/eq frm,frn", 556, 1 },
+  { "fcmp/gt drm,drn", 557, 1 },
+  { "fcmp/gt frm,frn", 558, 1 },
+  { "fcnvds drm,fpul", 559, 1 },
+  { "fcnvsd fpul,drn", 560, 1 },
+  { "fdiv drm,drn", 561, 1 },
+  { "fdiv frm,frn", 562, 1 },
+  { "fipr fvm,fvn", 563, 1 },
+  { "fldi0 frn", 564, 1 },
+  { "fldi1 frn", 565, 1 },
+  { "flds frm,fpul", 566, 1 },
+  { "float fpul,drn", 567, 1 },
+  { "float fpul,frn", 568, 1 },
+  { "fmac fr0,frm,frn", 569, 1 },
+  { "fmov @(r0,rm),drn", 570, 1 },
+  { "fmov @(r0,rm),xdn", 571, 1 },
+  { "fmov @rm+,drn", 572, 1 },
+  { "fmov @rm+,xdn", 573, 1 },
+  { "fmov @rm,drn", 574, 1 },
+  { "fmov @rm,xdn", 575, 1 },
+  { "fmov drm,@(r0,rn)", 576, 1 },
+  { "fmov drm,@-rn", 577, 1 },
+  { "fmov drm,@rn", 578, 1 },
+  { "fmov drm,drn", 579, 1 },
+  { "fmov drm,xdn", 580, 1 },
+  { "fmov frm,frn", 581, 1 },
+  { "fmov xdm,@(r0,rn)", 582, 1 },
+  { "fmov xdm,@-rn", 583, 1 },
+  { "fmov xdm,@rn", 584, 1 },
+  { "fmov xdm,drn", 585, 1 },
+  { "fmov xdm,xdn", 586, 1 },
+  { "fmov.d @(disp12,rm),drn", 587, 1 },
+  { "fmov.d drm,@(disp12,rn)", 588, 1 },
+  { "fmov.s @(disp12,rm),frn", 589, 1 },
+  { "fmov.s @(r0,rm),frn", 590, 1 },
+  { "fmov.s @rm+,frn", 591, 1 },
+  { "fmov.s @rm,frn", 592, 1 },
+  { "fmov.s frm,@(disp12,rn)", 593, 1 },
+  { "fmov.s frm,@(r0,rn)", 594, 1 },
+  { "fmov.s frm,@-rn", 595, 1 },
+  { "fmov.s frm,@rn", 596, 1 },
+  { "fmul drm,drn", 597, 1 },
+  { "fmul frm,frn", 598, 1 },
+  { "fneg drn", 599, 1 },
+  { "fneg frn", 600, 1 },
+  { "fpchg", 601, 1 },
+  { "frchg", 602, 1 },
+  { "fsca fpul,drn", 603, 1 },
+  { "fschg", 604, 1 },
+  { "fsqrt drn", 605, 1 },
+  { "fsqrt frn", 606, 1 },
+  { "fsrra frn", 607, 1 },
+  { "fsts fpul,frn", 608, 1 },
+  { "fsub drm,drn", 609, 1 },
+  { "fsub frm,frn", 610, 1 },
+  { "ftrc drm,fpul", 611, 1 },
+  { "ftrc frm,fpul", 612, 1 },
+  { "ftrv xmtrx,fvn", 613, 1 },
+  { "icbi @rn", 614, 1 },
+  { "jmp @rm", 615, 1 },
+  { "jsr @rm", 616, 1 },
+  { "jsr/n @@(disp8,tbr)", 617, 1 },
+  { "jsr/n @rm", 618, 1 },
+  { "ldbank @rm,r0", 619, 1 },
+  { "ldc rm,dbr", 620, 1 },
+  { "ldc rm,gbr", 621, 1 },
+  { "ldc rm,mod", 622, 1 },
+  { "ldc rm,re", 623, 1 },
+  { "ldc rm,rn_bank", 624, 1 },
+  { "ldc rm,rs", 625, 1 },
+  { "ldc rm,sgr", 626, 1 },
+  { "ldc rm,spc", 627, 1 },
+  { "ldc rm,sr", 628, 1 },
+  { "ldc rm,ssr", 629, 1 },
+  { "ldc rm,tbr", 630, 1 },
+  { "ldc rm,vbr", 631, 1 },
+  { "ldc.l @rm+,dbr", 632, 1 },
+  { "ldc.l @rm+,gbr", 633, 1 },
+  { "ldc.l @rm+,mod", 634, 1 },
+  { "ldc.l @rm+,re", 635, 1 },
+  { "ldc.l @rm+,rn_bank", 636, 1 },
+  { "ldc.l @rm+,rs", 637, 1 },
+  { "ldc.l @rm+,sgr", 638, 1 },
+  { "ldc.l @rm+,spc", 639, 1 },
+  { "ldc.l @rm+,sr", 640, 1 },
+  { "ldc.l @rm+,ssr", 641, 1 },
+  { "ldc.l @rm+,vbr", 642, 1 },
+  { "ldre @(disp,pc)", 643, 1 },
+  { "ldrs @(disp,pc)", 644, 1 },
+  { "lds rm,a0", 645, 1 },
+  { "lds rm,dsr", 646, 1 },
+  { "lds rm,fpscr", 647, 1 },
+  { "lds rm,fpul", 648, 1 },
+  { "lds rm,mach", 649, 1 },
+  { "lds rm,macl", 650, 1 },
+  { "lds rm,pr", 651, 1 },
+  { "lds rm,x0", 652, 1 },
+  { "lds rm,x1", 653, 1 },
+  { "lds rm,y0", 654, 1 },
+  { "lds rm,y1", 655, 1 },
+  { "lds.l @rm+,a0", 656, 1 },
+  { "lds.l @rm+,dsr", 657, 1 },
+  { "lds.l @rm+,fpscr", 658, 1 },
+  { "lds.l @rm+,fpul", 659, 1 },
+  { "lds.l @rm+,mach", 660, 1 },
+  { "lds.l @rm+,macl", 661, 1 },
+  { "lds.l @rm+,pr", 662, 1 },
+  { "lds.l @rm+,x0", 663, 1 },
+  { "lds.l @rm+,x1", 664, 1 },
+  { "lds.l @rm+,y0", 665, 1 },
+  { "lds.l @rm+,y1", 666, 1 },
+  { "ldtlb", 667, 1 },
+  { "mac.l @rm+,@rn+", 668, 1 },
+  { "mac.w @rm+,@rn+", 669, 1 },
+  { "mov #imm,rn", 670, 1 },
+  { "mov rm,rn", 671, 1 },
+  { "mov.b @(disp,gbr),r0", 672, 1 },
+  { "mov.b @(disp,rm),r0", 673, 1 },
+  { "mov.b @(disp12,rm),rn", 674, 1 },
+  { "mov.b @(r0,rm),rn", 675, 1 },
+  { "mov.b @-rm,r0", 676, 1 },
+  { "mov.b @rm+,rn", 677, 1 },
+  { "mov.b @rm,rn", 678, 1 },
+  { "mov.b r0,@(disp,gbr)", 679, 1 },
+  { "mov.b r0,@(disp,rn)", 680, 1 },
+  { "mov.b r0,@rn+", 681, 1 },
+  { "mov.b rm,@(disp12,rn)", 682, 1 },
+  { "mov.b rm,@(r0,rn)", 683, 1 },
+  { "mov.b rm,@-rn", 684, 1 },
+  { "mov.b rm,@rn", 685, 1 },
+  { "mov.l @(disp,gbr),r0", 686, 1 },
+  { "mov.l @(disp,pc),rn", 687, 1 },
+  { "mov.l @(disp,rm),rn", 688, 1 },
+  { "mov.l @(disp12,rm),rn", 689, 1 },
+  { "mov.l @(r0,rm),rn", 690, 1 },
+  { "mov.l @-rm,r0", 691, 1 },
+  { "mov.l @rm+,rn", 692, 1 },
+  { "mov.l @rm,rn", 693, 1 },
+  { "mov.l r0,@(disp,gbr)", 694, 1 },
+  { "mov.l r0,@rn+", 695, 1 },
+  { "mov.l rm,@(disp,rn)", 696, 1 },
+  { "mov.l rm,@(disp12,rn)", 697, 1 },
+  { "mov.l rm,@(r0,rn)", 698, 1 },
+  { "mov.l rm,@-rn", 699, 1 },
+  { "mov.l rm,@rn", 700, 1 },
+  { "mov.w @(disp,gbr),r0", 701, 1 },
+  { "mov.w @(disp,pc),rn", 702, 1 },
+  { "mov.w @(disp,rm),r0", 703, 1 },
+  { "mov.w @(disp12,rm),rn", 704, 1 },
+  { "mov.w @(r0,rm),rn", 705, 1 },
+  { "mov.w @-rm,r0", 706, 1 },
+  { "mov.w @rm+,rn", 707, 1 },
+  { "mov.w @rm,rn", 708, 1 },
+  { "mov.w r0,@(disp,gbr)", 709, 1 },
+  { "mov.w r0,@(disp,rn)", 710, 1 },
+  { "mov.w r0,@rn+", 711, 1 },
+  { "mov.w rm,@(disp12,rn)", 712, 1 },
+  { "mov.w rm,@(r0,rn)", 713, 1 },
+  { "mov.w rm,@-rn", 714, 1 },
+  { "mov.w rm,@rn", 715, 1 },
+  { "mova @(disp,pc),r0", 716, 1 },
+  { "movca.l r0,@rn", 717, 1 },
+  { "movco.l r0,@rn", 718, 1 },
+  { "movi20 #imm20,rn", 719, 1 },
+  { "movi20s #imm20,rn", 720, 1 },
+  { "movli.l @rm,r0", 721, 1 },
+  { "movml.l @r15+,rn", 722, 1 },
+  { "movml.l rm,@-r15", 723, 1 },
+  { "movmu.l @r15+,rn", 724, 1 },
+  { "movmu.l rm,@-r15", 725, 1 },
+  { "movrt rn", 726, 1 },
+  { "movs.l @-as,ds", 727, 1 },
+  { "movs.l @as+,ds", 728, 1 },
+  { "movs.l @as+is,ds", 729, 1 },
+  { "movs.l @as,ds", 730, 1 },
+  { "movs.l ds,@-as", 731, 1 },
+  { "movs.l ds,@as", 732, 1 },
+  { "movs.l ds,@as+", 733, 1 },
+  { "movs.l ds,@as+is", 734, 1 },
+  { "movs.w @-as,ds", 735, 1 },
+  { "movs.w @as+,ds", 736, 1 },
+  { "movs.w @as+ix,ds", 737, 1 },
+  { "movs.w @as,ds", 738, 1 },
+  { "movs.w ds,@-as", 739, 1 },
+  { "movs.w ds,@as", 740, 1 },
+  { "movs.w ds,@as+", 741, 1 },
+  { "movs.w ds,@as+is", 742, 1 },
+  { "movt rn", 743, 1 },
+  { "movu.b @(disp12,rm),rn", 744, 1 },
+  { "movu.w @(disp12,rm),rn", 745, 1 },
+  { "movua.l @rm+,r0", 746, 1 },
+  { "movua.l @rm,r0", 747, 1 },
+  { "movx.w @ax+,dx", 748, 1 },
+  { "movx.w @ax+ix,dx", 749, 1 },
+  { "movx.w @ax,dx", 750, 1 },
+  { "movx.w da,@ax", 751, 1 },
+  { "movx.w da,@ax+", 752, 1 },
+  { "movx.w da,@ax+ix", 753, 1 },
+  { "movy.w @ay+,dy", 754, 1 },
+  { "movy.w @ay+iy,dy", 755, 1 },
+  { "movy.w @ay,dy", 756, 1 },
+  { "movy.w da,@ay", 757, 1 },
+  { "movy.w da,@ay+", 758, 1 },
+  { "movy.w da,@ay+iy", 759, 1 },
+  { "mul.l rm,rn", 760, 1 },
+  { "mulr r0,rn", 761, 1 },
+  { "muls.w rm,rn", 762, 1 },
+  { "mulu.w rm,rn", 763, 1 },
+  { "neg rm,rn", 764, 1 },
+  { "negc rm,rn", 765, 1 },
+  { "nop", 766, 1 },
+  { "nopx", 767, 1 },
+  { "nopy", 768, 1 },
+  { "not rm,rn", 769, 1 },
+  { "nott", 770, 1 },
+  { "ocbi @rn", 771, 1 },
+  { "ocbp @rn", 772, 1 },
+  { "ocbwb @rn", 773, 1 },
+  { "or #imm,r0", 774, 1 },
+  { "or rm,rn", 775, 1 },
+  { "or.b #imm,@(r0,gbr)", 776, 1 },
+  { "pabs sx,dz", 777, 1 },
+  { "pabs sy,dz", 778, 1 },
+  { "padd sx,sy,du pmuls se,sf,dg", 779, 1 },
+  { "padd sx,sy,dz", 780, 1 },
+  { "paddc sx,sy,dz", 781, 1 },
+  { "pand sx,sy,dz", 782, 1 },
+  { "pclr dz", 783, 1 },
+  { "pcmp sx,sy", 784, 1 },
+  { "pcopy sx,dz", 785, 1 },
+  { "pcopy sy,dz", 786, 1 },
+  { "pdec sx,dz", 787, 1 },
+  { "pdec sy,dz", 788, 1 },
+  { "pdmsb sx,dz", 789, 1 },
+  { "pdmsb sy,dz", 790, 1 },
+  { "pinc sx,dz", 791, 1 },
+  { "pinc sy,dz", 792, 1 },
+  { "plds dz,mach", 793, 1 },
+  { "plds dz,macl", 794, 1 },
+  { "pmuls se,sf,dg", 795, 1 },
+  { "pneg sx,dz", 796, 1 },
+  { "pneg sy,dz", 797, 1 },
+  { "por sx,sy,dz", 798, 1 },
+  { "pref @rn", 799, 1 },
+  { "prefi @rn", 800, 1 },
+  { "prnd sx,dz", 801, 1 },
+  { "prnd sy,dz", 802, 1 },
+  { "psha #imm,dz", 803, 1 },
+  { "psha sx,sy,dz", 804, 1 },
+  { "pshl #imm,dz", 805, 1 },
+  { "pshl sx,sy,dz", 806, 1 },
+  { "psts mach,dz", 807, 1 },
+  { "psts macl,dz", 808, 1 },
+  { "psub sx,sy,du pmuls se,sf,dg", 809, 1 },
+  { "psub sx,sy,dz", 810, 1 },
+  { "psubc sx,sy,dz", 811, 1 },
+  { "pxor sx,sy,dz", 812, 1 },
+  { "resbank", 813, 1 },
+  { "rotcl rn", 814, 1 },
+  { "rotcr rn", 815, 1 },
+  { "rotl rn", 816, 1 },
+  { "rotr rn", 817, 1 },
+  { "rte", 818, 1 },
+  { "rts", 819, 1 },
+  { "rts/n", 820, 1 },
+  { "rtv/n rm", 821, 1 },
+  { "setrc #imm", 822, 1 },
+  { "setrc rn", 823, 1 },
+  { "sets", 824, 1 },
+  { "sett", 825, 1 },
+  { "shad rm,rn", 826, 1 },
+  { "shal rn", 827, 1 },
+  { "shar rn", 828, 1 },
+  { "shld rm,rn", 829, 1 },
+  { "shll rn", 830, 1 },
+  { "shll16 rn", 831, 1 },
+  { "shll2 rn", 832, 1 },
+  { "shll8 rn", 833, 1 },
+  { "shlr rn", 834, 1 },
+  { "shlr16 rn", 835, 1 },
+  { "shlr2 rn", 836, 1 },
+  { "shlr8 rn", 837, 1 },
+  { "sleep", 838, 1 },
+  { "stbank r0,@rn", 839, 1 },
+  { "stc dbr,rn", 840, 1 },
+  { "stc gbr,rn", 841, 1 },
+  { "stc mod,rn", 842, 1 },
+  { "stc re,rn", 843, 1 },
+  { "stc rm_bank,rn", 844, 1 },
+  { "stc rs,rn", 845, 1 },
+  { "stc sgr,rn", 846, 1 },
+  { "stc spc,rn", 847, 1 },
+  { "stc sr,rn", 848, 1 },
+  { "stc ssr,rn", 849, 1 },
+  { "stc tbr,rn", 850, 1 },
+  { "stc vbr,rn", 851, 1 },
+  { "stc.l dbr,@-rn", 852, 1 },
+  { "stc.l gbr,@-rn", 853, 1 },
+  { "stc.l mod,@-rn", 854, 1 },
+  { "stc.l re,@-rn", 855, 1 },
+  { "stc.l rm_bank,@-rn", 856, 1 },
+  { "stc.l rs,@-rn", 857, 1 },
+  { "stc.l sgr,@-rn", 858, 1 },
+  { "stc.l spc,@-rn", 859, 1 },
+  { "stc.l sr,@-rn", 860, 1 },
+  { "stc.l ssr,@-rn", 861, 1 },
+  { "stc.l vbr,@-rn", 862, 1 },
+  { "sts a0,rn", 863, 1 },
+  { "sts dsr,rn", 864, 1 },
+  { "sts fpscr,rn", 865, 1 },
+  { "sts fpul,rn", 866, 1 },
+  { "sts mach,rn", 867, 1 },
+  { "sts macl,rn", 868, 1 },
+  { "sts pr,rn", 869, 1 },
+  { "sts x0,rn", 870, 1 },
+  { "sts x1,rn", 871, 1 },
+  { "sts y0,rn", 872, 1 },
+  { "sts y1,rn", 873, 1 },
+  { "sts.l a0,@-rn", 874, 1 },
+  { "sts.l dsr,@-rn", 875, 1 },
+  { "sts.l fpscr,@-rn", 876, 1 },
+  { "sts.l fpul,@-rn", 877, 1 },
+  { "sts.l mach,@-rn", 878, 1 },
+  { "sts.l macl,@-rn", 879, 1 },
+  { "sts.l pr,@-rn", 880, 1 },
+  { "sts.l x0,@-rn", 881, 1 },
+  { "sts.l x1,@-rn", 882, 1 },
+  { "sts.l y0,@-rn", 883, 1 },
+  { "sts.l y1,@-rn", 884, 1 },
+  { "sub rm,rn", 885, 1 },
+  { "subc rm,rn", 886, 1 },
+  { "subv rm,rn", 887, 1 },
+  { "swap.b rm,rn", 888, 1 },
+  { "swap.w rm,rn", 889, 1 },
+  { "synco", 890, 1 },
+  { "tas.b @rn", 891, 1 },
+  { "trapa #imm", 892, 1 },
+  { "tst #imm,r0", 893, 1 },
+  { "tst rm,rn", 894, 1 },
+  { "tst.b #imm,@(r0,gbr)", 895, 1 },
+  { "xor #imm,r0", 896, 1 },
+  { "xor rm,rn", 897, 1 },
+  { "xor.b #imm,@(r0,gbr)", 898, 1 },
+  { "xtrct rm,rn", 899, 1 },
+}};
+
+inline constexpr name_hash_table<450> instruction_formats(instruction_formats_list);
+
+inline constexpr uint16_t instruction_name_ids[900] =
+{
+  79, 80, 81, 82, 119, 120, 121, 65, 66, 68, 67, 149, 150, 70, 69, 71,
+  72, 73, 153, 154, 75, 74, 155, 156, 77, 76, 151, 152, 78, 92, 93, 94,
+  95, 164, 165, 166, 83, 84, 86, 88, 87, 85, 89, 90, 91, 376, 422, 381,
+  387, 388, 404, 405, 416, 417, 410, 411, 442, 443, 393, 394, 425, 432, 436, 448,
+  449, 397, 428, 375, 421, 380, 385, 386, 402, 403, 414, 415, 408, 409, 440, 441,
+  391, 392, 424, 431, 435, 446, 447, 396, 427, 96, 97, 98, 99, 100, 101, 102,
+  103, 104, 105, 106, 107, 302, 318, 304, 320, 310, 325, 311, 326, 329, 330, 308,
+  323, 314, 298, 299, 300, 312, 327, 307, 271, 280, 281, 282, 283, 284, 285, 286,
+  287, 288, 289, 290, 291, 292, 293, 294, 295, 296, 297, 272, 273, 274, 275, 276,
+  277, 278, 279, 306, 322, 303, 319, 341, 339, 317, 340, 309, 324, 316, 301, 305,
+  321, 313, 328, 315, 167, 157, 158, 159, 160, 168, 169, 171, 172, 174, 176, 178,
+  180, 182, 184, 186, 188, 190, 170, 173, 175, 177, 179, 181, 183, 185, 187, 189,
+  191, 192, 193, 194, 196, 198, 200, 201, 204, 206, 208, 210, 331, 335, 195, 197,
+  199, 202, 203, 205, 207, 209, 211, 333, 337, 212, 108, 109, 0, 1, 7, 10,
+  13, 16, 19, 22, 25, 33, 39, 42, 45, 48, 26, 34, 6, 9, 12, 15,
+  18, 21, 24, 31, 37, 41, 44, 47, 50, 32, 38, 5, 8, 11, 14, 17,
+  20, 23, 28, 35, 40, 43, 46, 49, 29, 36, 4, 213, 51, 2, 3, 52,
+  55, 56, 57, 58, 59, 364, 365, 366, 367, 368, 369, 370, 371, 356, 357, 358,
+  359, 360, 361, 362, 363, 60, 27, 30, 53, 54, 343, 344, 345, 346, 347, 348,
+  350, 351, 352, 353, 354, 355, 110, 111, 112, 113, 114, 115, 214, 342, 349, 122,
+  61, 215, 216, 217, 123, 124, 125, 372, 373, 374, 377, 378, 420, 379, 382, 383,
+  384, 400, 401, 412, 413, 406, 407, 438, 439, 429, 389, 390, 423, 218, 219, 418,
+  419, 430, 433, 434, 437, 444, 445, 395, 398, 399, 426, 220, 133, 134, 135, 136,
+  221, 161, 162, 163, 222, 223, 224, 225, 137, 138, 139, 140, 141, 144, 142, 143,
+  145, 148, 146, 147, 226, 227, 228, 230, 231, 233, 235, 237, 239, 241, 243, 245,
+  247, 249, 229, 232, 234, 236, 238, 240, 242, 244, 246, 248, 250, 251, 253, 255,
+  257, 259, 261, 263, 265, 267, 332, 336, 252, 254, 256, 258, 260, 262, 264, 266,
+  268, 334, 338, 116, 117, 118, 62, 63, 269, 126, 270, 127, 128, 129, 130, 131,
+  132, 64, 80, 79, 81, 82, 120, 119, 121, 65, 66, 68, 67, 149, 150, 70,
+  69, 71, 72, 73, 153, 154, 75, 74, 155, 156, 77, 76, 151, 152, 78, 92,
+  93, 94, 95, 164, 165, 166, 83, 84, 86, 88, 87, 85, 89, 90, 91, 376,
+  422, 381, 387, 388, 404, 405, 416, 417, 410, 411, 442, 443, 393, 394, 425, 432,
+  436, 448, 449, 397, 428, 375, 421, 380, 385, 386, 402, 403, 414, 415, 408, 409,
+  440, 441, 391, 392, 424, 431, 435, 446, 447, 396, 427, 96, 97, 98, 99, 100,
+  101, 102, 103, 104, 105, 106, 107, 318, 302, 320, 304, 325, 310, 326, 311, 329,
+  330, 323, 308, 314, 298, 299, 300, 327, 312, 307, 292, 293, 288, 289, 284, 285,
+  294, 290, 286, 280, 281, 271, 295, 291, 287, 282, 283, 296, 297, 278, 276, 274,
+  272, 279, 277, 275, 273, 322, 306, 319, 303, 341, 339, 317, 340, 324, 309, 316,
+  301, 321, 305, 328, 313, 315, 167, 157, 158, 160, 159, 168, 188, 172, 176, 178,
+  190, 180, 182, 186, 169, 184, 171, 174, 189, 173, 177, 179, 191, 181, 183, 187,
+  170, 185, 175, 192, 193, 201, 200, 331, 335, 194, 196, 198, 204, 206, 208, 210,
+  203, 202, 333, 337, 195, 197, 199, 205, 207, 209, 211, 212, 108, 109, 1, 0,
+  45, 25, 26, 39, 19, 13, 7, 48, 33, 22, 34, 42, 16, 10, 47, 6,
+  31, 32, 41, 21, 15, 9, 50, 24, 37, 38, 44, 18, 12, 46, 5, 28,
+  29, 40, 20, 14, 8, 49, 35, 23, 36, 43, 17, 11, 4, 213, 51, 2,
+  3, 52, 56, 55, 58, 57, 59, 364, 366, 367, 365, 368, 369, 370, 371, 356,
+  358, 359, 357, 360, 361, 362, 363, 60, 27, 30, 54, 53, 344, 345, 343, 346,
+  347, 348, 351, 352, 350, 353, 354, 355, 110, 111, 112, 113, 114, 115, 214, 342,
+  349, 122, 61, 215, 216, 217, 124, 123, 125, 372, 373, 377, 374, 378, 420, 379,
+  382, 383, 384, 400, 401, 412, 413, 406, 407, 438, 439, 429, 389, 390, 423, 218,
+  219, 418, 419, 433, 430, 437, 434, 444, 445, 398, 395, 399, 426, 220, 133, 134,
+  135, 136, 221, 161, 162, 163, 223, 222, 224, 225, 137, 138, 139, 140, 141, 144,
+  142, 143, 145, 148, 146, 147, 226, 227, 247, 231, 235, 237, 249, 239, 241, 245,
+  228, 243, 230, 233, 248, 232, 236, 238, 250, 240, 242, 246, 229, 244, 234, 259,
+  257, 332, 336, 251, 253, 255, 261, 263, 265, 267, 260, 258, 334, 338, 252, 254,
+  256, 262, 264, 266, 268, 116, 117, 118, 62, 63, 269, 126, 270, 128, 127, 129,
+  131, 130, 132, 64,
+};
+
+// ids of the forms of a mnemonic, none if unknown
+constexpr name_ids find_instruction_mnemonic(std::string_view name)
+{
+  const hashed_name* n = instruction_mnemonics.find(name);
+  return n ? name_ids{ instruction_name_ids + n->first, n->count } : name_ids{};
+}
+
+// ids of the instructions written as 'format', none if unknown
+constexpr name_ids find_instruction_format(std::string_view format)
+{
+  const hashed_name* n = instruction_formats.find(format);
+  return n ? name_ids{ instruction_name_ids + n->first, n->count } : name_ids{};
+}
+
+#endif // INSTRUCTION_NAMES_H
@@ -0,0 +1,1284 @@
+#include "interpreter.h"
+#include "block_jit.h"
+#include "decode_table.h"
+#include "disassembler.h"
+#include "dsp_unit.h"
+#include "fpu_kernels.h"
+#include "instruction_names.h"
+#include "opcode_map.h"
+#include "operand_extractor.h"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+using namespace std::literals::string_literals;
+
+#if defined(__GNUC__) && !defined(SH_NO_COMPUTED_GOTO)
+# define SH_COMPUTED_GOTO 1
+#else
+# define SH_COMPUTED_GOTO 0
+#endif
+
+namespace
+{
+  std::string hex(uint32_t value, int digits)
+  {
+    char buffer[8];
+    return "0x"s + std::string(buffer, std::size_t(write_hex(buffer, value, digits) - buffer));
+  }
+
+  // a bit of SR or FPSCR that the snippets read and assign like a variable
+  // (S, Q, M, FPSCR_PR, ...)
+  template<int Bit>
+  class register_bit
+  {
+  public:
+    explicit register_bit(uint32_t& r) : reg(r) { }
+
+    operator uint32_t(void) const { return (reg >> Bit) & 1; }
+
+    register_bit& operator =(uint32_t value)
+    {
+      reg = (reg & ~(uint32_t(1) << Bit)) | ((value & 1) << Bit);
+      return *this;
+    }
+    register_bit& operator =(const register_bit& other) { return *this = uint32_t(other); }
+
+  private:
+    uint32_t& reg;
+  };
+
+  // the T bit of SR.  sh_gen turns the "if (a == b) T = 1; else T = 0;" of
+  // the snippets with a "Result -> T" (or MSB, LSB) flag into equal(a, b),
+  // and so on, which set T without a branch.  the operands compare in the
+  // type C converts them to.
+  class t_bit : public register_bit<0>
+  {
+  public:
+    explicit t_bit(uint32_t& sr) : register_bit<0>(sr) { }
+    t_bit(const t_bit&) = default;
+
+    using register_bit<0>::operator =;
+
+    template<typename A, typename B> void equal(A a, B b) { *this = uint32_t(common<A, B>(a) == common<A, B>(b)); }
+    template<typename A, typename B> void not_equal(A a, B b) { *this = uint32_t(common<A, B>(a) != common<A, B>(b)); }
+    template<typename A, typename B> void greater_equal(A a, B b) { *this = uint32_t(common<A, B>(a) >= common<A, B>(b)); }
+    template<typename A, typename B> void greater(A a, B b) { *this = uint32_t(common<A, B>(a) > common<A, B>(b)); }
+
+  private:
+    // the type a comparison converts both operands to
+    template<typename A, typename B> using common = decltype(std::declval<A>() + std::declval<B>());
+  };
+
+  // the instructions of the idioms that the block cache runs at once
+  constexpr uint16_t div0u_id = *find_instruction_format("div0u").begin();
+  constexpr uint16_t div1_id = *find_instruction_format("div1 rm,rn").begin();
+  constexpr uint16_t rotcl_id = *find_instruction_format("rotcl rn").begin();
+  constexpr uint16_t mac_w_id = *find_instruction_format("mac.w @rm+,@rn+").begin();
+  constexpr uint16_t mac_l_id = *find_instruction_format("mac.l @rm+,@rn+").begin();
+
+  // the sum of the products of 'count' pairs of big endian signed values,
+  // 16-bit (mac.w) or 32-bit (mac.l), modulo 2^64
+  uint64_t mac_w_sum(const uint8_t* a, const uint8_t* b, uint32_t count)
+  {
+    int64_t rval = 0;
+    for(uint32_t k = 0; k < count; ++k, a += 2, b += 2)
+      rval += int32_t(int16_t(a[0] << 8 | a[1])) * int16_t(b[0] << 8 | b[1]);
+    return uint64_t(rval);
+  }
+
+  uint64_t mac_l_sum(const uint8_t* a, const uint8_t* b, uint32_t count)
+  {
+    uint64_t rval = 0;
+    for(uint32_t k = 0; k < count; ++k, a += 4, b += 4)
+    {
+      const int32_t x = int32_t(uint32_t(a[0]) << 24 | uint32_t(a[1]) << 16 | uint32_t(a[2]) << 8 | a[3]);
+      const int32_t y = int32_t(uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | b[3]);
+      rval += uint64_t(int64_t(x) * y);
+    }
+    return rval;
+  }
+
+  // a floating-point register as the snippets move it around: its bits, with
+  // the sign flipped by a unary minus (fneg)
+  class float_register
+  {
+  public:
+    explicit float_register(uint32_t& r) : reg(r) { }
+
+    operator uint32_t(void) const { return reg; }
+    uint32_t operator -(void) const { return reg ^ 0x80000000; }
+
+    float_register& operator =(uint64_t value)
+    {
+      reg = uint32_t(value);
+      return *this;
+    }
+    float_register& operator =(const float_register& other) { return *this = uint32_t(other); }
+
+  private:
+    uint32_t& reg;
+  };
+
+  // a pair of floating-point registers (DRn, XDn), the even one on top
+  class double_register
+  {
+  public:
+    double_register(uint32_t& h, uint32_t& l) : high(h), low(l) { }
+
+    operator uint64_t(void) const { return uint64_t(high) << 32 | low; }
+
+    double_register& operator =(uint64_t value)
+    {
+      high = uint32_t(value >> 32);
+      low = uint32_t(value);
+      return *this;
+    }
+    double_register& operator =(const double_register& other) { return *this = uint64_t(other); }
+
+  private:
+    uint32_t& high;
+    uint32_t& low;
+  };
+
+  // FR and XF, DR and XD: the registers of the bank that 'regs' points to
+  class float_bank
+  {
+  public:
+    explicit float_bank(uint32_t* const& bank) : regs(bank) { }
+
+    float_register operator [](uint32_t n) const { return float_register(regs[n & 15]); }
+
+  private:
+    uint32_t* const& regs;
+  };
+
+  class double_bank
+  {
+  public:
+    explicit double_bank(uint32_t* const& bank) : regs(bank) { }
+
+    double_register operator [](uint32_t n) const { return double_register(regs[n * 2 & 15], regs[(n * 2 + 1) & 15]); }
+
+  private:
+    uint32_t* const& regs;
+  };
+
+  bool is_delayed_branch(const insn& i)
+  {
+    for(const environment_t& e : i.data<environments>())
+      if(e.property == "Delayed Branch")
+        return true;
+    return false;
+  }
+
+  // the PC of the next instruction is not the one that follows: delayed
+  // branches and the snippets that assign the PC (other than PC += 2) or sleep
+  bool changes_flow(const insn& i)
+  {
+    if(is_delayed_branch(i))
+      return true;
+
+    const std::string& op = i.data<operation>();
+    auto is_name = [&](std::size_t pos) { return pos < op.size() && (std::isalnum(uint8_t(op[pos])) || op[pos] == '_'); };
+    for(std::size_t pos = op.find("PC"); pos != std::string::npos; pos = op.find("PC", pos + 2))
+    {
+      if((pos > 0 && is_name(pos - 1)) || is_name(pos + 2))
+        continue;
+      const std::size_t next = op.find_first_not_of(" \t", pos + 2);
+      if(next + 1 < op.size() && op[next] == '=' && op[next + 1] != '=')
+        return true;
+    }
+    return op.find("Sleep_standby") != std::string::npos;
+  }
+}
+
+guest_memory::guest_memory(uint32_t base, std::size_t size)
+  : origin(base & 0x1FFFFFFF), bytes(size)
+{
+  if(size == 0 || size - 1 > 0x1FFFFFFF - origin)
+    throw("memory block does not fit in the address space"s);
+}
+
+void guest_memory::fault(uint32_t address, uint32_t size) const
+{
+  if(address & (size - 1))
+    throw("address error: "s + std::to_string(size) + " bytes at " + hex(address, 8));
+  throw("bus error: "s + hex(address, 8) + " is outside of the memory");
+}
+
+// ----------------------------------------------------------------------------
+
+// the registers and what the handlers of every variant share
+class interpreter_core : public cpu_state
+{
+public:
+  interpreter_core(isa variant, guest_memory& memory)
+    : mem(memory), slot_illegal(instruction_entries().size()),
+      ends_block(instruction_entries().size()), delayed(instruction_entries().size()),
+      illegal_slot(uint16_t(instruction_entries().size())), unfused_slot(uint16_t(illegal_slot + 1))
+  {
+    for(const instruction_entry& entry : instruction_entries())
+    {
+      slot_illegal[entry.id] = raises_slot_illegal(*entry.source);
+      ends_block[entry.id] = changes_flow(*entry.source);
+      delayed[entry.id] = is_delayed_branch(*entry.source);
+    }
+    for(unsigned mode = 0; mode < fpu_mode_count; ++mode)
+    {
+      mode_tables[mode] = &decode_table_for(variant, mode);
+      recent_blocks[mode].fill({ 1, 0 });
+    }
+    fpu_mode_changed();
+  }
+
+  virtual ~interpreter_core(void) = default;
+
+  virtual uint64_t run_threaded(uint64_t count) = 0;
+  virtual uint64_t run_switched(uint64_t count) = 0;
+  virtual uint64_t run_blocks(uint64_t count, bool translate) = 0;
+
+  bool sleeping = false;
+
+protected:
+  uint32_t fetch(uint32_t address) const { return mem.read_16(address); }
+
+  // the word of the instruction at 'address' (32-bit forms with the first
+  // halfword on top) and its id
+  uint16_t decode(uint32_t address, uint32_t& word) const
+  {
+    word = fetch(address);
+    uint16_t id = table->lookup(uint16_t(word));
+    if(decode_table::is_extended(id))
+    {
+      const uint32_t second = fetch(address + 2);
+      id = table->decode(uint16_t(word), uint16_t(second));
+      word = word << 16 | second;
+    }
+    return id;
+  }
+
+  [[noreturn]] void illegal(uint32_t word) const;
+  [[noreturn]] void unimplemented(uint32_t word) const;
+
+  // FPSCR has been written: the decode table of its FPU mode and the banks
+  // of FR and XF.  the dispatch switches tables only here, so the handlers of
+  // fmov, fadd, ... never test the mode themselves.
+  void fpu_mode_changed(void)
+  {
+    fpu_mode = fpu_mode_of(FPSCR);
+    table = mode_tables[fpu_mode];
+    fr_bank = FPR.data() + ((FPSCR >> 17) & 16);
+    xf_bank = FPR.data() + (~(FPSCR >> 17) & 16);
+  }
+
+  // names of the snippets
+  uint32_t Read_8(uint32_t address) const { return mem.read_8(address); }
+  uint32_t Read_16(uint32_t address) const { return mem.read_16(address); }
+  uint32_t Read_32(uint32_t address) const { return mem.read_32(address); }
+  uint64_t Read_64(uint32_t address) const { return mem.read_64(address); }
+  uint32_t Read_Unaligned_32(uint32_t address) const
+  {
+    return mem.read_8(address) << 24 | mem.read_8(address + 1) << 16 | mem.read_8(address + 2) << 8 |
+           mem.read_8(address + 3);
+  }
+  void Write_8(uint32_t address, uint32_t value)
+  {
+    mem.write_8(address, value);
+    watch(address);
+  }
+  void Write_16(uint32_t address, uint32_t value)
+  {
+    mem.write_16(address, value);
+    watch(address);
+  }
+  void Write_32(uint32_t address, uint32_t value)
+  {
+    mem.write_32(address, value);
+    watch(address);
+  }
+  void Write_64(uint32_t address, uint64_t value)
+  {
+    mem.write_64(address, value);
+    watch(address);
+  }
+
+  void invalidate_instruction_cache_block(uint32_t address) { watch(address); }
+
+  // stays at the sleep instruction and ends the run
+  void Sleep_standby(void)
+  {
+    sleeping = true;
+    limit = 0;
+  }
+
+  // frchg and fschg with FPSCR.PR = 1
+  [[noreturn]] void undefined_operation(void) const;
+
+  // the vector instructions, on the 16 byte aligned banks (sh_gen
+  // interpreter_natives).  they only decode with FPSCR.PR = 0.
+  void native_FIPR(int m, int n)
+  {
+    fipr_sse(fr_bank, unsigned(m), unsigned(n));
+    PC += 2;
+  }
+  void native_FTRV(int n)
+  {
+    ftrv_sse(fr_bank, xf_bank, unsigned(n));
+    PC += 2;
+  }
+  void native_FSCA(int n)
+  {
+    fsca_sse(fr_bank, unsigned(n), FPUL);
+    PC += 2;
+  }
+  void native_FSRRA(int n)
+  {
+    fsrra_sse(fr_bank, unsigned(n));
+    PC += 2;
+  }
+
+  // the DSP instructions with their transfers, on the DSP unit
+  void native_DSP(uint32_t word)
+  {
+    if(!dsp)
+      dsp.reset(new dsp_unit(*this, mem, [this](uint32_t address) { watch(address); }));
+    if(!dsp->execute(word))
+      illegal(word);
+    PC += word > 0xFFFF ? 4 : 2;
+  }
+
+  // setrc: the repeat count in SR.RC and, from the distance of RE to RS, the
+  // repeat flags SR.RF1-RF0 of loops of 1 (00), 2 (01), 3 (11) or more (10)
+  // instructions
+  void native_SETRC(int m) { set_repeat_count(R[m] & 0xFFF); }
+  void native_SETRCI(int i) { set_repeat_count(uint32_t(i) & 0xFF); }
+  void set_repeat_count(uint32_t count)
+  {
+    const int32_t distance = int32_t(RE - RS);
+    const uint32_t flags = distance == -4 ? 0 : distance == -2 ? 1 : distance == 0 ? 3 : 2;
+    SR = (SR & ~uint32_t(0x0FFF000C)) | count << 16 | flags << 2;
+    PC += 2;
+  }
+
+  // SR, RS or RE have been written: the first and the last instruction of
+  // the repeat loop and the address after it, while SR.RC counts.  RE is 4
+  // after the instruction in front of loops of 1 to 3 instructions, and 4
+  // after the third instruction from the end of longer ones (RS is their
+  // first).  the block cache ends a block after every last instruction it
+  // has been told of.
+  void repeat_changed(void)
+  {
+    repeat_last = no_repeat;
+    repeat_exit = no_repeat;
+    if(!(SR & 0x0FFF0000))
+      return;
+    // RF: 00 one instruction, 01 two, 11 three, 10 four or more
+    const uint32_t flags = (SR >> 2) & 3;
+    repeat_start = flags == 2 ? RS : instruction_after(RE - 4, 1);
+    const uint32_t last = flags == 2 ? instruction_after(RE - 4, 3) : instruction_after(repeat_start, flags == 3 ? 2 : flags);
+    repeat_last = last;
+    repeat_exit = instruction_after(last, 1);
+    if(repeat_ends.insert(last).second)
+      watch(last);
+  }
+
+  // the last instruction of the loop has run: back to the first one until
+  // RC is down to 1, then RC is 0.  threaded and switch dispatch compare the
+  // PC with repeat_exit after every instruction, the block cache has a record
+  // after the last one.
+  void repeat(void)
+  {
+    if((SR & 0x0FFF0000) > 0x00010000)
+    {
+      SR -= 0x00010000;
+      PC = repeat_start;
+    }
+    else
+    {
+      SR &= ~uint32_t(0x0FFF0000);
+      repeat_last = no_repeat;
+      repeat_exit = no_repeat;
+    }
+  }
+
+  uint32_t instruction_after(uint32_t address, uint32_t count) const
+  {
+    for(; count && mem.contains(address, 4); --count)
+    {
+      uint32_t word;
+      address += table->size(decode(address, word));
+    }
+    return address;
+  }
+
+  static constexpr uint32_t no_repeat = 1; // never a PC
+
+  std::unique_ptr<dsp_unit> dsp; // of the first DSP instruction
+  uint32_t repeat_start = 0;
+  uint32_t repeat_last = no_repeat;
+  uint32_t repeat_exit = no_repeat;
+  std::unordered_set<uint32_t> repeat_ends; // last instructions of the loops so far
+
+  t_bit T { SR };
+  register_bit<1> S { SR };
+  register_bit<8> Q { SR };
+  register_bit<9> M { SR };
+  register_bit<28> SR_BL { SR };
+  register_bit<29> SR_RB { SR };
+  register_bit<30> SR_MD { SR };
+  register_bit<19> FPSCR_PR { FPSCR };
+  register_bit<20> FPSCR_SZ { FPSCR };
+
+  uint32_t* fr_bank = FPR.data();
+  uint32_t* xf_bank = FPR.data() + 16;
+  float_bank FR { fr_bank };
+  float_bank XF { xf_bank };
+  double_bank DR { fr_bank };
+  double_bank XD { xf_bank };
+
+  // an instruction of the block cache, with the operand fields (not sign
+  // extended) in the order of its operand extractor
+  struct predecoded
+  {
+    const void* handler;
+    uint32_t word;
+    uint16_t id;
+    std::array<int32_t, max_operand_fields> operand;
+  };
+
+  static constexpr std::size_t max_block = 64;  // instructions
+  static constexpr int code_granule_bits = 8;   // of the map of predecoded memory
+  static constexpr int32_t hot_block_runs = 16; // before a block is translated
+
+  // the head record of a block: the block PC in 'word', then these operands
+  enum head_operand { head_runs, head_length, head_translated, head_function, head_slot };
+
+  // the record after the last instruction of a repeat loop: its address in
+  // 'word' and the first record of the block
+  enum repeat_operand { repeat_head };
+
+  // the record ahead of the instructions of an idiom: their number, then the
+  // registers (div1 Rm,Rn with rotcl Rq; mac Rm and Rn)
+  enum idiom_operand { idiom_length, idiom_rm, idiom_rn, idiom_rq };
+  static constexpr uint32_t max_mac_chain = 256; // instructions
+
+  // writes to predecoded code drop the blocks when the current block ends
+  void watch(uint32_t address)
+  {
+    const std::size_t granule = ((address & 0x1FFFFFFF) - mem.base()) >> code_granule_bits;
+    if(granule < code_map.size() && code_map[granule])
+      code_written = true;
+  }
+
+  void flush_blocks(void)
+  {
+    records.clear();
+    for(unsigned mode = 0; mode < fpu_mode_count; ++mode)
+    {
+      blocks[mode].clear();
+      recent_blocks[mode].fill({ 1, 0 });
+    }
+    std::fill(code_map.begin(), code_map.end(), 0);
+    code_written = false;
+    translations.clear();
+    if(jit)
+      jit->clear();
+  }
+
+  void mark_code(uint32_t address, uint32_t size)
+  {
+    const uint32_t offset = (address & 0x1FFFFFFF) - mem.base();
+    for(uint32_t granule = offset >> code_granule_bits; granule <= (offset + size - 1) >> code_granule_bits; ++granule)
+      code_map[granule] = 1;
+  }
+
+  std::array<const decode_table*, fpu_mode_count> mode_tables;
+  unsigned fpu_mode = 0;
+  const decode_table* table = nullptr; // of the FPU mode
+  guest_memory& mem;
+  std::vector<bool> slot_illegal; // by instruction id
+  std::vector<bool> ends_block;   // by instruction id
+  std::vector<bool> delayed;      // by instruction id
+  // ids of the slot records that raise the slot illegal exception and of
+  // those that could not be predecoded
+  const uint16_t illegal_slot;
+  const uint16_t unfused_slot;
+  uint64_t limit = 0; // instructions of the current run
+  uint64_t slots = 0; // delay slots executed
+
+  // block cache: the predecoded blocks, each one opened by a head record
+  // that counts its runs and closed by a record that looks up the next block.
+  // after a delayed branch that record is the predecoded slot, which the
+  // branch runs through 'slot_record'.  blocks are decoded in the FPU mode
+  // they start in and looked up by PC among those of the current mode.
+  std::vector<predecoded> records;
+  const predecoded* slot_record = nullptr; // of the current block
+  std::array<std::unordered_map<uint32_t, uint32_t>, fpu_mode_count> blocks; // first record by PC
+  std::array<std::array<std::pair<uint32_t, uint32_t>, 1024>, fpu_mode_count> recent_blocks; // in front of 'blocks'
+  std::vector<uint8_t> code_map; // granules of memory that hold predecoded instructions
+  bool code_written = false;
+
+  // translated blocks
+  std::unique_ptr<block_jit> jit;
+  std::vector<jit_function> translations; // by head_function
+};
+
+void interpreter_core::illegal(uint32_t word) const
+{
+  throw("illegal instruction "s + hex(word, word > 0xFFFF ? 8 : 4) + " at " + hex(PC, 8));
+}
+
+void interpreter_core::unimplemented(uint32_t word) const
+{
+  const uint16_t id = word > 0xFFFF ? table->decode(uint16_t(word >> 16), uint16_t(word))
+                                    : table->lookup(uint16_t(word));
+  std::string text = instruction_entries()[id].source->data<format>();
+  for(char& c : text)
+    c = c == '\t' ? ' ' : c == '\n' ? '|' : c;
+  throw("unimplemented instruction at "s + hex(PC, 8) + ": " + text);
+}
+
+void interpreter_core::undefined_operation(void) const
+{
+  throw("undefined operation at "s + hex(PC, 8));
+}
+
+// the handlers compiled for one variant: the #if CPU blocks of the snippets
+// are if constexpr, and the instructions of other variants are left out of
+// the dispatch and go to the illegal instruction handler.  the threaded
+// dispatch has a table per FPU mode.
+template<isa Variant>
+class variant_core final : public interpreter_core
+{
+public:
+  explicit variant_core(guest_memory& memory) : interpreter_core(Variant, memory)
+  {
+    // the next instructions decode in the new mode, or are in a new loop
+    for(std::size_t id = 0; id < ends_block.size(); ++id)
+      if(switches_fpu_mode(uint16_t(id)) || changes_repeat(uint16_t(id)))
+        ends_block[id] = true;
+  }
+
+  uint64_t run_threaded(uint64_t count) override;
+  uint64_t run_switched(uint64_t count) override;
+  uint64_t run_blocks(uint64_t count, bool translate) override;
+
+private:
+  static constexpr isa sets = cpu_instruction_sets(Variant);
+  static constexpr bool is_cpu(isa i) { return sets & i; }
+
+  // the handler may have written FPSCR
+  static constexpr bool switches_fpu_mode(uint16_t id)
+  {
+    if(!is_cpu(SH2E | SH2A_FPU | SH3_FPU | SH4 | SH4A))
+      return false;
+    switch(id)
+    {
+#define SH_FPU_MODE_SWITCH(id) case id:
+#define SH_FPU_MODE
+#include "interpreter_ops.inc"
+#undef SH_FPU_MODE
+#undef SH_FPU_MODE_SWITCH
+        return true;
+    }
+    return false;
+  }
+
+  static constexpr bool has_dsp = is_cpu(SH1_DSP | SH2_DSP | SH3_DSP);
+
+  // the handler may have started, ended or moved a repeat loop
+  static constexpr bool changes_repeat(uint16_t id)
+  {
+    if(!has_dsp)
+      return false;
+    switch(id)
+    {
+#define SH_REPEAT_CHANGE(id) case id:
+#define SH_REPEAT_CONTROL
+#include "interpreter_ops.inc"
+#undef SH_REPEAT_CONTROL
+#undef SH_REPEAT_CHANGE
+        return true;
+    }
+    return false;
+  }
+
+  void execute(uint32_t word, uint16_t id);
+  void execute_slot(uint32_t address);
+  void Delay_Slot(uint32_t address);
+
+  uint32_t find_block(uint32_t pc);
+  uint32_t build_block(uint32_t pc);
+  predecoded find_idiom(uint32_t address);
+  void translate_block(predecoded* head);
+
+#define SH_FIELD(mask, shift) ((word & (mask)) >> (shift))
+#define SH_OPERATIONS
+#include "interpreter_ops.inc"
+#undef SH_OPERATIONS
+
+  std::array<std::vector<const void*>, fpu_mode_count> handlers; // threaded dispatch, by first halfword
+  std::vector<const void*> block_labels; // block dispatch, by instruction id
+  const void* illegal_label = nullptr;
+  const void* head_label = nullptr;
+  const void* body_label = nullptr;
+  const void* translated_label = nullptr;
+  const void* repeat_label = nullptr;
+  const void* divide_label = nullptr;
+  const void* mac_label = nullptr;
+  const void* end_label = nullptr;
+};
+
+template<isa Variant>
+void variant_core<Variant>::execute(uint32_t word, uint16_t id)
+{
+  switch(id)
+  {
+#define SH_ARG(k, field) (field)
+#define SH_WORD word
+#define SH_HANDLER(id, sets, call) \
+  case id: \
+    if constexpr(is_cpu(isa(sets))) \
+    { \
+      call; \
+      if constexpr(switches_fpu_mode(id)) \
+        fpu_mode_changed(); \
+      if constexpr(changes_repeat(id)) \
+        repeat_changed(); \
+      return; \
+    } \
+    break;
+#define SH_UNIMPLEMENTED(id, sets) case id: if constexpr(is_cpu(isa(sets))) unimplemented(word); break;
+#define SH_DISPATCH
+#include "interpreter_ops.inc"
+#undef SH_DISPATCH
+#undef SH_UNIMPLEMENTED
+#undef SH_HANDLER
+#undef SH_WORD
+#undef SH_ARG
+  }
+  illegal(word);
+}
+
+template<isa Variant>
+void variant_core<Variant>::execute_slot(uint32_t address)
+{
+  uint32_t word;
+  const uint16_t id = decode(address, word);
+  if(id == invalid_instruction || slot_illegal[id])
+    throw("slot illegal instruction "s + hex(word, word > 0xFFFF ? 8 : 4) + " at " + hex(address, 8));
+  execute(word, id);
+}
+
+// the instruction at 'address' runs with the PC at its own address, the
+// branch target is restored afterwards.  in the block cache the slot comes
+// predecoded with the branch, its legality checked once, and its handler is
+// called directly.
+template<isa Variant>
+void variant_core<Variant>::Delay_Slot(uint32_t address)
+{
+  typedef void (*slot_call)(variant_core& core, const predecoded& slot);
+  static const slot_call calls[] =
+  {
+#define SH_ARG(k, field) slot.operand[k]
+#define SH_WORD slot.word
+#define SH_HANDLER(id, sets, call) \
+    [](variant_core& core, const predecoded& slot) \
+    { \
+      if constexpr(is_cpu(isa(sets))) \
+      { \
+        core.call; \
+        if constexpr(switches_fpu_mode(id)) \
+          core.fpu_mode_changed(); \
+        if constexpr(changes_repeat(id)) \
+          core.repeat_changed(); \
+      } \
+      else \
+        core.illegal(slot.word); \
+    },
+#define SH_UNIMPLEMENTED(id, sets) \
+    [](variant_core& core, const predecoded& slot) \
+    { if constexpr(is_cpu(isa(sets))) core.unimplemented(slot.word); else core.illegal(slot.word); },
+#define SH_DISPATCH
+#include "interpreter_ops.inc"
+#undef SH_DISPATCH
+#undef SH_UNIMPLEMENTED
+#undef SH_HANDLER
+#undef SH_WORD
+#undef SH_ARG
+    // illegal_slot
+    [](variant_core& core, const predecoded& slot)
+    {
+      throw("slot illegal instruction "s + hex(slot.word, slot.word > 0xFFFF ? 8 : 4) + " at " + hex(core.PC, 8));
+    },
+    // unfused_slot
+    [](variant_core& core, const predecoded&) { core.execute_slot(core.PC); },
+  };
+
+  const uint32_t target_pc = PC;
+  PC = address;
+  if(slot_record)
+    calls[slot_record->id](*this, *slot_record);
+  else
+    execute_slot(address);
+  ++slots;
+  PC = target_pc;
+}
+
+template<isa Variant>
+uint64_t variant_core<Variant>::run_switched(uint64_t count)
+{
+  fpu_mode_changed();
+  if constexpr(has_dsp)
+    repeat_changed();
+  slot_record = nullptr;
+  limit = count;
+  slots = 0;
+  uint64_t done = 0;
+  while(done < limit)
+  {
+    uint32_t word;
+    const uint16_t id = decode(PC, word);
+    execute(word, id);
+    if constexpr(has_dsp)
+      if(PC == repeat_exit)
+        repeat();
+    ++done;
+  }
+  return done + slots;
+}
+
+template<isa Variant>
+uint64_t variant_core<Variant>::run_threaded(uint64_t count)
+{
+#if SH_COMPUTED_GOTO
+  // handler labels by instruction id
+  static const void* const labels[] =
+  {
+#define SH_HANDLER(id, sets, call) is_cpu(isa(sets)) ? &&op_##id : &&illegal_op,
+#define SH_UNIMPLEMENTED(id, sets) is_cpu(isa(sets)) ? &&unimplemented_op : &&illegal_op,
+#define SH_DISPATCH
+#include "interpreter_ops.inc"
+#undef SH_DISPATCH
+#undef SH_UNIMPLEMENTED
+#undef SH_HANDLER
+  };
+
+  if(handlers[0].empty())
+    for(unsigned mode = 0; mode < fpu_mode_count; ++mode)
+    {
+      handlers[mode].resize(0x10000);
+      for(std::size_t first = 0; first < handlers[mode].size(); ++first)
+      {
+        const uint16_t entry = mode_tables[mode]->lookup(uint16_t(first));
+        handlers[mode][first] = entry == invalid_instruction ? &&illegal_op :
+                                decode_table::is_extended(entry) ? &&extended_op : labels[entry];
+      }
+    }
+
+  fpu_mode_changed();
+  if constexpr(has_dsp)
+    repeat_changed();
+  slot_record = nullptr;
+  limit = count;
+  slots = 0;
+  uint64_t done = 0;
+  uint32_t word;
+  const void* const* dispatch = handlers[fpu_mode].data();
+
+#define SH_NEXT \
+  if constexpr(has_dsp) \
+    if(PC == repeat_exit) \
+      repeat(); \
+  if(++done >= limit) \
+    goto finished; \
+  word = fetch(PC); \
+  goto *dispatch[word];
+
+  if(limit == 0)
+    return 0;
+  word = fetch(PC);
+  goto *dispatch[word];
+
+extended_op:
+  {
+    const uint32_t second = fetch(PC + 2);
+    const uint16_t id = table->decode(uint16_t(word), uint16_t(second));
+    word = word << 16 | second;
+    if(id == invalid_instruction)
+      goto illegal_op;
+    goto *labels[id];
+  }
+
+#define SH_ARG(k, field) (field)
+#define SH_WORD word
+#define SH_HANDLER(id, sets, call) \
+  op_##id: \
+    if constexpr(is_cpu(isa(sets))) \
+    { \
+      call; \
+      if constexpr(switches_fpu_mode(id)) \
+      { \
+        fpu_mode_changed(); \
+        dispatch = handlers[fpu_mode].data(); \
+      } \
+      if constexpr(changes_repeat(id)) \
+        repeat_changed(); \
+      SH_NEXT \
+    } \
+    goto illegal_op;
+#define SH_UNIMPLEMENTED(id, sets)
+#define SH_DISPATCH
+#include "interpreter_ops.inc"
+#undef SH_DISPATCH
+#undef SH_UNIMPLEMENTED
+#undef SH_HANDLER
+#undef SH_WORD
+#undef SH_ARG
+#undef SH_NEXT
+
+unimplemented_op:
+  unimplemented(word);
+illegal_op:
+  illegal(word);
+finished:
+  return done + slots;
+#else
+  return run_switched(count);
+#endif
+}
+
+template<isa Variant>
+uint32_t variant_core<Variant>::find_block(uint32_t pc)
+{
+  std::pair<uint32_t, uint32_t>& recent = recent_blocks[fpu_mode][(pc >> 1) & (recent_blocks[fpu_mode].size() - 1)];
+  if(recent.first != pc)
+  {
+    const auto known = blocks[fpu_mode].find(pc);
+    recent = { pc, known != blocks[fpu_mode].end() ? known->second : build_block(pc) };
+  }
+  return recent.second;
+}
+
+// decodes from 'pc' up to a branch, an illegal instruction or max_block
+// instructions.  an idiom counts as one, with its record ahead of its
+// instructions.  the blocks are kept by PC in the cache of the FPU mode, a
+// delayed branch ends its block with its slot in the end record, and writes
+// to the code or icbi drop them all.
+template<isa Variant>
+uint32_t variant_core<Variant>::build_block(uint32_t pc)
+{
+  if(code_map.empty())
+    code_map.resize((mem.size() >> code_granule_bits) + 1);
+
+  const uint32_t first = uint32_t(records.size());
+  records.push_back({ head_label, pc, invalid_instruction, {} });
+  uint32_t address = pc;
+  uint16_t id = invalid_instruction;
+  bool repeat_end = false;
+  uint32_t idiom_left = 0; // instructions
+  for(std::size_t n = 0; n < max_block && !repeat_end; n += idiom_left ? 0 : 1)
+  {
+    if(n && !mem.contains(address, 4))
+      break;
+    if(idiom_left)
+      --idiom_left;
+    else
+    {
+      const predecoded idiom = find_idiom(address);
+      if(idiom.handler)
+      {
+        records.push_back(idiom);
+        idiom_left = uint32_t(idiom.operand[idiom_length]) - 1;
+      }
+    }
+    predecoded r = {};
+    id = decode(address, r.word);
+    r.id = id;
+    r.handler = id == invalid_instruction ? illegal_label : block_labels[id];
+    if(id != invalid_instruction)
+    {
+      const operand_extractor& extractor = operand_extractors()[id];
+      for(std::size_t k = 0; k < extractor.count; ++k)
+        r.operand[k] = int32_t(extract_bits(r.word, extractor.field_mask[k]));
+    }
+    records.push_back(r);
+    if constexpr(has_dsp)
+      repeat_end = repeat_ends.count(address);
+    address += table->size(id);
+    if(id == invalid_instruction || ends_block[id])
+      break;
+  }
+  records[first].operand[head_length] = int32_t(records.size() - first - 1);
+
+  // the last instruction of a repeat loop, which may run again
+  if(repeat_end && !delayed[id])
+    records.push_back({ repeat_label, address - table->size(id), invalid_instruction, { int32_t(first) } });
+
+  // the slot of a delayed branch takes the place of the end record
+  predecoded end = { end_label, 0, invalid_instruction, {} };
+  if(id != invalid_instruction && delayed[id])
+  {
+    end.id = unfused_slot;
+    if(mem.contains(address, 4))
+    {
+      const uint16_t slot = decode(address, end.word);
+      end.id = slot == invalid_instruction || slot_illegal[slot] ? illegal_slot : slot;
+      if(slot != invalid_instruction)
+      {
+        const operand_extractor& extractor = operand_extractors()[slot];
+        for(std::size_t k = 0; k < extractor.count; ++k)
+          end.operand[k] = int32_t(extract_bits(end.word, extractor.field_mask[k]));
+      }
+      address += table->size(slot);
+    }
+  }
+  records.push_back(end);
+  blocks[fpu_mode].emplace(pc, first);
+  mark_code(pc, address - pc);
+  return first;
+}
+
+// an idiom of compiled code that starts at 'address', as the record that
+// runs it at once ahead of its instructions, or a record without handler.
+// the idioms are the unsigned division of the manual, div0u then 32 times
+// rotcl Rq and div1 Rm,Rn (64 by 32 bits), and chains of the same mac.w or
+// mac.l.  their instructions do not end blocks, and none of them may be the
+// last one of a repeat loop.
+template<isa Variant>
+typename variant_core<Variant>::predecoded variant_core<Variant>::find_idiom(uint32_t address)
+{
+  predecoded rval = { nullptr, 0, invalid_instruction, {} };
+  if(!mem.contains(address, 2))
+    return rval;
+  const uint32_t word = fetch(address);
+  const uint16_t id = table->lookup(uint16_t(word));
+
+  if(id == div0u_id && mem.contains(address, 2 + 32 * 4) && table->lookup(uint16_t(fetch(address + 2))) == rotcl_id &&
+     table->lookup(uint16_t(fetch(address + 4))) == div1_id)
+  {
+    const uint32_t rotcl = fetch(address + 2);
+    const uint32_t div1 = fetch(address + 4);
+    const int32_t m = int32_t(div1 >> 4 & 15), n = int32_t(div1 >> 8 & 15), q = int32_t(rotcl >> 8 & 15);
+    bool same = m != n && m != q && n != q;
+    for(uint32_t step = 1; same && step < 32; ++step)
+      same = fetch(address + 2 + step * 4) == rotcl && fetch(address + 4 + step * 4) == div1;
+    if(same)
+      rval = { divide_label, 0, invalid_instruction, { 1 + 32 * 2, m, n, q } };
+  }
+  else if(id == mac_w_id || id == mac_l_id)
+  {
+    uint32_t count = 1;
+    while(count < max_mac_chain && mem.contains(address + count * 2, 2) && fetch(address + count * 2) == word)
+      ++count;
+    const int32_t m = int32_t(word >> 4 & 15), n = int32_t(word >> 8 & 15);
+    if(count > 1 && m != n)
+      rval = { mac_label, word, id, { int32_t(count), m, n } };
+  }
+
+  // build_block stops where the next instruction is out of memory
+  if(rval.handler && !mem.contains(address, uint32_t(rval.operand[idiom_length]) * 2 + 2))
+    rval.handler = nullptr;
+  if constexpr(has_dsp)
+    for(uint32_t k = 0; rval.handler && k < uint32_t(rval.operand[idiom_length]); ++k)
+      if(repeat_ends.count(address + k * 2))
+        rval.handler = nullptr;
+  return rval;
+}
+
+// the instructions after 'head' as far as the JIT takes them.  the block
+// runs them from then on, or all of them on the handlers if none are taken.
+template<isa Variant>
+void variant_core<Variant>::translate_block(predecoded* head)
+{
+  if(!jit)
+    jit.reset(new block_jit({ mem.data(), mem.base(), uint32_t(mem.size()), code_map.data(), code_granule_bits,
+                              &code_written }));
+
+  std::vector<jit_instruction> code;
+  uint32_t address = head->word;
+  const predecoded* r = head + 1;
+  for(; r->handler != end_label && r->handler != repeat_label && r->handler != divide_label &&
+        r->handler != mac_label; ++r)
+  {
+    code.push_back({ r->id, r->word, address });
+    address += table->size(r->id);
+  }
+
+  // the predecoded slot of a delayed branch at the end, if it is legal
+  const jit_instruction slot = { r->id, r->word, address };
+  const bool has_slot = r->id < illegal_slot;
+
+  uint32_t translated;
+  const jit_function function = jit->translate(code, has_slot ? &slot : nullptr, translated);
+  if(!function)
+  {
+    head->handler = body_label;
+    if(jit->full())
+      code_written = true; // starts over at the end of the block
+    return;
+  }
+
+  const bool with_slot = has_slot && translated == code.size() && delayed[code.back().id];
+  head->handler = translated_label;
+  head->operand[head_translated] = int32_t(translated);
+  head->operand[head_function] = int32_t(translations.size());
+  head->operand[head_slot] = with_slot;
+  translations.push_back(function);
+}
+
+// the instructions run from the records of predecoded blocks, handler to
+// handler, and the next block is looked up by the PC at the end of a block.
+// with 'translate' the blocks that have run hot_block_runs times go to the
+// JIT, and the instructions it leaves out still run on the handlers.
+template<isa Variant>
+uint64_t variant_core<Variant>::run_blocks(uint64_t count, bool translate)
+{
+#if SH_COMPUTED_GOTO
+  if(block_labels.empty())
+  {
+    static const void* const labels[] =
+    {
+#define SH_HANDLER(id, sets, call) is_cpu(isa(sets)) ? &&op_##id : &&illegal_op,
+#define SH_UNIMPLEMENTED(id, sets) is_cpu(isa(sets)) ? &&unimplemented_op : &&illegal_op,
+#define SH_DISPATCH
+#include "interpreter_ops.inc"
+#undef SH_DISPATCH
+#undef SH_UNIMPLEMENTED
+#undef SH_HANDLER
+    };
+    block_labels.assign(std::begin(labels), std::end(labels));
+    illegal_label = &&illegal_op;
+    head_label = &&block_head;
+    body_label = &&block_body;
+    translated_label = &&translated_block;
+    repeat_label = &&block_repeat;
+    divide_label = &&block_divide;
+    mac_label = &&block_mac;
+    end_label = &&block_end;
+  }
+
+  fpu_mode_changed();
+  if constexpr(has_dsp)
+    repeat_changed();
+  limit = count;
+  slots = 0;
+  uint64_t done = 0;
+  predecoded* rec;
+  const uint32_t entry = translate ? 0 : 1; // with or without the head record
+
+#define SH_NEXT \
+  if(++done >= limit) \
+    goto finished; \
+  ++rec; \
+  goto *rec->handler;
+
+  if(limit == 0)
+    return 0;
+
+block_end:
+  if(code_written)
+    flush_blocks();
+  rec = &records[find_block(PC)];
+  slot_record = rec + 1 + rec->operand[head_length];
+  rec += entry;
+  goto *rec->handler;
+
+block_head:
+  if(++rec->operand[head_runs] == hot_block_runs)
+    translate_block(rec);
+block_body:
+  ++rec;
+  goto *rec->handler;
+
+// straight back to the first instruction of the loop when it starts the
+// block, else on to the end record
+block_repeat:
+  if(rec->word == repeat_last)
+  {
+    repeat();
+    predecoded* head = &records[uint32_t(rec->operand[repeat_head])];
+    if(PC == head->word && !code_written)
+    {
+      rec = head + entry;
+      goto *rec->handler;
+    }
+  }
+  ++rec;
+  goto *rec->handler;
+
+// the division idiom as a host division when the high word of the dividend
+// in Rn is below the divisor in Rm, so that the quotient fits, else on to its
+// instructions.  Rq, Rn, T, Q and M end up as after the 32 steps: Rq the
+// quotient over 2 and T its low bit, Rn the remainder, less the divisor when
+// T is 0 (Q, its sign, is 1 then).
+block_divide:
+  {
+    const uint32_t length = uint32_t(rec->operand[idiom_length]);
+    const uint32_t divisor = R[rec->operand[idiom_rm]];
+    uint32_t& rn = R[rec->operand[idiom_rn]];
+    uint32_t& rq = R[rec->operand[idiom_rq]];
+    if(done + length <= limit && rn < divisor)
+    {
+      const uint64_t dividend = uint64_t(rn) << 32 | rq;
+      const uint32_t quotient = uint32_t(dividend / divisor);
+      const uint32_t remainder = uint32_t(dividend % divisor);
+      rq = quotient >> 1;
+      rn = quotient & 1 ? remainder : remainder - divisor;
+      T = quotient & 1;
+      Q = ~quotient & 1;
+      M = 0;
+      PC += length * 2;
+      done += length - 1;
+      rec += length;
+      SH_NEXT
+    }
+    ++rec;
+    goto *rec->handler;
+  }
+
+// a mac chain with S = 0 as one sum of the products, when all its operands
+// are in memory and aligned, else on to its instructions.  MAC is 42 bits on
+// SH1 for mac.w.
+block_mac:
+  {
+    const uint32_t count = uint32_t(rec->operand[idiom_length]);
+    const uint32_t size = rec->id == mac_l_id ? 4 : 2;
+    uint32_t& rm = R[rec->operand[idiom_rm]];
+    uint32_t& rn = R[rec->operand[idiom_rn]];
+    if(done + count <= limit && !S && !((rm | rn) & (size - 1)) && mem.contains(rm, count * size) &&
+       mem.contains(rn, count * size))
+    {
+      const uint8_t* a = mem.data() + ((rm & 0x1FFFFFFF) - mem.base());
+      const uint8_t* b = mem.data() + ((rn & 0x1FFFFFFF) - mem.base());
+      const uint64_t mac = (uint64_t(MACH) << 32 | MACL) + (size == 4 ? mac_l_sum(a, b, count) : mac_w_sum(a, b, count));
+      MACL = uint32_t(mac);
+      MACH = uint32_t(mac >> 32);
+      if constexpr(is_cpu(SH1))
+        if(size == 2)
+          MACH = uint32_t(int32_t(MACH << 22) >> 22);
+      rm += count * size;
+      rn += count * size;
+      PC += count * 2;
+      done += count - 1;
+      rec += count;
+      SH_NEXT
+    }
+    ++rec;
+    goto *rec->handler;
+  }
+
+translated_block:
+  {
+    const uint32_t translated = uint32_t(rec->operand[head_translated]);
+    if(done + translated > limit)
+      goto block_body;
+    const uint32_t completed = translations[std::size_t(rec->operand[head_function])](this);
+    done += completed;
+    if(completed == translated)
+      slots += uint32_t(rec->operand[head_slot]);
+    if(done >= limit)
+      goto finished;
+    rec += 1 + completed;
+    goto *rec->handler;
+  }
+
+#define SH_ARG(k, field) rec->operand[k]
+#define SH_WORD rec->word
+#define SH_HANDLER(id, sets, call) \
+  op_##id: \
+    if constexpr(is_cpu(isa(sets))) \
+    { \
+      call; \
+      if constexpr(switches_fpu_mode(id)) \
+        fpu_mode_changed(); \
+      if constexpr(changes_repeat(id)) \
+        repeat_changed(); \
+      SH_NEXT \
+    } \
+    goto illegal_op;
+#define SH_UNIMPLEMENTED(id, sets)
+#define SH_DISPATCH
+#include "interpreter_ops.inc"
+#undef SH_DISPATCH
+#undef SH_UNIMPLEMENTED
+#undef SH_HANDLER
+#undef SH_WORD
+#undef SH_ARG
+#undef SH_NEXT
+
+unimplemented_op:
+  unimplemented(rec->word);
+illegal_op:
+  illegal(rec->word);
+finished:
+  // a loop that has run up to its last instruction
+  if constexpr(has_dsp)
+    if(PC == repeat_exit)
+      repeat();
+  slot_record = nullptr;
+  return done + slots;
+#else
+  return run_switched(count);
+#endif
+}
+
+#undef SH_FIELD
+
+// ----------------------------------------------------------------------------
+
+interpreter::interpreter(isa variant, guest_memory& memory)
+{
+  switch(variant)
+  {
+    case SH1:      core.reset(new variant_core<SH1>(memory)); break;
+    case SH1_DSP:  core.reset(new variant_core<SH1_DSP>(memory)); break;
+    case SH2:      core.reset(new variant_core<SH2>(memory)); break;
+    case SH2_DSP:  core.reset(new variant_core<SH2_DSP>(memory)); break;
+    case SH2E:     core.reset(new variant_core<SH2E>(memory)); break;
+    case SH2A:     core.reset(new variant_core<SH2A>(memory)); break;
+    case SH2A_FPU: core.reset(new variant_core<SH2A_FPU>(memory)); break;
+    case SH3:      core.reset(new variant_core<SH3>(memory)); break;
+    case SH3_FPU:  core.reset(new variant_core<SH3_FPU>(memory)); break;
+    case SH3_DSP:  core.reset(new variant_core<SH3_DSP>(memory)); break;
+    case SH4:      core.reset(new variant_core<SH4>(memory)); break;
+    case SH4A:     core.reset(new variant_core<SH4A>(memory)); break;
+    default:
+      throw("no interpreter for cpu "s + std::to_string(variant));
+  }
+}
+
+interpreter::~interpreter(void) = default;
+
+cpu_state& interpreter::state(void)
+{
+  return *core;
+}
+
+uint64_t interpreter::run(uint64_t count, dispatch_mode mode)
+{
+  core->sleeping = false;
+  switch(mode)
+  {
+    case threaded: return core->run_threaded(count);
+    case switched: return core->run_switched(count);
+    case blocks:   return core->run_blocks(count, false);
+    case jit:      return core->run_blocks(count, true);
+  }
+  return 0;
+}
+
+bool interpreter::sleeping(void) const
+{
+  return core->sleeping;
+}
+
+bool interpreter::has_threaded_dispatch(void)
+{
+  return SH_COMPUTED_GOTO;
+}
@@ -0,0 +1,159 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "decoder.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// registers of an SH CPU, named as in the operation snippets of the database
+struct cpu_state
+{
+  std::array<uint32_t, 16> R = {};
+  uint32_t PC = 0;
+  uint32_t PR = 0;
+  uint32_t SR = 0;
+  uint32_t GBR = 0;
+  uint32_t VBR = 0;
+  uint32_t MACH = 0;
+  uint32_t MACL = 0;
+  uint32_t SSR = 0;
+  uint32_t SPC = 0;
+  uint32_t SGR = 0;
+  uint32_t DBR = 0;
+  uint32_t TBR = 0;
+  uint32_t FPUL = 0;
+  uint32_t FPSCR = 0;
+  uint32_t TRA = 0;    // trap and exception registers of SH3 and SH4
+  uint32_t EXPEVT = 0;
+  // floating-point registers as bits, bank 0 then bank 1.  FPSCR.FR picks the
+  // bank of FR0-FR15, the other one is XF0-XF15.  aligned for the vector
+  // loads of fpu_kernels.h.
+  alignas(16) std::array<uint32_t, 32> FPR = {};
+  // DSP unit of the SH-DSP variants: the accumulators with their guard bits
+  // (sign extended from bit 7), the input registers, DSR, the modulo and
+  // the repeat start and end registers
+  uint32_t A0 = 0;
+  uint32_t A0G = 0;
+  uint32_t A1 = 0;
+  uint32_t A1G = 0;
+  uint32_t M0 = 0;
+  uint32_t M1 = 0;
+  uint32_t X0 = 0;
+  uint32_t X1 = 0;
+  uint32_t Y0 = 0;
+  uint32_t Y1 = 0;
+  uint32_t DSR = 0;
+  uint32_t MOD = 0;
+  uint32_t RS = 0;
+  uint32_t RE = 0;
+};
+
+// big endian memory of the guest, one block at 'base'.
+// addresses are used without the area bits (the top three), so the block
+// shows up in every area.  accesses outside of it and misaligned ones throw.
+class guest_memory
+{
+public:
+  guest_memory(uint32_t base, std::size_t size);
+
+  uint32_t base(void) const { return origin; }
+  std::size_t size(void) const { return bytes.size(); }
+  uint8_t* data(void) { return bytes.data(); }
+
+  bool contains(uint32_t address, uint32_t size) const
+    { return (address & 0x1FFFFFFF) - origin <= bytes.size() - size; }
+
+  uint32_t read_8(uint32_t address) const { return *at(address, 1); }
+  uint32_t read_16(uint32_t address) const
+  {
+    const uint8_t* p = at(address, 2);
+    return uint32_t(p[0]) << 8 | p[1];
+  }
+  uint32_t read_32(uint32_t address) const
+  {
+    const uint8_t* p = at(address, 4);
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+  }
+
+  void write_8(uint32_t address, uint32_t value) { *at(address, 1) = uint8_t(value); }
+  void write_16(uint32_t address, uint32_t value)
+  {
+    uint8_t* p = at(address, 2);
+    p[0] = uint8_t(value >> 8);
+    p[1] = uint8_t(value);
+  }
+  void write_32(uint32_t address, uint32_t value)
+  {
+    uint8_t* p = at(address, 4);
+    p[0] = uint8_t(value >> 24);
+    p[1] = uint8_t(value >> 16);
+    p[2] = uint8_t(value >> 8);
+    p[3] = uint8_t(value);
+  }
+
+  // pairs of registers, the first one at 'address'
+  uint64_t read_64(uint32_t address) const
+  {
+    at(address, 8);
+    return uint64_t(read_32(address)) << 32 | read_32(address + 4);
+  }
+  void write_64(uint32_t address, uint64_t value)
+  {
+    at(address, 8);
+    write_32(address, uint32_t(value >> 32));
+    write_32(address + 4, uint32_t(value));
+  }
+
+private:
+  uint8_t* at(uint32_t address, uint32_t size) const
+  {
+    const uint32_t offset = (address & 0x1FFFFFFF) - origin;
+    if(offset > bytes.size() - size || (address & (size - 1)))
+      fault(address, size);
+    return const_cast<uint8_t*>(bytes.data()) + offset;
+  }
+
+  [[noreturn]] void fault(uint32_t address, uint32_t size) const;
+
+  uint32_t origin;
+  std::vector<uint8_t> bytes;
+};
+
+class interpreter_core;
+
+// executes the instructions of one CPU variant with the handlers that
+// sh_gen interpreter makes from the operation snippets of the database.
+// without computed goto (GCC and clang only) every dispatch mode falls back
+// to the switch.
+class interpreter
+{
+public:
+  // threaded: handler to handler by the first halfword.  switched: by the
+  // decoded id.  blocks: from predecoded basic blocks.  jit: blocks, with the
+  // hot ones translated to x86-64.
+  enum dispatch_mode { threaded, switched, blocks, jit };
+
+  interpreter(isa variant, guest_memory& memory);
+  ~interpreter(void);
+
+  cpu_state& state(void);
+
+  // runs until 'count' instructions (delay slots included) have executed or
+  // a sleep instruction, and returns the number executed.  illegal and
+  // unimplemented instructions and memory faults throw std::string, with the
+  // PC at the instruction.
+  uint64_t run(uint64_t count, dispatch_mode mode = threaded);
+
+  bool sleeping(void) const;
+
+  // false when threaded, block and jit dispatch fall back to the switch
+  static bool has_threaded_dispatch(void);
+
+private:
+  std::unique_ptr<interpreter_core> core;
+};
+
+#endif // INTERPRETER_H
@@ -0,0 +1,206 @@
+#include "isa_detector.h"
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define HAVE_X86_INTRINSICS
+#endif
+
+isa isa_scan::minimum(void) const
+{
+  for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+    if(cpus & (1u << v))
+      return cpu_variants[v];
+  return SH_NONE;
+}
+
+std::string cpu_set_names(cpu_set cpus)
+{
+  std::string rval;
+  for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+  {
+    if(!(cpus & (1u << v)))
+      continue;
+    if(!rval.empty())
+      rval += ' ';
+    rval += cpu_name(cpu_variants[v]);
+  }
+  return rval;
+}
+
+isa_detector::isa_detector(void)
+  : all(std::make_unique<decode_table>(SH_ALL)),
+    first_cpus(0x10000 + 1, all_cpus)
+{
+  for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+    variants[v] = &decode_table_for(cpu_variants[v]);
+
+  // unknown halfwords keep every variant, 32-bit instructions are handled by scan_one()
+  for(std::size_t word = 0; word < 0x10000; ++word)
+  {
+    const uint16_t entry = all->lookup(uint16_t(word));
+    if(entry == invalid_instruction || decode_table::is_extended(entry))
+      continue;
+
+    cpu_set cpus = 0;
+    for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+      if(variants[v]->lookup(uint16_t(word)) != invalid_instruction)
+        cpus |= cpu_set(1u << v);
+    first_cpus[word] = cpus;
+  }
+}
+
+void isa_detector::narrow(isa_scan& out, cpu_set cpus, std::size_t pos, uint16_t first, uint16_t second) const
+{
+  // the instruction as decoded by the first variant that executes it
+  // (the combined table has one entry for encodings that differ between variants)
+  uint16_t id = all->decode(first, second);
+  for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+  {
+    if(cpus & (1u << v))
+    {
+      id = variants[v]->decode(first, second);
+      break;
+    }
+  }
+
+  const cpu_set dropped = out.cpus & ~cpus;
+  for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+    if(dropped & (1u << v))
+      out.excluded.push_back({ cpu_variants[v], uint32_t(pos * 2), id });
+  out.cpus &= cpus;
+}
+
+std::size_t isa_detector::scan_one(const uint16_t* words, std::size_t pos, std::size_t count, isa_scan& out) const
+{
+  const uint16_t first = words[pos];
+  const uint16_t entry = all->lookup(first);
+  if(entry == invalid_instruction)
+  {
+    ++out.unknown;
+    return 1;
+  }
+
+  if(!decode_table::is_extended(entry))
+  {
+    ++out.instructions;
+    if((out.cpus & first_cpus[first]) != out.cpus)
+      narrow(out, first_cpus[first], pos, first, pos + 1 < count ? words[pos + 1] : 0);
+    return 1;
+  }
+
+  const uint16_t second = pos + 1 < count ? words[pos + 1] : 0;
+  const uint16_t id = all->decode(first, second);
+  if(id == invalid_instruction || pos + all->size(id) / 2 > count)
+  {
+    ++out.unknown;
+    return 1;
+  }
+
+  cpu_set cpus = 0;
+  for(std::size_t v = 0; v < cpu_variants.size(); ++v)
+    if(variants[v]->decode(first, second) != invalid_instruction)
+      cpus |= cpu_set(1u << v);
+
+  ++out.instructions;
+  if((out.cpus & cpus) != out.cpus)
+    narrow(out, cpus, pos, first, second);
+  return all->size(id) / 2;
+}
+
+isa_scan isa_detector::scan_scalar(const uint16_t* words, std::size_t count) const
+{
+  isa_scan rval;
+  for(std::size_t pos = 0; pos < count; )
+    pos += scan_one(words, pos, count, rval);
+  return rval;
+}
+
+#if defined(HAVE_X86_INTRINSICS)
+__attribute__((target("avx2")))
+isa_scan isa_detector::scan_avx2(const uint16_t* words, std::size_t count) const
+{
+  const int* first_level = reinterpret_cast<const int*>(all->data());
+  const int* cpus_data = reinterpret_cast<const int*>(first_cpus.data());
+
+  const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+  const __m256i flag = _mm256_set1_epi32(decode_table::extended_flag);
+  const __m256i invalid = _mm256_set1_epi32(invalid_instruction);
+  const __m256i lanes_low = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i lanes_high = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+
+  isa_scan rval;
+  std::size_t pos = 0;
+  while(pos + 16 <= count)
+  {
+    const __m256i w0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + pos)));
+    const __m256i w1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + pos + 8)));
+
+    const __m256i e0 = _mm256_and_si256(_mm256_i32gather_epi32(first_level, w0, 2), low16);
+    const __m256i e1 = _mm256_and_si256(_mm256_i32gather_epi32(first_level, w1, 2), low16);
+
+    const __m256i u0 = _mm256_cmpeq_epi32(e0, invalid);
+    const __m256i u1 = _mm256_cmpeq_epi32(e1, invalid);
+    const __m256i x0 = _mm256_andnot_si256(u0, _mm256_cmpeq_epi32(_mm256_and_si256(e0, flag), flag));
+    const __m256i x1 = _mm256_andnot_si256(u1, _mm256_cmpeq_epi32(_mm256_and_si256(e1, flag), flag));
+
+    // lanes before the first 32-bit instruction are 16-bit instructions or data
+    const unsigned extended = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(x0))) |
+                              unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(x1))) << 8;
+    const std::size_t valid = extended ? std::size_t(__builtin_ctz(extended)) : 16;
+    const __m256i limit = _mm256_set1_epi32(int(valid));
+
+    // the lanes past 'valid' keep every variant
+    __m256i c0 = _mm256_i32gather_epi32(cpus_data, w0, 2);
+    __m256i c1 = _mm256_i32gather_epi32(cpus_data, w1, 2);
+    c0 = _mm256_or_si256(c0, _mm256_andnot_si256(_mm256_cmpgt_epi32(limit, lanes_low), low16));
+    c1 = _mm256_or_si256(c1, _mm256_andnot_si256(_mm256_cmpgt_epi32(limit, lanes_high), low16));
+
+    __m256i c = _mm256_and_si256(c0, c1);
+    __m128i h = _mm_and_si128(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+    h = _mm_and_si128(h, _mm_shuffle_epi32(h, 0x4E));
+    h = _mm_and_si128(h, _mm_shuffle_epi32(h, 0xB1));
+    const cpu_set block = cpu_set(_mm_cvtsi128_si32(h));
+
+    if((rval.cpus & block) != rval.cpus)
+    {
+      // a variant drops out in this block, find the instruction responsible
+      for(std::size_t lane = 0; lane < valid; ++lane)
+        scan_one(words, pos + lane, count, rval);
+    }
+    else
+    {
+      const unsigned unknown = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(u0))) |
+                               unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(u1))) << 8;
+      const std::size_t data = std::size_t(__builtin_popcount(unknown & ((1u << valid) - 1)));
+      rval.unknown += data;
+      rval.instructions += valid - data;
+    }
+
+    pos += valid;
+    if(extended)
+      pos += scan_one(words, pos, count, rval);
+  }
+
+  while(pos < count)
+    pos += scan_one(words, pos, count, rval);
+  return rval;
+}
+
+isa_scan isa_detector::scan(const uint16_t* words, std::size_t count) const
+{
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2 ? scan_avx2(words, count) : scan_scalar(words, count);
+}
+#else
+isa_scan isa_detector::scan_avx2(const uint16_t* words, std::size_t count) const
+{
+  return scan_scalar(words, count);
+}
+
+isa_scan isa_detector::scan(const uint16_t* words, std::size_t count) const
+{
+  return scan_scalar(words, count);
+}
+#endif
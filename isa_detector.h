@@ -0,0 +1,61 @@
+#ifndef ISA_DETECTOR_H
+#define ISA_DETECTOR_H
+
+#include "decode_table.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// CPU variants as a bit set, bit n standing for cpu_variants[n]
+typedef uint16_t cpu_set;
+constexpr cpu_set all_cpus = cpu_set((1u << isa_count) - 1);
+
+struct isa_exclusion
+{
+  isa cpu;         // variant that cannot execute ...
+  uint32_t offset; // ... the instruction at this byte offset
+  uint16_t id;
+};
+
+struct isa_scan
+{
+  cpu_set cpus = all_cpus;           // variants that execute every decoded instruction
+  std::vector<isa_exclusion> excluded; // first offending instruction of the others, by offset
+  std::size_t instructions = 0;      // decoded instructions
+  std::size_t unknown = 0;           // halfwords no variant decodes (data)
+
+  // first variant of cpu_variants left in 'cpus', SH_NONE if none
+  isa minimum(void) const;
+};
+
+// finds the CPU variants able to execute an instruction stream.
+// the stream is decoded with the instructions of every variant; each
+// instruction narrows the set down to the variants that decode it too.
+// halfwords no variant knows are taken as data and skipped.
+class isa_detector
+{
+public:
+  isa_detector(void);
+
+  // 'words' in host byte order
+  isa_scan scan(const uint16_t* words, std::size_t count) const;
+
+  isa_scan scan_scalar(const uint16_t* words, std::size_t count) const;
+  isa_scan scan_avx2(const uint16_t* words, std::size_t count) const;
+
+private:
+  std::size_t scan_one(const uint16_t* words, std::size_t pos, std::size_t count, isa_scan& out) const;
+  void narrow(isa_scan& out, cpu_set cpus, std::size_t pos, uint16_t first, uint16_t second) const;
+
+  std::unique_ptr<decode_table> all;          // every instruction of the database
+  std::array<const decode_table*, isa_count> variants;
+  std::vector<uint16_t> first_cpus;           // cpu_set of the 16-bit instructions by halfword
+};
+
+// variant names of a cpu_set ("SH2A SH2A_FPU")
+std::string cpu_set_names(cpu_set cpus);
+
+#endif // ISA_DETECTOR_H
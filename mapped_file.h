@@ -0,0 +1,59 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// read only memory mapping of a whole file
+class mapped_file
+{
+public:
+  explicit mapped_file(const std::string& path)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw(std::string("unable to open: ") + path);
+    struct stat info;
+    if(::fstat(fd, &info) < 0)
+    {
+      ::close(fd);
+      throw(std::string("unable to stat: ") + path);
+    }
+    length = std::size_t(info.st_size);
+    if(length)
+    {
+      void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(address == MAP_FAILED)
+      {
+        ::close(fd);
+        throw(std::string("unable to map: ") + path);
+      }
+      bytes = static_cast<const uint8_t*>(address);
+      ::madvise(address, length, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+  }
+
+  ~mapped_file(void)
+  {
+    if(bytes)
+      ::munmap(const_cast<uint8_t*>(bytes), length);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator =(const mapped_file&) = delete;
+
+  const uint8_t* data(void) const { return bytes; }
+  std::size_t size(void) const { return length; }
+
+private:
+  const uint8_t* bytes = nullptr;
+  std::size_t length = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,163 @@
+#ifndef NAME_HASH_H
+#define NAME_HASH_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// a key of a name_hash_table and the ids it stands for
+struct hashed_name
+{
+  std::string_view key;
+  uint16_t first; // in the id list of the table
+  uint16_t count;
+};
+
+// instruction ids of a name
+struct name_ids
+{
+  const uint16_t* first = nullptr;
+  std::size_t count = 0;
+
+  constexpr const uint16_t* begin(void) const { return first; }
+  constexpr const uint16_t* end(void) const { return first + count; }
+  constexpr std::size_t size(void) const { return count; }
+  constexpr bool empty(void) const { return count == 0; }
+};
+
+// FNV-1a
+constexpr uint64_t name_hash(std::string_view key)
+{
+  uint64_t h = 0xcbf29ce484222325ull;
+  for(char c : key)
+  {
+    h ^= uint8_t(c);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+// minimal perfect hash over a fixed set of names, built by the compiler
+// (hash and displace).  the low bits of the hash pick a bucket.  buckets of
+// several keys get the displacement that moves all of them to free slots,
+// largest buckets first; single keys then take the slots left over directly.
+// a lookup is one hash, two table reads and one key compare.
+template<std::size_t N>
+class name_hash_table
+{
+public:
+  static_assert(N > 0 && N < 0x8000, "too many names");
+
+  constexpr explicit name_hash_table(const std::array<hashed_name, N>& names)
+  {
+    // the keys by bucket
+    std::array<uint64_t, N> hashes = {};
+    std::array<std::size_t, bucket_count + 1> start = {};
+    for(std::size_t n = 0; n < N; ++n)
+    {
+      hashes[n] = name_hash(names[n].key);
+      ++start[(hashes[n] & (bucket_count - 1)) + 1];
+    }
+    std::size_t largest = 0;
+    for(std::size_t b = 0; b < bucket_count; ++b)
+    {
+      largest = start[b + 1] > largest ? start[b + 1] : largest;
+      start[b + 1] += start[b];
+    }
+    std::array<std::size_t, N> members = {};
+    std::array<std::size_t, bucket_count> filled = {};
+    for(std::size_t n = 0; n < N; ++n)
+    {
+      const std::size_t b = hashes[n] & (bucket_count - 1);
+      members[start[b] + filled[b]++] = n;
+    }
+
+    std::array<bool, N> used = {};
+    for(std::size_t size = largest; size > 1; --size)
+      for(std::size_t b = 0; b < bucket_count; ++b)
+        if(start[b + 1] - start[b] == size)
+          place_bucket(names, hashes, &members[start[b]], size, b, used);
+
+    std::size_t free_slot = 0;
+    for(std::size_t b = 0; b < bucket_count; ++b)
+      if(start[b + 1] - start[b] == 1)
+      {
+        while(used[free_slot])
+          ++free_slot;
+        used[free_slot] = true;
+        slots[free_slot] = names[members[start[b]]];
+        displacements[b] = uint16_t(direct | free_slot);
+      }
+  }
+
+  // nullptr if 'key' is not one of the names
+  constexpr const hashed_name* find(std::string_view key) const
+  {
+    const uint64_t h = name_hash(key);
+    const hashed_name& slot = slots[slot_of(h, displacements[h & (bucket_count - 1)])];
+    return slot.key == key ? &slot : nullptr;
+  }
+
+  // in slot order
+  constexpr const std::array<hashed_name, N>& names(void) const { return slots; }
+
+private:
+  static constexpr std::size_t bucket_count = []
+  {
+    std::size_t count = 1;
+    while(count * 2 < N)
+      count *= 2;
+    return count;
+  }();
+
+  // displacements of single keys are their slot
+  static constexpr uint16_t direct = 0x8000;
+  static constexpr std::size_t max_bucket = 16;
+
+  static constexpr std::size_t slot_of(uint64_t h, uint16_t displacement)
+  {
+    if(displacement & direct)
+      return displacement & (direct - 1);
+    // every displacement mixes all bits of the hash again
+    uint64_t x = h + displacement * 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 32)) * 0xD6E8FEB86659FD93ull;
+    return std::size_t((x ^ (x >> 32)) % N);
+  }
+
+  constexpr void place_bucket(const std::array<hashed_name, N>& names, const std::array<uint64_t, N>& hashes,
+                              const std::size_t* members, std::size_t count, std::size_t bucket,
+                              std::array<bool, N>& used)
+  {
+    if(count > max_bucket)
+      throw "name hash bucket too large";
+
+    for(uint16_t d = 0; d < direct; ++d)
+    {
+      std::array<std::size_t, max_bucket> taken = {};
+      bool fits = true;
+      for(std::size_t k = 0; k < count && fits; ++k)
+      {
+        taken[k] = slot_of(hashes[members[k]], d);
+        fits = !used[taken[k]];
+        for(std::size_t j = 0; j < k && fits; ++j)
+          fits = taken[j] != taken[k];
+      }
+      if(!fits)
+        continue;
+
+      for(std::size_t k = 0; k < count; ++k)
+      {
+        used[taken[k]] = true;
+        slots[taken[k]] = names[members[k]];
+      }
+      displacements[bucket] = d;
+      return;
+    }
+    throw "no perfect hash for the names";
+  }
+
+  std::array<hashed_name, N> slots = {};
+  std::array<uint16_t, bucket_count> displacements = {};
+};
+
+#endif // NAME_HASH_H
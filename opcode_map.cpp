@@ -0,0 +1,140 @@
+#include "opcode_map.h"
+#include "decode_table.h"
+
+#include <memory>
+#include <mutex>
+
+opcode_map::opcode_map(isa variant)
+  : target(variant)
+{
+  const decode_table& table = decode_table_for(variant);
+  const std::vector<instruction_entry>& entries = instruction_entries();
+
+  auto slot_illegal_id = [&](uint16_t id)
+    { return id == invalid_instruction || raises_slot_illegal(*entries[id].source); };
+
+  // a bucket is illegal when all of its second halfwords are
+  std::vector<std::pair<bool, bool>> buckets(table.bucket_count());
+  std::vector<bool> bucket_done(table.bucket_count(), false);
+
+  for(std::size_t word = 0; word < 0x10000; ++word)
+  {
+    const uint16_t first = uint16_t(word);
+    const uint16_t entry = table.lookup(first);
+    bool general = entry == invalid_instruction;
+    bool slot = general;
+
+    if(decode_table::is_extended(entry))
+    {
+      const std::size_t bucket = entry & ~decode_table::extended_flag;
+      if(!bucket_done[bucket])
+      {
+        bool all_invalid = true;
+        bool all_slot_illegal = true;
+        for(std::size_t second = 0; second < 0x10000; ++second)
+        {
+          uint16_t id = table.decode(first, uint16_t(second));
+          all_invalid = all_invalid && id == invalid_instruction;
+          all_slot_illegal = all_slot_illegal && slot_illegal_id(id);
+        }
+        buckets[bucket] = { all_invalid, all_slot_illegal };
+        bucket_done[bucket] = true;
+      }
+      general = buckets[bucket].first;
+      slot = buckets[bucket].second;
+    }
+    else if(!general)
+      slot = slot_illegal_id(entry);
+
+    if(general)
+      illegal[word >> 6] |= uint64_t(1) << (word & 63);
+    if(slot)
+      slot_illegal[word >> 6] |= uint64_t(1) << (word & 63);
+  }
+}
+
+std::size_t opcode_map::illegal_count(void) const
+{
+  std::size_t count = 0;
+  for(uint64_t bits : illegal)
+    count += std::size_t(__builtin_popcountll(bits));
+  return count;
+}
+
+std::vector<std::pair<uint16_t, uint16_t>> opcode_map::illegal_ranges(void) const
+{
+  std::vector<std::pair<uint16_t, uint16_t>> rval;
+  for(std::size_t word = 0; word < 0x10000; ++word)
+  {
+    if(!is_illegal(uint16_t(word)))
+      continue;
+    if(!rval.empty() && rval.back().second + 1u == word)
+      rval.back().second = uint16_t(word);
+    else
+      rval.emplace_back(uint16_t(word), uint16_t(word));
+  }
+  return rval;
+}
+
+const opcode_map& opcode_map_for(isa variant)
+{
+  static std::mutex lock;
+  static std::array<std::unique_ptr<opcode_map>, isa_count> maps;
+
+  std::lock_guard<std::mutex> guard(lock);
+  std::unique_ptr<opcode_map>& map = maps[countr_zero(uint16_t(variant)) % isa_count];
+  if(!map)
+    map = std::make_unique<opcode_map>(variant);
+  return *map;
+}
+
+bool raises_slot_illegal(const insn& i)
+{
+  return i.data<exceptions>().find("Slot illegal instruction") != std::string::npos;
+}
+
+namespace
+{
+  bool starts_with(const std::string& text, const char* prefix)
+    { return text.compare(0, std::char_traits<char>::length(prefix), prefix) == 0; }
+
+  bool is_x_move(const instruction_entry& entry)
+  {
+    const std::string& fmt = entry.source->data<format>();
+    return starts_with(fmt, "movx") || starts_with(fmt, "nopx");
+  }
+
+  bool is_y_move(const instruction_entry& entry)
+  {
+    const std::string& fmt = entry.source->data<format>();
+    return starts_with(fmt, "movy") || starts_with(fmt, "nopy");
+  }
+}
+
+std::vector<pattern_overlap> pattern_overlaps(isa variant)
+{
+  const isa instruction_sets = cpu_instruction_sets(variant);
+  std::vector<const instruction_entry*> entries;
+  for(const instruction_entry& entry : instruction_entries())
+    if(entry.source->for_isa(instruction_sets))
+      entries.push_back(&entry);
+
+  std::vector<pattern_overlap> rval;
+  for(std::size_t a = 0; a < entries.size(); ++a)
+  {
+    for(std::size_t b = a + 1; b < entries.size(); ++b)
+    {
+      const opcode_pattern& pa = entries[a]->pattern;
+      const opcode_pattern& pb = entries[b]->pattern;
+      if(pa.width != pb.width || ((pa.match ^ pb.match) & pa.mask & pb.mask))
+        continue;
+
+      const int free_bits = pa.width - __builtin_popcount(pa.mask | pb.mask);
+      const bool parallel = is_x_move(*entries[a]) != is_x_move(*entries[b]) &&
+                            is_y_move(*entries[a]) != is_y_move(*entries[b]);
+      rval.push_back({ entries[a]->id, entries[b]->id, uint64_t(1) << free_bits,
+                       parallel, !parallel && specificity(pa) == specificity(pb) });
+    }
+  }
+  return rval;
+}
@@ -0,0 +1,65 @@
+#ifndef OPCODE_MAP_H
+#define OPCODE_MAP_H
+
+#include "decoder.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// first halfwords of one CPU variant as 64K bit sets.
+// a halfword that starts 32-bit forms only counts as illegal when no second
+// halfword makes it an instruction.
+class opcode_map
+{
+public:
+  static constexpr std::size_t bitset_words = 0x10000 / 64;
+  typedef std::array<uint64_t, bitset_words> bitset;
+
+  explicit opcode_map(isa variant);
+
+  isa variant(void) const { return target; }
+
+  // general illegal instruction
+  bool is_illegal(uint16_t first) const
+    { return (illegal[first >> 6] >> (first & 63)) & 1; }
+
+  // slot illegal instruction when executed in a delay slot
+  // (the instructions listing it in their exceptions, and illegal ones)
+  bool is_slot_illegal(uint16_t first) const
+    { return (slot_illegal[first >> 6] >> (first & 63)) & 1; }
+
+  const bitset& illegal_bits(void) const { return illegal; }
+  const bitset& slot_illegal_bits(void) const { return slot_illegal; }
+
+  std::size_t illegal_count(void) const;
+
+  // inclusive [first, last] runs of illegal halfwords
+  std::vector<std::pair<uint16_t, uint16_t>> illegal_ranges(void) const;
+
+private:
+  isa target;
+  bitset illegal = {};
+  bitset slot_illegal = {};
+};
+
+// shared like decode_table_for()
+const opcode_map& opcode_map_for(isa variant);
+
+// "Slot illegal instruction" is one of the exceptions of 'i'
+bool raises_slot_illegal(const insn& i);
+
+// two patterns of the same width that accept common encodings
+struct pattern_overlap
+{
+  uint16_t first_id;
+  uint16_t second_id;
+  uint64_t encodings; // number of words both accept
+  bool parallel;      // X and Y memory moves, halves of one SH-DSP double transfer
+  bool ambiguous;     // equally specific (and not parallel), the database order decides
+};
+
+std::vector<pattern_overlap> pattern_overlaps(isa variant);
+
+#endif // OPCODE_MAP_H
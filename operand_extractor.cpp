@@ -0,0 +1,125 @@
+#include "operand_extractor.h"
+
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define HAVE_X86_INTRINSICS
+#endif
+
+using namespace std::literals::string_literals;
+
+namespace
+{
+  // 'i' is zero extended unless the instruction sign extends its immediate,
+  // 'd' is zero extended unless it is a PC relative branch label.
+  bool is_signed_field(const instruction_entry& entry, char letter)
+  {
+    const std::string& fmt = entry.source->data<format>();
+    const std::string& abs = entry.source->data<abstract>();
+    switch(letter)
+    {
+      case 's':
+        return true;
+      case 'i':
+        return abs.find("sign extension") != std::string::npos ||
+               abs.find("imm < 0") != std::string::npos;
+      case 'd':
+        return fmt.find("label") != std::string::npos;
+    }
+    return false;
+  }
+}
+
+operand_extractor build_operand_extractor(const instruction_entry& entry)
+{
+  operand_extractor rval;
+
+  if(entry.pattern.fields.size() > max_operand_fields)
+    throw("Too many operand fields: "s + entry.source->data<opcode>());
+
+  for(const operand_field& f : entry.pattern.fields)
+  {
+    const std::size_t pos = rval.count++;
+    rval.field_mask[pos] = f.mask;
+    rval.letter[pos] = f.letter;
+    rval.sign_bit[pos] = is_signed_field(entry, f.letter) ? uint32_t(1) << (f.width - 1) : 0;
+
+    // split the field into runs of contiguous bits, lowest first
+    uint32_t runs[2] = { 0, 0 };
+    int run_count = 0;
+    for(uint32_t bits = f.mask; bits; )
+    {
+      if(run_count == 2)
+        throw("Operand '"s + f.letter + "' is split over more than two runs of bits: " + entry.source->data<opcode>());
+      uint32_t lowest = bits & (~bits + 1);
+      uint32_t run = bits & ~(bits + lowest); // contiguous run starting at the lowest set bit
+      runs[run_count++] = run;
+      bits &= ~run;
+    }
+
+    rval.low_mask[pos] = runs[0];
+    rval.low_shift[pos] = uint8_t(countr_zero(runs[0]));
+    if(runs[1])
+    {
+      int low_width = 0;
+      for(uint32_t bits = runs[0]; bits; bits &= bits - 1)
+        ++low_width;
+      rval.high_mask[pos] = runs[1];
+      rval.high_shift[pos] = uint8_t(countr_zero(runs[1]) - low_width);
+    }
+  }
+  return rval;
+}
+
+const std::vector<operand_extractor>& operand_extractors(void)
+{
+  static const std::vector<operand_extractor> extractors = []
+  {
+    std::vector<operand_extractor> rval;
+    for(const instruction_entry& entry : instruction_entries())
+      rval.push_back(build_operand_extractor(entry));
+    return rval;
+  }();
+  return extractors;
+}
+
+void extract_operands_shift(const operand_extractor& extractor, uint32_t word, operand_values& out)
+{
+  for(std::size_t pos = 0; pos < max_operand_fields; ++pos)
+  {
+    uint32_t raw = ((word & extractor.high_mask[pos]) >> extractor.high_shift[pos]) |
+                   ((word & extractor.low_mask[pos]) >> extractor.low_shift[pos]);
+    out.value[pos] = int32_t((raw ^ extractor.sign_bit[pos]) - extractor.sign_bit[pos]);
+  }
+}
+
+#if defined(HAVE_X86_INTRINSICS)
+__attribute__((target("bmi2")))
+void extract_operands_pext(const operand_extractor& extractor, uint32_t word, operand_values& out)
+{
+  for(std::size_t pos = 0; pos < max_operand_fields; ++pos)
+  {
+    uint32_t raw = _pext_u32(word, extractor.field_mask[pos]);
+    out.value[pos] = int32_t((raw ^ extractor.sign_bit[pos]) - extractor.sign_bit[pos]);
+  }
+}
+
+extract_function select_operand_extractor(void)
+{
+  static const extract_function selected =
+      __builtin_cpu_supports("bmi2") ? extract_operands_pext : extract_operands_shift;
+  return selected;
+}
+#else
+void extract_operands_pext(const operand_extractor& extractor, uint32_t word, operand_values& out)
+{
+  extract_operands_shift(extractor, word, out);
+}
+
+extract_function select_operand_extractor(void)
+{
+  return extract_operands_shift;
+}
+#endif
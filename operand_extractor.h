@@ -0,0 +1,46 @@
+#ifndef OPERAND_EXTRACTOR_H
+#define OPERAND_EXTRACTOR_H
+
+#include "decoder.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// the parallel DSP multiply forms have the most fields (e, f, x, y, g, u)
+constexpr std::size_t max_operand_fields = 6;
+
+// every field is pulled out with one PEXT, or with two shift/mask segments
+// (no operand of the database is split over more than two runs of bits).
+// unused fields have empty masks and extract as zero.
+struct operand_extractor
+{
+  std::array<uint32_t, max_operand_fields> field_mask = {}; // PEXT masks
+  std::array<uint32_t, max_operand_fields> high_mask = {};  // upper run of the field
+  std::array<uint32_t, max_operand_fields> low_mask = {};   // lower run of the field
+  std::array<uint8_t, max_operand_fields> high_shift = {};
+  std::array<uint8_t, max_operand_fields> low_shift = {};
+  std::array<uint32_t, max_operand_fields> sign_bit = {};   // zero for zero-extended fields
+  std::array<char, max_operand_fields> letter = {};         // same order as opcode_pattern::fields
+  uint8_t count = 0;
+};
+
+struct operand_values
+{
+  std::array<int32_t, max_operand_fields> value;
+};
+
+operand_extractor build_operand_extractor(const instruction_entry& entry);
+
+// indexed by instruction id
+const std::vector<operand_extractor>& operand_extractors(void);
+
+typedef void (*extract_function)(const operand_extractor& extractor, uint32_t word, operand_values& out);
+
+void extract_operands_shift(const operand_extractor& extractor, uint32_t word, operand_values& out);
+void extract_operands_pext(const operand_extractor& extractor, uint32_t word, operand_values& out);
+
+// PEXT when the CPU has BMI2, shift/mask otherwise
+extract_function select_operand_extractor(void);
+
+#endif // OPERAND_EXTRACTOR_H
@@ -1,5 +1,6 @@
 #include "post_processing.h"
 
+#include "asm_lexer.h"
 #include "build_instructions.h"
 
 #include <algorithm>
@@ -304,37 +305,22 @@ void format_assembly(std::string& data)
 
     typedef std::array<std::string, 7> asm_parts_t;
 
-    asm_parts_t regexes =
-    {
-      "^[[:space:]]*([[:xdigit:]]{4,8})[[:space:]]*" ,
-      "^[[:space:]]*([[:alpha:]_][[:alnum:]_]*:)",
-      "^[[:space:]]*([[:alpha:]][[:alnum:]/\\.]+)",
-      "^[[:space:]]*(\\.[[:alpha:]][[:alnum:]\\.]+)",
-      "^[[:space:]]*([-+,#_@”“\\(\\)[:alnum:]]+)",
-      "^[[:space:]]*;(.*)$",
-      "^[[:space:]\\.]*$",
-    };
-
-    std::smatch matches;
     std::list<asm_parts_t> lines;
 
     auto pos = std::cbegin(data);
     while (pos != std::cend(data))
     {
       asm_parts_t line;
-      auto line_pos = pos;
       auto eol = std::find(pos, std::cend(data), '\n');
-      if(line_pos != eol)
+      if(pos != eol)
       {
-        for(uint8_t part = address; part <= spacing; ++part)
-        {
-          std::regex_search(line_pos, eol, matches, std::regex(regexes[part], std::regex_constants::extended), std::regex_constants::format_sed);
-          if(!matches.empty())
-          {
-            line[part] = matches[1];
-            line_pos = std::next(line_pos, matches[0].str().size());
-          }
-        }
+        const asm_line parts = split_assembly_line(std::string_view(&*pos, std::size_t(eol - pos)), true);
+        line[address] = parts.address;
+        line[label] = parts.label;
+        line[mnemonic] = parts.mnemonic;
+        line[directive] = parts.directive;
+        line[operand] = parts.operand;
+        line[comment] = parts.comment;
       }
       if(!line[comment].empty())
         line[comment].insert(0, "! ");
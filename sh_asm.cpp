@@ -0,0 +1,120 @@
+/*
+sh_asm - SuperH assembler built on the instruction database
+
+Usage: sh_asm [--cpu NAME] [--base ADDRESS] [--little-endian] [--buffer KB] [-o OUTPUT] SOURCE
+
+Assembles a source file into a raw image.  One instruction per line, in the
+syntax of the database formats (and of sh_disasm), with
+
+  name:               labels, also for @(disp,PC) ("mov.l lit,r1")
+  .byte/.word/.long   data (.long also takes labels)
+  .align N            pads with zeros to a multiple of N bytes
+  ; or !              comments
+
+The source is streamed through a fixed buffer (--buffer, 1 MiB by default)
+and the image written as it is assembled, so files of any size assemble in
+bounded memory.  Labels may be used before they are defined; those operands
+are patched into the output once the whole file has been read, which needs a
+seekable output when they are further back than the output buffer.
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stream_assembler.h"
+
+using namespace std::literals::string_literals;
+
+// ----------------------------------------------------------------------------
+
+struct asm_options
+{
+  isa cpu = SH2;
+  stream_options stream;
+  std::string input;
+  std::string output;
+};
+
+// closes the descriptor on the way out
+struct file_descriptor
+{
+  int fd;
+  ~file_descriptor(void) { if(fd > STDERR_FILENO) ::close(fd); }
+};
+
+int assemble_file(const asm_options& options)
+{
+  const file_descriptor input { ::open(options.input.c_str(), O_RDONLY) };
+  if(input.fd < 0)
+    throw("unable to open: "s + options.input);
+
+  const file_descriptor output { options.output.empty() ? STDOUT_FILENO
+                                 : ::open(options.output.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) };
+  if(output.fd < 0)
+    throw("unable to create: "s + options.output);
+
+  const assembler as(options.cpu);
+  const stream_stats stats = assemble_stream(as, input.fd, output.fd, options.stream, options.input, std::cerr);
+  if(!stats.errors)
+    return 0;
+
+  if(!options.output.empty())
+    ::unlink(options.output.c_str());
+  return 1;
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argc, char* argv[])
+{
+  try
+  {
+    const std::string usage = "usage: sh_asm [--cpu NAME] [--base ADDRESS] [--little-endian] [--buffer KB] [-o OUTPUT] SOURCE";
+    asm_options options;
+    for(int arg = 1; arg < argc; ++arg)
+    {
+      std::string opt = argv[arg];
+      if(opt == "--little-endian")
+        options.stream.little_endian = true;
+      else if(opt.empty() || opt[0] != '-')
+      {
+        if(!options.input.empty())
+          throw(usage);
+        options.input = opt;
+      }
+      else if(arg + 1 >= argc)
+        throw("missing value for: "s + opt);
+      else if(opt == "--cpu")
+      {
+        options.cpu = parse_cpu_name(argv[++arg]);
+        if(options.cpu == SH_NONE)
+          throw("unknown cpu: "s + argv[arg]);
+      }
+      else if(opt == "--base")
+        options.stream.base = uint32_t(std::stoul(argv[++arg], nullptr, 0));
+      else if(opt == "--buffer")
+        options.stream.buffer_size = std::max<std::size_t>(1, std::stoul(argv[++arg])) << 10;
+      else if(opt == "-o")
+        options.output = argv[++arg];
+      else
+        throw("unknown option: "s + opt);
+    }
+
+    if(options.input.empty())
+      throw(usage);
+    return assemble_file(options);
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 1;
+}
@@ -0,0 +1,794 @@
+/*
+sh_bench - decoder benchmarks built on the SuperH instruction database
+
+Usage: sh_bench batch [--cpu NAME] [--size MB] [--file IMAGE] [--little-endian]
+       sh_bench strategies [--cpu NAME] [--size MB] [--file IMAGE] [--little-endian]
+       sh_bench assemble [--cpu NAME] [--size MB] [--file IMAGE] [--little-endian]
+       sh_bench fpu [--size MB]
+       sh_bench compare [--size MB]
+
+strategies compares decoders of instruction ids: a linear scan of all opcode
+patterns, the flat table, the page compressed table and the decision tree.
+Without --cpu every variant is measured.  Branch mispredictions are read with
+perf_event_open when the kernel allows it.
+assemble disassembles the input to source text and measures sh_asm's
+streaming assembler on it.
+fpu runs the SSE kernels of the SH4 vector instructions (fipr, ftrv, fsca,
+fsrra) and their double precision reference on random register banks (one
+per 128 bytes of --size, with zeros, infinities, NaNs and denormals), and
+fails when a result is further from the reference than 2^-21 of the sum of
+the magnitudes of the products (fipr, ftrv), 2^-21 (fsca) or 2^-21 of the
+result (fsrra).
+compare runs a loop of cmp/eq, cmp/hi, cmp/ge, tst, movt, shifts and dt/bf (one
+iteration per 16 bytes of --size) on the SH2 interpreter in every dispatch mode,
+and fails when the registers differ between the modes.
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "batch_decoder.h"
+#include "decode_table.h"
+#include "decode_tree.h"
+#include "disassembler.h"
+#include "fpu_kernels.h"
+#include "interpreter.h"
+#include "stream_assembler.h"
+
+using namespace std::literals::string_literals;
+
+// ----------------------------------------------------------------------------
+
+struct bench_options
+{
+  isa cpu = SH2;
+  bool all_cpus = true; // no --cpu given
+  std::size_t size = 8 << 20; // bytes
+  std::string file;
+  bool little_endian = false;
+};
+
+// random encodings of the instructions available on 'cpu'
+std::vector<uint16_t> synthetic_stream(isa cpu, std::size_t halfwords, uint32_t seed)
+{
+  std::vector<const instruction_entry*> available;
+  for(const instruction_entry& entry : instruction_entries())
+    if(entry.source->for_isa(cpu_instruction_sets(cpu)))
+      available.push_back(&entry);
+
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<std::size_t> pick(0, available.size() - 1);
+
+  std::vector<uint16_t> rval;
+  rval.reserve(halfwords + 1);
+  while(rval.size() < halfwords)
+  {
+    const opcode_pattern& p = available[pick(random)]->pattern;
+    uint32_t word = p.match | (uint32_t(random()) & ~p.mask);
+    if(p.width == 32)
+      rval.push_back(uint16_t(word >> 16));
+    rval.push_back(uint16_t(word));
+  }
+  rval.resize(halfwords);
+  return rval;
+}
+
+std::vector<uint16_t> load_image(const std::string& path, bool little_endian)
+{
+  std::ifstream file(path, std::ios::binary);
+  if(!file)
+    throw("unable to open: "s + path);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<uint16_t> rval(bytes.size() / 2);
+  for(std::size_t pos = 0; pos < rval.size(); ++pos)
+    rval[pos] = little_endian ? uint16_t(bytes[pos * 2] | (bytes[pos * 2 + 1] << 8))
+                              : uint16_t((bytes[pos * 2] << 8) | bytes[pos * 2 + 1]);
+  return rval;
+}
+
+std::vector<uint16_t> bench_input(const bench_options& options, isa cpu)
+{
+  if(!options.file.empty())
+    return load_image(options.file, options.little_endian);
+  return synthetic_stream(cpu, options.size / 2, 1);
+}
+
+// best of several runs, in seconds
+template<typename Func>
+double best_time(int runs, Func func)
+{
+  double best = 0.0;
+  for(int run = 0; run < runs; ++run)
+  {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(!run || elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
+
+bool same_output(const decoded_stream& a, const decoded_stream& b)
+{
+  if(a.count != b.count)
+    return false;
+  if(!std::equal(a.id.begin(), a.id.begin() + a.count, b.id.begin()) ||
+     !std::equal(a.offset.begin(), a.offset.begin() + a.count, b.offset.begin()))
+    return false;
+  for(std::size_t f = 0; f < max_operand_fields; ++f)
+    if(!std::equal(a.field[f].begin(), a.field[f].begin() + a.count, b.field[f].begin()))
+      return false;
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+
+int bench_batch(const bench_options& options)
+{
+  const decode_table& table = decode_table_for(options.cpu);
+  const std::vector<uint16_t> words = bench_input(options, options.cpu);
+
+  decoded_stream scalar_out;
+  decoded_stream simd_out;
+
+  double scalar = best_time(5, [&] { decode_stream_scalar(table, words.data(), words.size(), scalar_out); });
+  double simd = best_time(5, [&] { decode_stream_avx2(table, words.data(), words.size(), simd_out); });
+
+  std::cout << "cpu:          " << cpu_name(options.cpu) << std::endl
+            << "input:        " << words.size() * 2 << " bytes, " << scalar_out.count << " instructions" << std::endl
+            << "table:        " << table.memory_footprint() << " bytes" << std::endl
+            << std::fixed << std::setprecision(1)
+            << "scalar:       " << words.size() / scalar / 1e6 << " Mwords/s" << std::endl
+            << "avx2 batch:   " << words.size() / simd / 1e6 << " Mwords/s"
+            << (select_stream_decoder() == decode_stream_scalar ? " (no AVX2, scalar fallback)" : "") << std::endl;
+
+  if(!same_output(scalar_out, simd_out))
+  {
+    std::cerr << "error: batch output differs from the scalar decoder" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// every pattern of the variant tested in order of precedence
+class linear_decoder
+{
+public:
+  explicit linear_decoder(isa variant)
+  {
+    const isa instruction_sets = cpu_instruction_sets(variant);
+    for(const instruction_entry& entry : instruction_entries())
+      if(entry.source->for_isa(instruction_sets))
+        entries.push_back(&entry);
+
+    // as decode_table: 32-bit forms first, then the most specific pattern
+    std::stable_sort(entries.begin(), entries.end(),
+      [](const instruction_entry* a, const instruction_entry* b)
+      {
+        if(a->pattern.width != b->pattern.width)
+          return a->pattern.width > b->pattern.width;
+        return specificity(a->pattern) > specificity(b->pattern);
+      });
+  }
+
+  uint16_t decode(uint16_t first, uint16_t second) const
+  {
+    const uint32_t extended = (uint32_t(first) << 16) | second;
+    for(const instruction_entry* entry : entries)
+      if(entry->pattern.matches(entry->pattern.width == 32 ? extended : first))
+        return entry->id;
+    return invalid_instruction;
+  }
+
+  std::size_t memory_footprint(void) const
+  {
+    return entries.size() * (sizeof(instruction_entry*) + sizeof(uint32_t) * 2 + 1);
+  }
+
+private:
+  std::vector<const instruction_entry*> entries;
+};
+
+// hardware branch miss counter of this thread, if the kernel allows it
+class branch_miss_counter
+{
+public:
+  branch_miss_counter(void)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~branch_miss_counter(void)
+  {
+    if(fd >= 0)
+      close(fd);
+  }
+
+  bool available(void) const { return fd >= 0; }
+
+  void start(void)
+  {
+    if(fd < 0)
+      return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  uint64_t stop(void)
+  {
+    uint64_t count = 0;
+    if(fd < 0)
+      return 0;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(fd, &count, sizeof(count)) != sizeof(count))
+      return 0;
+    return count;
+  }
+
+private:
+  int fd = -1;
+};
+
+// instruction ids of the stream, sizes as given by 'table'
+template<typename Decoder>
+void decode_ids(const Decoder& decoder, const decode_table& table,
+                const std::vector<uint16_t>& words, std::vector<uint16_t>& ids)
+{
+  const std::size_t count = words.size();
+  ids.clear();
+  for(std::size_t pos = 0; pos < count; )
+  {
+    uint16_t id = decoder.decode(words[pos], pos + 1 < count ? words[pos + 1] : 0);
+    std::size_t halfwords = table.size(id) / 2;
+    if(pos + halfwords > count) // truncated 32-bit instruction
+    {
+      id = invalid_instruction;
+      halfwords = 1;
+    }
+    ids.push_back(id);
+    pos += halfwords;
+  }
+}
+
+struct strategy_result
+{
+  const char* name;
+  double seconds;
+  uint64_t branch_misses;
+  std::size_t footprint;
+  bool matches;
+};
+
+template<typename Decoder>
+strategy_result measure_strategy(const char* name, const Decoder& decoder, std::size_t footprint,
+                                 const decode_table& table, const std::vector<uint16_t>& words,
+                                 const std::vector<uint16_t>& reference, std::vector<uint16_t>& ids)
+{
+  branch_miss_counter misses;
+  strategy_result rval = { name, 0.0, 0, footprint, false };
+  rval.seconds = best_time(3, [&]
+  {
+    misses.start();
+    decode_ids(decoder, table, words, ids);
+    uint64_t count = misses.stop();
+    if(!rval.branch_misses || count < rval.branch_misses)
+      rval.branch_misses = count;
+  });
+  rval.matches = ids == reference;
+  return rval;
+}
+
+int bench_strategies(const bench_options& options)
+{
+  const bool counters = branch_miss_counter().available();
+  int rval = 0;
+
+  std::cout << std::left << std::setw(10) << "cpu" << std::setw(12) << "strategy"
+            << std::right << std::setw(12) << "ns/insn" << std::setw(14) << "br-miss/insn"
+            << std::setw(12) << "bytes" << std::endl;
+
+  for(isa cpu : cpu_variants)
+  {
+    if(!options.all_cpus && cpu != options.cpu)
+      continue;
+
+    const std::vector<uint16_t> words = bench_input(options, cpu);
+    const decode_table& table = decode_table_for(cpu);
+    const compressed_decode_table compressed(table);
+    const decode_tree tree(cpu);
+    const linear_decoder linear(cpu);
+
+    std::vector<uint16_t> reference;
+    std::vector<uint16_t> ids;
+    decode_ids(table, table, words, reference);
+
+    const strategy_result results[] =
+    {
+      measure_strategy("linear", linear, linear.memory_footprint(), table, words, reference, ids),
+      measure_strategy("table", table, table.memory_footprint(), table, words, reference, ids),
+      measure_strategy("compressed", compressed, compressed.memory_footprint(), table, words, reference, ids),
+      measure_strategy("tree", tree, tree.memory_footprint(), table, words, reference, ids),
+    };
+
+    for(const strategy_result& r : results)
+    {
+      std::cout << std::left << std::setw(10) << cpu_name(cpu) << std::setw(12) << r.name << std::right
+                << std::fixed << std::setprecision(2) << std::setw(12) << r.seconds * 1e9 / reference.size();
+      if(counters)
+        std::cout << std::setw(14) << double(r.branch_misses) / reference.size();
+      else
+        std::cout << std::setw(14) << "n/a";
+      std::cout << std::setw(12) << r.footprint << std::endl;
+
+      if(!r.matches)
+      {
+        std::cerr << "error: " << r.name << " decoder differs from the table on " << cpu_name(cpu) << std::endl;
+        rval = 1;
+      }
+    }
+  }
+
+  if(!counters)
+    std::cout << "(branch misses unavailable: perf_event_open is not permitted)" << std::endl;
+  return rval;
+}
+
+// ----------------------------------------------------------------------------
+
+// sh_disasm style source of the halfwords, without the address columns.
+// 32-bit forms the assembler would replace by a 16-bit one are written as
+// data, so that the image assembles back to the same addresses.
+std::string disassembly_source(const assembler& as, const std::vector<uint16_t>& words, std::size_t& lines)
+{
+  const decode_table& table = decode_table_for(as.variant());
+  const disassembler dis(as.variant());
+  const extract_function extract = select_operand_extractor();
+  const symbol_table no_symbols;
+
+  std::string rval;
+  lines = 0;
+  for(std::size_t pos = 0; pos < words.size(); ++lines)
+  {
+    const std::size_t line_start = rval.size();
+    const uint16_t first = words[pos];
+    const uint16_t second = pos + 1 < words.size() ? words[pos + 1] : 0;
+    uint16_t id = table.decode(first, second);
+    if(id != invalid_instruction && pos + table.size(id) / 2 > words.size())
+      id = invalid_instruction;
+
+    bool valid = id != invalid_instruction;
+    if(valid && dis.is_dsp(first))
+      valid = dis.format_dsp(rval, first, second);
+    else if(valid)
+    {
+      operand_values values;
+      const uint32_t word = table.size(id) == 4 ? (uint32_t(first) << 16) | second : first;
+      extract(operand_extractors()[id], word, values);
+      dis.format(rval, id, values, uint32_t(pos * 2));
+
+      if(table.size(id) == 4)
+      {
+        try
+        {
+          valid = as.assemble(std::string_view(rval).substr(line_start), uint32_t(pos * 2), no_symbols).size == 4;
+        }
+        catch(const std::string&)
+        {
+          valid = false;
+        }
+        if(!valid)
+          rval.resize(line_start);
+      }
+    }
+
+    if(!valid)
+    {
+      rval += ".word   0x";
+      append_hex(rval, first, 4);
+      if(id != invalid_instruction && table.size(id) == 4)
+      {
+        rval += ",0x";
+        append_hex(rval, second, 4);
+      }
+    }
+    rval += '\n';
+    pos += id == invalid_instruction ? 1 : table.size(id) / 2;
+  }
+  return rval;
+}
+
+// a temporary file removed on the way out
+struct temporary_file
+{
+  temporary_file(void)
+  {
+    char name[] = "/tmp/sh_bench.XXXXXX";
+    fd = ::mkstemp(name);
+    if(fd < 0)
+      throw("unable to create a temporary file"s);
+    ::unlink(name);
+  }
+
+  ~temporary_file(void) { ::close(fd); }
+
+  int fd;
+};
+
+int bench_assemble(const bench_options& options)
+{
+  const std::vector<uint16_t> words = bench_input(options, options.cpu);
+  const assembler as(options.cpu);
+  std::size_t lines = 0;
+  const std::string source = disassembly_source(as, words, lines);
+
+  const temporary_file input;
+  const temporary_file output;
+  if(::write(input.fd, source.data(), source.size()) != ssize_t(source.size()))
+    throw("unable to write the source"s);
+
+  stream_options stream;
+  stream.little_endian = options.little_endian;
+  stream_stats stats;
+
+  const double seconds = best_time(3, [&]
+  {
+    ::lseek(input.fd, 0, SEEK_SET);
+    ::lseek(output.fd, 0, SEEK_SET);
+    if(::ftruncate(output.fd, 0) < 0)
+      throw("unable to truncate the output"s);
+    stats = assemble_stream(as, input.fd, output.fd, stream, "source", std::cerr);
+  });
+
+  // the image read back: the same halfwords unless shorter forms were picked
+  std::vector<uint8_t> bytes(stats.output_bytes);
+  const bool same = stats.output_bytes == words.size() * 2 &&
+                    ::pread(output.fd, bytes.data(), bytes.size(), 0) == ssize_t(bytes.size()) &&
+                    [&]
+                    {
+                      for(std::size_t pos = 0; pos < words.size(); ++pos)
+                        if(bytes[pos * 2 + (options.little_endian ? 1 : 0)] != uint8_t(words[pos] >> 8) ||
+                           bytes[pos * 2 + (options.little_endian ? 0 : 1)] != uint8_t(words[pos]))
+                          return false;
+                      return true;
+                    }();
+
+  std::cout << "cpu:          " << cpu_name(options.cpu) << std::endl
+            << "source:       " << source.size() << " bytes, " << lines << " lines" << std::endl
+            << "buffers:      " << stream.buffer_size * 2 << " bytes" << std::endl
+            << std::fixed << std::setprecision(1)
+            << "assemble:     " << lines / seconds / 1e6 << " Mlines/s, "
+            << source.size() / seconds / 1e6 << " MB/s" << std::endl
+            << "image:        " << stats.output_bytes << " bytes, "
+            << (same ? "same as the input" : "differs from the input") << std::endl;
+  return stats.errors ? 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// a register file of the FPU, FR0-FR15 then XF0-XF15, as bits
+struct alignas(16) fpu_bank
+{
+  uint32_t r[32];
+};
+
+// mostly positive normal numbers of moderate magnitude, with a few zeros,
+// infinities, NaNs, denormals and huge values
+uint32_t random_fpu_register(std::mt19937& random)
+{
+  const uint32_t bits = uint32_t(random());
+  const uint32_t sign = bits % 4 ? 0 : 0x80000000;
+  switch(bits >> 24)
+  {
+  case 0:
+    return sign;
+  case 1:
+    return sign | 0x7F800000;
+  case 2:
+    return 0x7FC00000 | (bits & 0x003FFFFF);
+  case 3:
+    return sign | (bits & 0x007FFFFF);
+  case 4:
+    return sign | 0x7E800000 | (bits & 0x007FFFFF);
+  default:
+    return sign | (107 + bits % 41) << 23 | (uint32_t(random()) & 0x007FFFFF);
+  }
+}
+
+// denormals as zero, as the kernels read them
+double fpu_value(uint32_t bits)
+{
+  if((bits & 0x7F800000) == 0)
+    bits &= 0x80000000;
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// the allowed difference of an element of a sum of products, 2^-21 of the
+// sum of their magnitudes, and the smallest normal number for the flushed
+// denormals
+double product_tolerance(const uint32_t* a, std::size_t a_stride, const uint32_t* b)
+{
+  double sum = 0.0;
+  for(std::size_t k = 0; k < 4; ++k)
+    sum += std::fabs(fpu_value(a[k * a_stride]) * fpu_value(b[k]));
+  return std::ldexp(sum, -21) + FLT_MIN;
+}
+
+// an instruction applied to the bank of case 'k', and the allowed
+// difference of each register from the reference, -1 when not written
+struct fpu_kernel
+{
+  const char* name;
+  void (*reference)(fpu_bank& bank, std::size_t k);
+  void (*sse)(fpu_bank& bank, std::size_t k);
+  double (*tolerance)(const fpu_bank& input, std::size_t k, unsigned reg);
+};
+
+const fpu_kernel fpu_kernels[] =
+{
+  {
+    "fipr",
+    [] (fpu_bank& b, std::size_t k) { fipr_reference(b.r, (k & 3) * 4, (k >> 2 & 3) * 4); },
+    [] (fpu_bank& b, std::size_t k) { fipr_sse(b.r, (k & 3) * 4, (k >> 2 & 3) * 4); },
+    [] (const fpu_bank& in, std::size_t k, unsigned reg)
+    {
+      const unsigned m = (k & 3) * 4, n = (k >> 2 & 3) * 4;
+      return reg == n + 3 ? product_tolerance(in.r + m, 1, in.r + n) : -1.0;
+    }
+  },
+  {
+    "ftrv",
+    [] (fpu_bank& b, std::size_t k) { ftrv_reference(b.r, b.r + 16, (k & 3) * 4); },
+    [] (fpu_bank& b, std::size_t k) { ftrv_sse(b.r, b.r + 16, (k & 3) * 4); },
+    [] (const fpu_bank& in, std::size_t k, unsigned reg)
+    {
+      const unsigned n = (k & 3) * 4;
+      return reg - n < 4 ? product_tolerance(in.r + 16 + (reg - n), 4, in.r + n) : -1.0;
+    }
+  },
+  {
+    // every angle once per 65536 cases
+    "fsca",
+    [] (fpu_bank& b, std::size_t k) { fsca_reference(b.r, (k >> 16 & 7) * 2, uint32_t(k)); },
+    [] (fpu_bank& b, std::size_t k) { fsca_sse(b.r, (k >> 16 & 7) * 2, uint32_t(k)); },
+    [] (const fpu_bank&, std::size_t k, unsigned reg)
+    {
+      return reg - (k >> 16 & 7) * 2 < 2 ? std::ldexp(1.0, -21) : -1.0;
+    }
+  },
+  {
+    "fsrra",
+    [] (fpu_bank& b, std::size_t k) { fsrra_reference(b.r, k & 15); },
+    [] (fpu_bank& b, std::size_t k) { fsrra_sse(b.r, k & 15); },
+    [] (const fpu_bank& in, std::size_t k, unsigned reg)
+    {
+      return reg == (k & 15) ? std::ldexp(1.0 / std::sqrt(std::fabs(fpu_value(in.r[reg]))), -21) : -1.0;
+    }
+  },
+};
+
+// best of several runs of 'kernel' on fresh copies of every bank, in seconds
+double fpu_kernel_time(const std::vector<fpu_bank>& input, std::vector<fpu_bank>& output,
+                       void (*kernel)(fpu_bank& bank, std::size_t k))
+{
+  double best = 0.0;
+  for(int run = 0; run < 5; ++run)
+  {
+    output = input;
+    const double seconds = best_time(1, [&]
+    {
+      for(std::size_t k = 0; k < output.size(); ++k)
+        kernel(output[k], k);
+    });
+    if(!run || seconds < best)
+      best = seconds;
+  }
+  return best;
+}
+
+int bench_fpu(const bench_options& options)
+{
+  std::vector<fpu_bank> input(std::max<std::size_t>(options.size / sizeof(fpu_bank), 1));
+  std::mt19937 random(1);
+  for(fpu_bank& bank : input)
+    for(uint32_t& reg : bank.r)
+      reg = random_fpu_register(random);
+
+  std::cout << "kernels:      " << (has_sse_fpu_kernels() ? "sse" : "reference only (no SSE)") << std::endl
+            << "cases:        " << input.size() << " per instruction" << std::endl;
+
+  std::vector<fpu_bank> reference_out;
+  std::vector<fpu_bank> sse_out;
+  for(const fpu_kernel& kernel : fpu_kernels)
+  {
+    const double reference = fpu_kernel_time(input, reference_out, kernel.reference);
+    const double sse = fpu_kernel_time(input, sse_out, kernel.sse);
+
+    // the largest difference, as a fraction of the allowed one
+    double worst = 0.0;
+    for(std::size_t k = 0; k < input.size(); ++k)
+      for(unsigned reg = 0; reg < 32; ++reg)
+      {
+        const uint32_t a = reference_out[k].r[reg];
+        const uint32_t b = sse_out[k].r[reg];
+        if(a == b)
+          continue;
+        const double tolerance = kernel.tolerance(input[k], k, reg);
+        const double difference = std::fabs(fpu_value(a) - fpu_value(b));
+        if(tolerance < 0 || !(difference <= tolerance))
+        {
+          std::cerr << "error: " << kernel.name << " differs from the reference in case " << k << ", register "
+                    << reg << ": " << std::hex << std::setfill('0') << std::setw(8) << a << " and "
+                    << std::setw(8) << b << std::endl;
+          return 1;
+        }
+        worst = std::max(worst, difference / tolerance);
+      }
+
+    std::cout << std::left << std::setw(14) << (kernel.name + ":"s) << std::right << std::fixed
+              << std::setprecision(1) << "reference " << input.size() / reference / 1e6 << " Mops/s, sse "
+              << input.size() / sse / 1e6 << " Mops/s, worst " << std::setprecision(2) << worst
+              << " of the tolerance" << std::endl;
+  }
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// compare-heavy integer code: most instructions set T, few read it.  R1
+// counts the iterations.
+const char* const compare_loop[] =
+{
+  "cmp/eq r2,r3",
+  "cmp/hi r3,r2",
+  "tst r4,r4",
+  "add #1,r2",
+  "cmp/ge r2,r3",
+  "cmp/pz r2",
+  "cmp/gt r4,r3",
+  "tst #4,r0",
+  "movt r0",
+  "cmp/str r2,r3",
+  "shll r4",
+  "rotcl r4",
+  "cmp/eq #3,r0",
+  "dt r1",
+  "bf loop",
+  "sleep",
+};
+
+int bench_compare(const bench_options& options)
+{
+  const assembler as(SH2);
+  const symbol_table symbols = { { "loop", 0 } };
+  guest_memory memory(0, 64 << 10);
+  uint32_t address = 0;
+  for(const char* line : compare_loop)
+  {
+    const assembled_instruction insn = as.assemble(line, address, symbols);
+    memory.data()[address] = uint8_t(insn.word >> 8);
+    memory.data()[address + 1] = uint8_t(insn.word);
+    address += insn.size;
+  }
+  const uint32_t iterations = uint32_t(std::max<std::size_t>(options.size / 16, 1));
+  const uint64_t instructions = uint64_t(iterations) * (std::size(compare_loop) - 1) + 1;
+
+  std::cout << "loop:         " << std::size(compare_loop) - 1 << " instructions, " << iterations << " iterations"
+            << std::endl;
+  if(!interpreter::has_threaded_dispatch())
+    std::cout << "dispatch:     switch only (no computed goto)" << std::endl;
+
+  const std::pair<interpreter::dispatch_mode, const char*> modes[] =
+  {
+    { interpreter::threaded, "threaded:" },
+    { interpreter::switched, "switch:" },
+    { interpreter::blocks, "blocks:" },
+    { interpreter::jit, "jit:" },
+  };
+  interpreter cpu(SH2, memory);
+  cpu_state& s = cpu.state();
+  cpu_state first;
+  for(const auto& [mode, name] : modes)
+  {
+    const double seconds = best_time(3, [&]
+    {
+      s = cpu_state();
+      s.SR = 0x000000F0;
+      s.R[1] = iterations;
+      s.R[2] = 5;
+      s.R[3] = 9;
+      s.R[4] = uint32_t(-3);
+      if(cpu.run(~uint64_t(0), mode) != instructions)
+        throw("the compare loop did not run to its sleep"s);
+    });
+    if(mode == modes[0].first)
+      first = s;
+    else if(s.R != first.R || s.SR != first.SR)
+    {
+      std::cerr << "error: the registers differ in " << name << " dispatch" << std::endl;
+      return 1;
+    }
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(1)
+              << instructions / seconds / 1e6 << " MIPS" << std::endl;
+  }
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argc, char* argv[])
+{
+  try
+  {
+    if(argc < 2)
+      throw("usage: sh_bench batch|strategies|assemble|fpu|compare [--cpu NAME] [--size MB] [--file IMAGE] [--little-endian]"s);
+
+    std::string mode = argv[1];
+    bench_options options;
+    for(int arg = 2; arg < argc; ++arg)
+    {
+      std::string opt = argv[arg];
+      if(opt == "--little-endian")
+        options.little_endian = true;
+      else if(arg + 1 >= argc)
+        throw("missing value for: "s + opt);
+      else if(opt == "--cpu")
+      {
+        options.cpu = parse_cpu_name(argv[++arg]);
+        if(options.cpu == SH_NONE)
+          throw("unknown cpu: "s + argv[arg]);
+        options.all_cpus = false;
+      }
+      else if(opt == "--size")
+        options.size = std::size_t(std::stoul(argv[++arg])) << 20;
+      else if(opt == "--file")
+        options.file = argv[++arg];
+      else
+        throw("unknown option: "s + opt);
+    }
+
+    if(mode == "batch")
+      return bench_batch(options);
+    if(mode == "strategies")
+      return bench_strategies(options);
+    if(mode == "assemble")
+      return bench_assemble(options);
+    if(mode == "fpu")
+      return bench_fpu(options);
+    if(mode == "compare")
+      return bench_compare(options);
+    throw("unknown mode: "s + mode);
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+  }
+  return 1;
+}
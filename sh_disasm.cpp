@@ -0,0 +1,440 @@
+/*
+sh_disasm - streaming SuperH disassembler built on the instruction database
+
+Usage: sh_disasm [--cpu NAME] [--base ADDRESS] [--little-endian] [--threads N] [--chunk KB] [-o OUTPUT] IMAGE
+
+The image is memory mapped and split in chunks that are decoded and formatted
+by a pool of threads.  The text of the chunks is written in order through one
+buffered writer.
+
+A chunk boundary may fall inside a 32-bit instruction (SH2A, SH-DSP), so every
+chunk after the first is also decoded from its second halfword.  The writer
+follows the alignment left by the previous chunk, which gives exactly the
+output of a sequential decode.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "batch_decoder.h"
+#include "decode_table.h"
+#include "disassembler.h"
+#include "mapped_file.h"
+
+using namespace std::literals::string_literals;
+
+// ----------------------------------------------------------------------------
+
+struct disasm_options
+{
+  isa cpu = SH2;
+  uint32_t base = 0;
+  bool little_endian = false;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t chunk = 256 << 10; // bytes
+  std::string input;
+  std::string output;
+};
+
+// collects output in a large buffer and hands it to write(2)
+class output_writer
+{
+public:
+  explicit output_writer(const std::string& path)
+  {
+    if(!path.empty())
+    {
+      fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if(fd < 0)
+        throw("unable to create: "s + path);
+    }
+    buffer.reserve(buffer_size);
+  }
+
+  ~output_writer(void)
+  {
+    if(fd != STDOUT_FILENO)
+      ::close(fd);
+  }
+
+  void write(std::string_view text)
+  {
+    if(buffer.size() + text.size() > buffer_size)
+      flush();
+    if(text.size() >= buffer_size)
+      write_all(text.data(), text.size());
+    else
+      buffer.append(text.data(), text.size());
+  }
+
+  void flush(void)
+  {
+    write_all(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+
+private:
+  static constexpr std::size_t buffer_size = 1 << 20;
+
+  void write_all(const char* data, std::size_t size)
+  {
+    while(size)
+    {
+      ssize_t written = ::write(fd, data, size);
+      if(written < 0)
+      {
+        if(errno == EINTR)
+          continue;
+        throw("write failed: "s + std::strerror(errno));
+      }
+      data += written;
+      size -= std::size_t(written);
+    }
+  }
+
+  int fd = STDOUT_FILENO;
+  std::string buffer;
+};
+
+// ----------------------------------------------------------------------------
+
+// per thread scratch space
+struct chunk_context
+{
+  std::vector<uint16_t> words;
+  decoded_stream stream;
+  std::vector<std::size_t> line_of; // text offset of the instruction at each halfword
+};
+
+// a chunk disassembled from both alignments its first instruction can have.
+// the writer knows how many bytes of the chunk the last instruction of the
+// previous chunk took (0 or 2) and picks the matching text.
+struct chunk_result
+{
+  static constexpr std::size_t never = std::size_t(-1);
+
+  std::string text;           // decoded from the first halfword
+  std::size_t exit = 0;       // bytes of the next chunk taken by the last instruction
+  std::string shifted;        // decoded from the second halfword ...
+  std::size_t rejoin = never; // ... until it meets an instruction of 'text' at this offset
+  std::size_t shifted_exit = 0;
+};
+
+void append_line(std::string& text, const disassembler& dis, uint16_t id, const operand_values& values,
+                 uint32_t pc, uint16_t first, uint16_t second, bool extended)
+{
+  // the line is put together in a local buffer and appended once
+  char line[32 + disassembler::max_text];
+  char* out = write_hex(line, pc, 8);
+  out = std::copy_n(":  ", 3, out);
+  out = write_hex(out, first, 4);
+  if(extended)
+  {
+    *out++ = ' ';
+    out = write_hex(out, second, 4);
+    out = std::copy_n("   ", 3, out);
+  }
+  else
+    out = std::copy_n("        ", 8, out);
+
+  char* end = nullptr;
+  if(id != invalid_instruction && dis.is_dsp(first))
+    end = dis.format_dsp(out, first, second);
+  else if(id != invalid_instruction)
+    end = dis.format(out, id, values, pc);
+
+  if(!end)
+  {
+    end = std::copy_n(".word   0x", 10, out);
+    end = write_hex(end, first, 4);
+    if(extended)
+    {
+      end = std::copy_n(",0x", 3, end);
+      end = write_hex(end, second, 4);
+    }
+  }
+  *end++ = '\n';
+  text.append(line, std::size_t(end - line));
+}
+
+// decodes and formats the 'size' bytes at 'bytes', which are at 'address'.
+// 'available' (at most size + 2) lets the last instruction run into the next chunk.
+// with 'speculate' the chunk is also decoded from its second halfword.
+void disassemble_chunk(const disassembler& dis, const decode_table& table, stream_decode_function decode,
+                       const uint8_t* bytes, std::size_t size, std::size_t available, uint32_t address,
+                       bool little_endian, bool speculate, chunk_context& context, chunk_result& result)
+{
+  const std::size_t halfwords = size / 2;
+  const std::size_t count = available / 2;
+  std::vector<uint16_t>& words = context.words;
+  words.resize(count);
+  for(std::size_t pos = 0; pos < count; ++pos)
+    words[pos] = little_endian ? uint16_t(bytes[pos * 2] | (bytes[pos * 2 + 1] << 8))
+                               : uint16_t((bytes[pos * 2] << 8) | bytes[pos * 2 + 1]);
+
+  decoded_stream& stream = context.stream;
+  decode(table, words.data(), count, stream);
+
+  // instructions that start in the next chunk belong to it
+  std::size_t kept = stream.count;
+  while(kept && stream.offset[kept - 1] >= size)
+    --kept;
+
+  result.exit = 0;
+  if(kept)
+  {
+    const std::size_t end = stream.offset[kept - 1] + table.size(stream.id[kept - 1]);
+    result.exit = end > size ? end - size : 0;
+  }
+
+  std::vector<std::size_t>& line_of = context.line_of;
+  line_of.assign(halfwords, chunk_result::never);
+
+  std::string& text = result.text;
+  text.clear();
+  text.reserve(kept * 40);
+  for(std::size_t n = 0; n < kept; ++n)
+  {
+    const std::size_t pos = stream.offset[n] / 2;
+    const uint16_t id = stream.id[n];
+    operand_values values;
+    for(std::size_t f = 0; f < max_operand_fields; ++f)
+      values.value[f] = stream.field[f][n];
+
+    line_of[pos] = text.size();
+    append_line(text, dis, id, values, address + stream.offset[n], words[pos],
+                pos + 1 < count ? words[pos + 1] : 0, table.size(id) == 4);
+  }
+
+  // the other alignment usually meets the first one after a few instructions,
+  // from there on both decode the same
+  result.shifted.clear();
+  result.rejoin = chunk_result::never;
+  result.shifted_exit = 0;
+  if(!speculate)
+    return;
+
+  const std::vector<operand_extractor>& extractors = operand_extractors();
+  const extract_function extract = select_operand_extractor();
+  std::size_t pos = 1;
+  while(pos < halfwords)
+  {
+    if(line_of[pos] != chunk_result::never)
+    {
+      result.rejoin = line_of[pos];
+      return;
+    }
+
+    const uint16_t first = words[pos];
+    const uint16_t second = pos + 1 < count ? words[pos + 1] : 0;
+    uint16_t id = table.decode(first, second);
+    std::size_t length = table.size(id) / 2;
+    if(pos + length > count) // truncated 32-bit instruction
+    {
+      id = invalid_instruction;
+      length = 1;
+    }
+
+    operand_values values = {};
+    if(id != invalid_instruction)
+      extract(extractors[id], length == 2 ? (uint32_t(first) << 16) | second : first, values);
+    append_line(result.shifted, dis, id, values, address + uint32_t(pos * 2), first, second, length == 2);
+    pos += length;
+  }
+  result.shifted_exit = pos * 2 > size ? pos * 2 - size : 0;
+}
+
+// ----------------------------------------------------------------------------
+
+int disassemble(const disasm_options& options)
+{
+  const mapped_file image(options.input);
+  const disassembler dis(options.cpu);
+  const decode_table& table = decode_table_for(options.cpu);
+  const stream_decode_function decode = select_stream_decoder();
+  output_writer writer(options.output);
+
+  // only variants with 32-bit instructions can have chunk boundaries inside one
+  const bool mixed_length = table.bucket_count() != 0;
+
+  const std::size_t chunk_size = std::max<std::size_t>(options.chunk & ~std::size_t(1), 2);
+  const std::size_t chunks = (image.size() + chunk_size - 1) / chunk_size;
+  const std::size_t window = std::size_t(options.threads) * 2; // chunks in flight
+
+  // chunk 'n' goes to slot n % window, the writer releases slots in order
+  std::mutex lock;
+  std::condition_variable changed;
+  std::vector<chunk_result> slots(window);
+  std::vector<bool> ready(window, false);
+  std::size_t next_chunk = 0;
+  std::size_t written = 0;
+  bool failed = false;
+
+  auto worker = [&]
+  {
+    chunk_context context;
+    chunk_result result;
+    for(;;)
+    {
+      std::size_t n;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        if(next_chunk >= chunks || failed)
+          return;
+        n = next_chunk++;
+        changed.wait(guard, [&] { return n < written + window || failed; });
+        if(failed)
+          return;
+      }
+
+      const std::size_t start = n * chunk_size;
+      const std::size_t size = std::min(chunk_size, image.size() - start);
+      const std::size_t available = std::min(size + 2, image.size() - start);
+      disassemble_chunk(dis, table, decode, image.data() + start, size, available,
+                        options.base + uint32_t(start), options.little_endian,
+                        mixed_length && n, context, result);
+
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        std::swap(slots[n % window], result);
+        ready[n % window] = true;
+      }
+      changed.notify_all();
+    }
+  };
+
+  // the database and tables are built before the threads start
+  operand_extractors();
+
+  std::vector<std::thread> pool;
+  for(unsigned t = 0; t < options.threads; ++t)
+    pool.emplace_back(worker);
+
+  try
+  {
+    std::size_t skip = 0; // bytes of the current chunk taken by the previous one
+    for(std::size_t n = 0; n < chunks; ++n)
+    {
+      chunk_result result;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return bool(ready[n % window]); });
+        std::swap(result, slots[n % window]);
+        ready[n % window] = false;
+        ++written;
+      }
+      changed.notify_all();
+
+      if(!skip)
+      {
+        writer.write(result.text);
+        skip = result.exit;
+      }
+      else
+      {
+        writer.write(result.shifted);
+        if(result.rejoin == chunk_result::never)
+          skip = result.shifted_exit;
+        else
+        {
+          writer.write(std::string_view(result.text).substr(result.rejoin));
+          skip = result.exit;
+        }
+      }
+    }
+
+    if(image.size() & 1)
+    {
+      std::string text;
+      append_hex(text, options.base + uint32_t(image.size() - 1), 8);
+      text += ":  ";
+      append_hex(text, image.data()[image.size() - 1], 2);
+      text += "          .byte   0x";
+      append_hex(text, image.data()[image.size() - 1], 2);
+      text += '\n';
+      writer.write(text);
+    }
+    writer.flush();
+  }
+  catch(...)
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      failed = true;
+    }
+    changed.notify_all();
+    for(std::thread& t : pool)
+      t.join();
+    throw;
+  }
+
+  for(std::thread& t : pool)
+    t.join();
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argc, char* argv[])
+{
+  try
+  {
+    const std::string usage = "usage: sh_disasm [--cpu NAME] [--base ADDRESS] [--little-endian] "
+                              "[--threads N] [--chunk KB] [-o OUTPUT] IMAGE";
+    disasm_options options;
+    for(int arg = 1; arg < argc; ++arg)
+    {
+      std::string opt = argv[arg];
+      if(opt == "--little-endian")
+        options.little_endian = true;
+      else if(opt.empty() || opt[0] != '-')
+      {
+        if(!options.input.empty())
+          throw(usage);
+        options.input = opt;
+      }
+      else if(arg + 1 >= argc)
+        throw("missing value for: "s + opt);
+      else if(opt == "--cpu")
+      {
+        options.cpu = parse_cpu_name(argv[++arg]);
+        if(options.cpu == SH_NONE)
+          throw("unknown cpu: "s + argv[arg]);
+      }
+      else if(opt == "--base")
+        options.base = uint32_t(std::stoul(argv[++arg], nullptr, 0));
+      else if(opt == "--threads")
+        options.threads = std::max(1u, unsigned(std::stoul(argv[++arg])));
+      else if(opt == "--chunk")
+        options.chunk = std::max<std::size_t>(1, std::stoul(argv[++arg])) << 10;
+      else if(opt == "-o")
+        options.output = argv[++arg];
+      else
+        throw("unknown option: "s + opt);
+    }
+
+    if(options.input.empty())
+      throw(usage);
+    return disassemble(options);
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 1;
+}
@@ -0,0 +1,1761 @@
+/*
+sh_gen - tables and reports generated from the SuperH instruction database
+
+Usage: sh_gen coverage [--cpu NAME] [--ranges] [--overlaps]
+       sh_gen illegal [--cpu NAME]
+       sh_gen compact [--cpu NAME]
+       sh_gen opcodes
+       sh_gen schedule [--cpu NAME]
+       sh_gen names
+       sh_gen interpreter
+
+coverage  reports for every CPU variant the 16-bit encodings no instruction
+          claims (holes) and the opcode patterns that accept common encodings
+          (overlaps).  --ranges lists the holes, --overlaps every overlapping
+          pair with the pattern that wins.  ambiguous pairs are always listed.
+illegal   writes a C header with the general and slot illegal instruction
+          bit sets of the first halfwords.
+compact   writes a standalone C header that decodes the instructions of one
+          CPU variant (SH2 by default) for tools running on the target: a
+          packed decision tree with shared subtrees, the mnemonics and
+          operand strings in one blob and the operand fields.  it needs no
+          allocation and reports the bytes of ROM it takes.
+opcodes   writes a C opcode table of every instruction for toolchain
+          disassemblers: bucketed by the top nibble, sorted by precedence
+          (32-bit forms, then the most fixed bits) in groups of equal masks
+          that are binary searched on the match.  every entry has its
+          mnemonic, operand kinds and instruction sets.
+schedule  writes a C header with the scheduling model of the database: per
+          CPU variant the instruction classes (execution group, issue and
+          latency cycles) and the class of every instruction, and the
+          execution units and dual issue pairs of the SH4 groups.
+names     writes instruction_names.h, the compile time perfect hashes from
+          the mnemonics and the format strings to the instruction ids
+          ("make names" after changing the database).
+interpreter
+          writes the handlers of the interpreter core, made from the C
+          operation snippets of the instructions, and the list of the
+          instruction ids to dispatch on.  snippets that need more than the
+          registers, the memory accesses and the delay slot of the core are
+          listed as unimplemented with the reason.  the instructions of the
+          DSP sections all go to the DSP unit of the core.  the comparisons
+          that set T in the snippets flagged "Result -> T" (MSB, LSB) become
+          calls of the core's T bit, which sets it without a branch.
+*/
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "decode_table.h"
+#include "decode_tree.h"
+#include "opcode_map.h"
+#include "operand_extractor.h"
+
+using namespace std::literals::string_literals;
+
+// ----------------------------------------------------------------------------
+
+struct gen_options
+{
+  isa cpu = SH_NONE; // every variant
+  bool ranges = false;
+  bool overlaps = false;
+};
+
+std::string lowercase(std::string text)
+{
+  for(char& c : text)
+    c = char(std::tolower(uint8_t(c)));
+  return text;
+}
+
+std::string format_of(uint16_t id)
+{
+  std::string rval = instruction_entries()[id].source->data<format>();
+  std::replace(rval.begin(), rval.end(), '\t', ' ');
+  std::replace(rval.begin(), rval.end(), '\n', '|');
+  return rval;
+}
+
+template<typename Func>
+void for_each_cpu(const gen_options& options, Func func)
+{
+  for(isa cpu : cpu_variants)
+    if(options.cpu == SH_NONE || options.cpu == cpu)
+      func(cpu);
+}
+
+// ----------------------------------------------------------------------------
+
+int gen_coverage(const gen_options& options)
+{
+  for_each_cpu(options, [&](isa cpu)
+  {
+    const opcode_map& map = opcode_map_for(cpu);
+    const decode_table& table = decode_table_for(cpu);
+    const auto holes = map.illegal_ranges();
+    const auto overlaps = pattern_overlaps(cpu);
+
+    std::size_t extended = 0;
+    std::size_t slot = 0;
+    for(std::size_t word = 0; word < 0x10000; ++word)
+    {
+      if(decode_table::is_extended(table.lookup(uint16_t(word))))
+        ++extended;
+      if(map.is_slot_illegal(uint16_t(word)))
+        ++slot;
+    }
+
+    const std::size_t ambiguous = std::size_t(std::count_if(overlaps.begin(), overlaps.end(),
+                                                            [](const pattern_overlap& o) { return o.ambiguous; }));
+    const std::size_t parallel = std::size_t(std::count_if(overlaps.begin(), overlaps.end(),
+                                                           [](const pattern_overlap& o) { return o.parallel; }));
+
+    std::cout << cpu_name(cpu) << std::endl
+              << "  assigned:     " << 0x10000 - map.illegal_count() << " of 65536 halfwords"
+              << " (" << extended << " start 32-bit forms)" << std::endl
+              << "  illegal:      " << map.illegal_count() << " in " << holes.size() << " ranges" << std::endl
+              << "  slot illegal: " << slot << std::endl
+              << "  overlaps:     " << overlaps.size() << " pattern pairs, " << parallel
+              << " parallel DSP moves, " << ambiguous << " ambiguous" << std::endl;
+
+    for(const pattern_overlap& o : overlaps)
+    {
+      if(o.ambiguous)
+        std::cout << "    ambiguous: " << format_of(o.first_id) << " / " << format_of(o.second_id)
+                  << " (" << o.encodings << " encodings)" << std::endl;
+      else if(options.overlaps && !o.parallel)
+      {
+        const instruction_entry& a = instruction_entries()[o.first_id];
+        const instruction_entry& b = instruction_entries()[o.second_id];
+        const uint16_t winner = specificity(a.pattern) > specificity(b.pattern) ? a.id : b.id;
+        std::cout << "    " << format_of(o.first_id) << " / " << format_of(o.second_id)
+                  << " (" << o.encodings << " encodings, " << format_of(winner) << " wins)" << std::endl;
+      }
+    }
+
+    if(options.ranges)
+      for(const auto& hole : holes)
+        std::cout << "    hole 0x" << std::hex << std::setfill('0') << std::setw(4) << hole.first
+                  << "-0x" << std::setw(4) << hole.second << std::dec << std::setfill(' ') << std::endl;
+  });
+  return 0;
+}
+
+void write_bitset(const std::string& name, const opcode_map::bitset& bits)
+{
+  std::cout << "static const uint64_t " << name << "[" << bits.size() << "] =\n{";
+  for(std::size_t pos = 0; pos < bits.size(); ++pos)
+  {
+    if(pos % 4 == 0)
+      std::cout << "\n ";
+    std::cout << " 0x" << std::hex << std::setfill('0') << std::setw(16) << bits[pos] << std::dec << ",";
+  }
+  std::cout << "\n};\n\n";
+}
+
+int gen_illegal(const gen_options& options)
+{
+  std::cout << "/* generated by sh_gen illegal from the SuperH instruction database */\n\n"
+            << "#ifndef SH_ILLEGAL_H\n"
+            << "#define SH_ILLEGAL_H\n\n"
+            << "#include <stdint.h>\n\n"
+            << "/* one bit per first halfword, set for illegal instructions */\n"
+            << "#define SH_IS_ILLEGAL(bits, word) ((int)(((bits)[(uint16_t)(word) >> 6] >> ((word) & 63)) & 1))\n\n";
+
+  for_each_cpu(options, [&](isa cpu)
+  {
+    const opcode_map& map = opcode_map_for(cpu);
+    const std::string name = lowercase(cpu_name(cpu));
+    write_bitset("sh_illegal_" + name, map.illegal_bits());
+    write_bitset("sh_slot_illegal_" + name, map.slot_illegal_bits());
+  });
+
+  std::cout << "#endif /* SH_ILLEGAL_H */\n";
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// strings packed into one blob.  a string that ends another one is stored
+// only once ("or" in "xor").
+class string_blob
+{
+public:
+  void add(const std::string& text) { strings.push_back(text); }
+
+  // places the strings, the longest first
+  void pack(void)
+  {
+    std::vector<std::string> order = strings;
+    std::sort(order.begin(), order.end(), [](const std::string& a, const std::string& b)
+      { return a.size() != b.size() ? a.size() > b.size() : a < b; });
+    for(const std::string& text : order)
+    {
+      if(offsets.count(text))
+        continue;
+      std::size_t at = std::string::npos;
+      for(const auto& placed : offsets)
+        if(placed.first.size() >= text.size() &&
+           placed.first.compare(placed.first.size() - text.size(), text.size(), text) == 0)
+        {
+          at = placed.second + placed.first.size() - text.size();
+          break;
+        }
+      if(at == std::string::npos)
+      {
+        at = blob.size();
+        blob += text;
+        blob += '\0';
+        heads.push_back(text);
+      }
+      offsets.emplace(text, at);
+    }
+  }
+
+  std::size_t offset(const std::string& text) const { return offsets.at(text); }
+  std::size_t size(void) const { return blob.size(); }
+
+  // one literal per stored string, the last NUL is the one of the array
+  void write(std::ostream& out, const std::string& name) const
+  {
+    out << "static const char " << name << "[" << blob.size() << "] =\n";
+    for(std::size_t pos = 0; pos < heads.size(); ++pos)
+    {
+      out << "  \"";
+      for(char c : heads[pos])
+      {
+        if(c == '"' || c == '\\')
+          out << '\\' << c;
+        else if(c == '\t')
+          out << "\\t";
+        else if(c == '\n')
+          out << "\\n";
+        else if(uint8_t(c) < 0x20 || uint8_t(c) >= 0x7F)
+          out << '\\' << std::oct << std::setw(3) << std::setfill('0') << int(uint8_t(c)) << std::dec << std::setfill(' ');
+        else
+          out << c;
+      }
+      out << (pos + 1 < heads.size() ? "\\0\"\n" : "\"");
+    }
+    out << ";\n\n";
+  }
+
+private:
+  std::vector<std::string> strings;
+  std::map<std::string, std::size_t> offsets;
+  std::vector<std::string> heads; // the strings stored in full, in blob order
+  std::string blob;
+};
+
+const char* c_type(std::size_t max_value)
+{
+  return max_value <= 0xFF ? "uint8_t" : max_value <= 0xFFFF ? "uint16_t" : "uint32_t";
+}
+
+std::size_t c_size(std::size_t max_value)
+{
+  return max_value <= 0xFF ? 1 : max_value <= 0xFFFF ? 2 : 4;
+}
+
+template<typename T>
+void write_array(std::ostream& out, const std::string& type, const std::string& name, const std::vector<T>& values,
+                 int digits)
+{
+  out << "static const " << type << " " << name << "[" << values.size() << "] =\n{";
+  const std::size_t per_line = digits > 4 ? 6 : 10;
+  for(std::size_t pos = 0; pos < values.size(); ++pos)
+  {
+    if(pos % per_line == 0)
+      out << "\n ";
+    out << " 0x" << std::hex << std::setfill('0') << std::setw(digits) << uint32_t(values[pos])
+        << std::dec << std::setfill(' ') << ",";
+  }
+  out << "\n};\n\n";
+}
+
+// the decision tree of decode_tree with equal subtrees and leaves stored once.
+// a node is one word: the low 5 bits are the shift of the switched field (the
+// pattern count of a leaf), the next 4 its width (0 for leaves) and the rest
+// the first child, or the first pattern of a leaf.
+struct packed_tree
+{
+  std::vector<uint32_t> nodes;   // child blocks, 1 << width nodes each
+  std::vector<uint32_t> mask;    // leaf patterns
+  std::vector<uint32_t> match;
+  std::vector<uint16_t> insn;    // local instruction number
+  uint32_t root = 0;
+  std::size_t depth = 0;
+};
+
+packed_tree pack_tree(const decode_tree& tree, const std::vector<uint16_t>& local, int word_bits)
+{
+  packed_tree rval;
+  std::map<std::vector<uint32_t>, uint32_t> blocks;
+  std::map<std::vector<uint32_t>, uint32_t> leaves; // mask, match, insn triples
+
+  const int unused = 32 - word_bits; // 16-bit variants drop the second halfword
+  std::function<uint32_t(std::size_t, std::size_t)> pack = [&](std::size_t index, std::size_t level) -> uint32_t
+  {
+    const decode_tree::node& n = tree.tree()[index];
+    rval.depth = std::max(rval.depth, level);
+    if(!n.width)
+    {
+      if(n.count > 31)
+        throw("leaf with more than 31 patterns"s);
+      std::vector<uint32_t> key;
+      for(std::size_t p = n.next; p < n.next + n.count; ++p)
+      {
+        const decode_tree::pattern& pattern = tree.leaf_patterns()[p];
+        key.insert(key.end(), { pattern.mask >> unused, pattern.match >> unused, local[pattern.id] });
+      }
+      auto found = leaves.find(key);
+      if(found == leaves.end())
+      {
+        found = leaves.emplace(key, uint32_t(rval.mask.size())).first;
+        for(std::size_t k = 0; k < key.size(); k += 3)
+        {
+          rval.mask.push_back(key[k]);
+          rval.match.push_back(key[k + 1]);
+          rval.insn.push_back(uint16_t(key[k + 2]));
+        }
+      }
+      return (found->second << 9) | n.count;
+    }
+
+    std::vector<uint32_t> block;
+    for(uint32_t child = 0; child < (1u << n.width); ++child)
+      block.push_back(pack(n.next + child, level + 1));
+    auto found = blocks.find(block);
+    if(found == blocks.end())
+    {
+      found = blocks.emplace(block, uint32_t(rval.nodes.size())).first;
+      rval.nodes.insert(rval.nodes.end(), block.begin(), block.end());
+    }
+    return (found->second << 9) | (uint32_t(n.width) << 5) | uint32_t(n.shift - unused);
+  };
+
+  rval.root = pack(0, 0);
+  if(std::max(rval.nodes.size(), rval.mask.size()) >= (1u << 23))
+    throw("decode tree too large to pack"s);
+  return rval;
+}
+
+int gen_compact(const gen_options& options)
+{
+  const isa cpu = options.cpu == SH_NONE ? SH2 : options.cpu;
+  const isa instruction_sets = cpu_instruction_sets(cpu);
+  const std::string prefix = lowercase(cpu_name(cpu)) + "_";
+  std::string macro = cpu_name(cpu);
+  for(char& c : macro)
+    c = char(std::toupper(uint8_t(c)));
+
+  // instructions of the variant, numbered in database order
+  std::vector<uint16_t> local(instruction_entries().size(), 0);
+  std::vector<const instruction_entry*> entries;
+  int word_bits = 16;
+  for(const instruction_entry& entry : instruction_entries())
+    if(entry.source->for_isa(instruction_sets))
+    {
+      local[entry.id] = uint16_t(entries.size());
+      entries.push_back(&entry);
+      word_bits = std::max<int>(word_bits, entry.pattern.width);
+    }
+
+  const std::size_t invalid = entries.size() < 0xFF ? 0xFF : 0xFFFF;
+  const packed_tree tree = pack_tree(decode_tree(cpu), local, word_bits);
+
+  // mnemonic and operand strings, operand fields shared between instructions
+  string_blob strings;
+  std::vector<std::pair<std::string, std::string>> texts;
+  for(const instruction_entry* entry : entries)
+  {
+    std::string fmt = entry->source->data<format>();
+    std::replace(fmt.begin(), fmt.end(), '\n', ' ');
+    const std::size_t tab = fmt.find('\t');
+    std::string mnemonic = lowercase(fmt.substr(0, tab));
+    std::string operands = tab == std::string::npos ? std::string() : fmt.substr(tab + 1);
+    while(!mnemonic.empty() && mnemonic.back() == ' ')
+      mnemonic.pop_back();
+    std::replace(operands.begin(), operands.end(), '\t', ' ');
+    strings.add(mnemonic);
+    strings.add(operands);
+    texts.emplace_back(mnemonic, operands);
+  }
+  strings.pack();
+
+  struct field { char letter; bool is_signed; uint32_t mask; bool operator==(const field& o) const
+    { return letter == o.letter && is_signed == o.is_signed && mask == o.mask; } };
+  std::vector<field> fields;
+  std::vector<std::pair<std::size_t, std::size_t>> field_runs; // first, count
+  std::vector<uint8_t> info;
+  for(const instruction_entry* entry : entries)
+  {
+    const operand_extractor& extractor = operand_extractors()[entry->id];
+    std::vector<field> run;
+    for(std::size_t f = 0; f < entry->pattern.fields.size(); ++f)
+    {
+      const int shift = entry->pattern.width == 16 ? word_bits - 16 : 0; // 16-bit forms in the upper half
+      run.push_back({ entry->pattern.fields[f].letter, extractor.sign_bit[f] != 0, entry->pattern.fields[f].mask << shift });
+    }
+    if(run.size() > 7)
+      throw("too many operand fields"s);
+
+    auto found = std::search(fields.begin(), fields.end(), run.begin(), run.end());
+    if(found == fields.end() && !run.empty())
+      found = fields.insert(fields.end(), run.begin(), run.end());
+    field_runs.emplace_back(std::size_t(found - fields.begin()), run.size());
+
+    const displacement_info disp = displacement_of(*entry->source);
+    uint8_t pc = 0;
+    if(disp.pc_relative)
+    {
+      if(disp.pc_offset == 4)
+        pc = disp.pc_aligned ? 2 : 1;
+      else if(disp.pc_offset == 0 && !disp.pc_aligned)
+        pc = 3;
+      else
+        throw("unexpected PC offset in "s + format_of(entry->id));
+    }
+    const uint8_t scale = disp.scale == 4 ? 2 : disp.scale == 2 ? 1 : 0;
+    info.push_back(uint8_t(run.size() | (entry->pattern.width == 32 ? 0x08 : 0) | (scale << 4) | (pc << 6)));
+  }
+  if(fields.size() > 0xFF)
+    throw("too many operand fields"s);
+
+  // ROM size of every table as the C compiler lays it out
+  const std::size_t word_size = std::size_t(word_bits / 8);
+  const std::size_t insn_size = 2 * c_size(strings.size()) + 2;
+  const std::size_t field_size = 2 * word_size; // letter, sign, mask aligned to its size
+  const std::size_t tree_bytes = tree.nodes.size() * 4;
+  const std::size_t pattern_bytes = tree.mask.size() * (2 * word_size + c_size(invalid));
+  const std::size_t insn_bytes = entries.size() * insn_size;
+  const std::size_t field_bytes = fields.size() * field_size;
+  const std::size_t total = tree_bytes + pattern_bytes + insn_bytes + field_bytes + strings.size();
+
+  const std::string word_type = word_bits == 16 ? "uint16_t" : "uint32_t";
+  const std::string index_type = c_type(invalid);
+  const std::string offset_type = c_type(strings.size());
+  const int digits = word_bits / 4;
+  std::ostream& out = std::cout;
+
+  out << "/* generated by sh_gen compact --cpu " << cpu_name(cpu) << " from the SuperH instruction database */\n\n"
+      << "/*\n"
+      << "  decodes the " << entries.size() << " instructions of the " << cpu_name(cpu) << ".\n"
+      << "  " << prefix << "decode() walks a decision tree (depth " << tree.depth << ") down to a leaf and\n"
+      << "  tests its few patterns; equal subtrees and leaves are stored once.\n"
+      << "  every table is const, nothing is allocated.\n\n"
+      << "  ROM: tree " << tree_bytes << ", patterns " << pattern_bytes << ", instructions " << insn_bytes
+      << ", fields " << field_bytes << ", strings " << strings.size() << "\n"
+      << "       " << total << " bytes\n"
+      << "*/\n\n"
+      << "#ifndef SH_COMPACT_" << macro << "_H\n"
+      << "#define SH_COMPACT_" << macro << "_H\n\n"
+      << "#include <stdint.h>\n\n"
+      << "#define " << macro << "_INSN_COUNT " << entries.size() << "\n"
+      << "#define " << macro << "_INVALID 0x" << std::hex << invalid << std::dec << "\n"
+      << "#define " << macro << "_TREE_ROOT 0x" << std::hex << tree.root << std::dec << "u\n\n";
+
+  out << "/* info: bits 0-2 operand field count, bit 3 32-bit form, bits 4-5 log2 of the\n"
+      << "   displacement scale, bits 6-7 address of PC relative forms: 1 PC + 4 + disp,\n"
+      << "   2 (PC & ~3) + 4 + disp, 3 PC + disp */\n"
+      << "struct " << prefix << "insn\n{\n"
+      << "  " << offset_type << " mnemonic; /* in " << prefix << "strings */\n"
+      << "  " << offset_type << " operands; /* as in the manual (\"@(disp,Rm),Rn\"), \"\" if none */\n"
+      << "  uint8_t fields;    /* first of " << prefix << "fields */\n"
+      << "  uint8_t info;\n"
+      << "};\n\n"
+      << "struct " << prefix << "field\n{\n"
+      << "  char letter;       /* 'n', 'm', 'i', 'd', ... */\n"
+      << "  uint8_t is_signed;\n"
+      << "  " << word_type << " mask;\n"
+      << "};\n\n";
+
+  write_array(out, "uint32_t", prefix + "tree", tree.nodes, 8);
+  write_array(out, word_type, prefix + "pattern_mask", tree.mask, digits);
+  write_array(out, word_type, prefix + "pattern_match", tree.match, digits);
+  write_array(out, index_type, prefix + "pattern_insn", tree.insn, int(c_size(invalid) * 2));
+
+  out << "static const struct " << prefix << "insn " << prefix << "insns[" << entries.size() << "] =\n{\n";
+  for(std::size_t pos = 0; pos < entries.size(); ++pos)
+    out << "  { " << strings.offset(texts[pos].first) << ", " << strings.offset(texts[pos].second) << ", "
+        << field_runs[pos].first << ", 0x" << std::hex << int(info[pos]) << std::dec << " }, /* "
+        << texts[pos].first << (texts[pos].second.empty() ? "" : " ") << texts[pos].second << " */\n";
+  out << "};\n\n";
+
+  out << "static const struct " << prefix << "field " << prefix << "fields[" << std::max<std::size_t>(fields.size(), 1)
+      << "] =\n{\n";
+  for(const field& f : fields)
+    out << "  { '" << f.letter << "', " << f.is_signed << ", 0x" << std::hex << std::setfill('0') << std::setw(digits)
+        << f.mask << std::dec << std::setfill(' ') << " },\n";
+  if(fields.empty())
+    out << "  { 0, 0, 0 },\n";
+  out << "};\n\n";
+
+  strings.write(out, prefix + "strings");
+
+  out << "#define " << macro << "_ROM_SIZE (sizeof(" << prefix << "tree) + sizeof(" << prefix << "pattern_mask) + "
+      << "sizeof(" << prefix << "pattern_match) + \\\n"
+      << "  sizeof(" << prefix << "pattern_insn) + sizeof(" << prefix << "insns) + sizeof(" << prefix << "fields) + "
+      << "sizeof(" << prefix << "strings))\n\n";
+
+  const std::string word_expr = word_bits == 16 ? "first" : "((uint32_t)first << 16) | second";
+  out << "/* instruction number of the halfwords, " << macro << "_INVALID if none.\n"
+      << "   'second' is the halfword after 'first'" << (word_bits == 16 ? " (unused, no 32-bit forms)" : "") << ". */\n"
+      << "static inline unsigned " << prefix << "decode(uint16_t first, uint16_t second)\n{\n"
+      << "  const " << word_type << " word = " << word_expr << ";\n"
+      << "  uint32_t node = " << macro << "_TREE_ROOT;\n"
+      << "  uint32_t p, end;\n"
+      << (word_bits == 16 ? "  (void)second;\n" : "")
+      << "  while((node >> 5) & 15)\n"
+      << "    node = " << prefix << "tree[(node >> 9) + ((word >> (node & 31)) & ((1u << ((node >> 5) & 15)) - 1))];\n"
+      << "  for(p = node >> 9, end = p + (node & 31); p != end; ++p)\n"
+      << "    if((word & " << prefix << "pattern_mask[p]) == " << prefix << "pattern_match[p])\n"
+      << "      return " << prefix << "pattern_insn[p];\n"
+      << "  return " << macro << "_INVALID;\n"
+      << "}\n\n"
+      << "static inline const char* " << prefix << "mnemonic(unsigned insn)\n"
+      << "  { return " << prefix << "strings + " << prefix << "insns[insn].mnemonic; }\n\n"
+      << "static inline const char* " << prefix << "operands(unsigned insn)\n"
+      << "  { return " << prefix << "strings + " << prefix << "insns[insn].operands; }\n\n"
+      << "/* size of the instruction in bytes */\n"
+      << "static inline unsigned " << prefix << "size(unsigned insn)\n"
+      << "  { return " << prefix << "insns[insn].info & 0x08 ? 4 : 2; }\n\n"
+      << "/* value of the operand field 'letter' ('n', 'd', ...), 0 if the instruction has none */\n"
+      << "static inline int32_t " << prefix << "operand(unsigned insn, char letter, uint16_t first, uint16_t second)\n{\n"
+      << "  const struct " << prefix << "field* f = " << prefix << "fields + " << prefix << "insns[insn].fields;\n"
+      << "  const struct " << prefix << "field* end = f + (" << prefix << "insns[insn].info & 7);\n"
+      << "  const " << word_type << " word = " << word_expr << ";\n"
+      << (word_bits == 16 ? "  (void)second;\n" : "")
+      << "  for(; f != end; ++f)\n"
+      << "    if(f->letter == letter)\n"
+      << "    {\n"
+      << "      uint32_t value = 0, bit = 1, mask;\n"
+      << "      for(mask = f->mask; mask; mask &= mask - 1, bit <<= 1)\n"
+      << "        if(word & mask & (0u - mask))\n"
+      << "          value |= bit;\n"
+      << "      if(f->is_signed && (value & (bit >> 1)))\n"
+      << "        value |= 0u - bit;\n"
+      << "      return (int32_t)value;\n"
+      << "    }\n"
+      << "  return 0;\n"
+      << "}\n\n"
+      << "#endif /* SH_COMPACT_" << macro << "_H */\n";
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// operands of a format string ("@(disp,Rm),Rn" -> "@(disp,Rm)", "Rn").
+// the parallel DSP forms list the operands of both operations.
+std::vector<std::string> operands_of(const std::string& fmt, std::string& mnemonic)
+{
+  std::vector<std::string> rval;
+  mnemonic.clear();
+  std::size_t start = 0;
+  while(start < fmt.size())
+  {
+    std::size_t end = fmt.find('\n', start);
+    if(end == std::string::npos)
+      end = fmt.size();
+    const std::string part = fmt.substr(start, end - start);
+    const std::size_t tab = part.find('\t');
+
+    std::string name = lowercase(part.substr(0, tab));
+    while(!name.empty() && name.back() == ' ')
+      name.pop_back();
+    mnemonic += (mnemonic.empty() ? "" : " ") + name;
+
+    if(tab != std::string::npos)
+    {
+      int depth = 0;
+      std::string operand;
+      for(char c : part.substr(tab + 1))
+      {
+        depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+        if(c == ',' && !depth)
+        {
+          rval.push_back(operand);
+          operand.clear();
+        }
+        else
+          operand += c;
+      }
+      rval.push_back(operand);
+    }
+    start = end + 1;
+  }
+  return rval;
+}
+
+// enumerator of an operand kind ("@(disp,Rm)" -> "SH_ARG_AT_DISP_RM")
+std::string operand_kind_name(const std::string& operand)
+{
+  std::string rval = "SH_ARG";
+  std::string word;
+  auto flush = [&](void)
+  {
+    if(!word.empty())
+      rval += "_" + word;
+    word.clear();
+  };
+
+  for(char c : operand)
+  {
+    if(std::isalnum(uint8_t(c)) || c == '_')
+      word += char(std::toupper(uint8_t(c)));
+    else
+    {
+      flush();
+      if(c == '@')
+        rval += "_AT";
+      else if(c == '-')
+        rval += "_DEC";
+      else if(c == '+')
+        rval += "_INC";
+    }
+  }
+  flush();
+  return rval;
+}
+
+int gen_opcodes(const gen_options&)
+{
+  struct opcode
+  {
+    const instruction_entry* entry;
+    std::string mnemonic;
+    std::vector<std::size_t> kinds;
+    uint32_t mask;  // first halfword in the upper 16 bits
+    uint32_t match;
+  };
+
+  std::vector<std::string> kinds = { "" };
+  std::vector<opcode> opcodes;
+  std::size_t max_operands = 1;
+  for(const instruction_entry& entry : instruction_entries())
+  {
+    opcode op;
+    op.entry = &entry;
+    for(const std::string& operand : operands_of(entry.source->data<format>(), op.mnemonic))
+    {
+      auto pos = std::find(kinds.begin(), kinds.end(), operand);
+      if(pos == kinds.end())
+        pos = kinds.insert(kinds.end(), operand);
+      op.kinds.push_back(std::size_t(pos - kinds.begin()));
+    }
+    max_operands = std::max(max_operands, op.kinds.size());
+    op.mask = entry.pattern.mask << (32 - entry.pattern.width);
+    op.match = entry.pattern.match << (32 - entry.pattern.width);
+    if((op.mask >> 28) != 0xF)
+      throw("top nibble not fixed in "s + format_of(entry.id));
+    opcodes.push_back(op);
+  }
+
+  // the order of precedence of decode_table: 32-bit forms, the most fixed bits,
+  // the database order.  equal masks form a group sorted by match, the groups
+  // of equally specific masks (the X and Y moves of SH-DSP) keep the order of
+  // their first entries.
+  std::map<std::pair<uint32_t, uint32_t>, uint16_t> group_order; // top nibble and mask
+  for(const opcode& op : opcodes)
+    group_order.emplace(std::make_pair(op.match >> 28, op.mask), op.entry->id);
+
+  std::stable_sort(opcodes.begin(), opcodes.end(), [&](const opcode& a, const opcode& b)
+    {
+      if(a.match >> 28 != b.match >> 28)
+        return a.match >> 28 < b.match >> 28;
+      if(a.entry->pattern.width != b.entry->pattern.width)
+        return a.entry->pattern.width > b.entry->pattern.width;
+      const int spec_a = specificity(a.entry->pattern);
+      const int spec_b = specificity(b.entry->pattern);
+      if(spec_a != spec_b)
+        return spec_a > spec_b;
+      return group_order[{ a.match >> 28, a.mask }] < group_order[{ b.match >> 28, b.mask }];
+    });
+
+  struct group { uint32_t mask; std::size_t first; std::size_t count; };
+  std::vector<group> groups;
+  std::vector<std::size_t> buckets(17, 0);
+  for(std::size_t pos = 0; pos < opcodes.size(); )
+  {
+    std::size_t end = pos;
+    while(end < opcodes.size() && opcodes[end].mask == opcodes[pos].mask &&
+          opcodes[end].match >> 28 == opcodes[pos].match >> 28)
+      ++end;
+    std::stable_sort(opcodes.begin() + long(pos), opcodes.begin() + long(end),
+                     [](const opcode& a, const opcode& b) { return a.match < b.match; });
+    groups.push_back({ opcodes[pos].mask, pos, end - pos });
+    buckets[(opcodes[pos].match >> 28) + 1] = groups.size();
+    pos = end;
+  }
+  for(std::size_t nibble = 1; nibble <= 16; ++nibble)
+    buckets[nibble] = std::max(buckets[nibble], buckets[nibble - 1]);
+
+  std::ostream& out = std::cout;
+  out << "/* generated by sh_gen opcodes from the SuperH instruction database */\n\n"
+      << "/*\n"
+      << "  opcode table of the " << opcodes.size() << " instructions of every SuperH variant.\n"
+      << "  the entries are bucketed by the top nibble of the first halfword and sorted\n"
+      << "  by precedence (32-bit forms, then the most fixed bits) in groups of equal\n"
+      << "  masks, each group sorted by match.  sh_find_opcode() binary searches the\n"
+      << "  groups of a bucket in order, the first entry of the instruction sets wins.\n"
+      << "*/\n\n"
+      << "#ifndef SH_OPCODES_H\n"
+      << "#define SH_OPCODES_H\n\n"
+      << "#include <stdint.h>\n\n"
+      << "/* instruction sets */\n";
+  for(isa cpu : cpu_variants)
+    out << "#define SH_ISA_" << std::left << std::setw(9) << cpu_name(cpu) << std::right << " 0x"
+        << std::hex << std::setfill('0') << std::setw(4) << uint16_t(cpu) << std::dec << std::setfill(' ') << "\n";
+  out << "\n/* the instruction sets a CPU executes */\n";
+  for(isa cpu : cpu_variants)
+    out << "#define SH_CPU_" << std::left << std::setw(9) << cpu_name(cpu) << std::right << " 0x"
+        << std::hex << std::setfill('0') << std::setw(4) << uint16_t(cpu_instruction_sets(cpu)) << std::dec
+        << std::setfill(' ') << "\n";
+
+  out << "\n#define SH_MAX_ARGS " << max_operands << "\n\n"
+      << "/* operands as written in the manual */\n"
+      << "enum sh_arg_type\n{\n"
+      << "  SH_ARG_NONE,\n";
+  for(std::size_t kind = 1; kind < kinds.size(); ++kind)
+    out << "  " << std::left << std::setw(20) << operand_kind_name(kinds[kind]) + "," << std::right
+        << " /* " << kinds[kind] << " */\n";
+  out << "};\n\n"
+      << "struct sh_opcode\n{\n"
+      << "  const char* name;    /* \"mov.l\", both operations of parallel DSP forms */\n"
+      << "  uint32_t mask;       /* fixed bits, the first halfword in the upper 16 bits */\n"
+      << "  uint32_t match;\n"
+      << "  uint16_t isa;        /* SH_ISA_* that have the instruction */\n"
+      << "  uint8_t size;        /* bytes */\n"
+      << "  uint8_t args[SH_MAX_ARGS]; /* enum sh_arg_type */\n"
+      << "};\n\n"
+      << "struct sh_opcode_group\n{\n"
+      << "  uint32_t mask;       /* of all its entries */\n"
+      << "  uint16_t first;      /* in sh_opcodes */\n"
+      << "  uint16_t count;\n"
+      << "};\n\n";
+
+  out << "static const struct sh_opcode sh_opcodes[" << opcodes.size() << "] =\n{\n";
+  for(std::size_t pos = 0; pos < opcodes.size(); ++pos)
+  {
+    const opcode& op = opcodes[pos];
+    if(std::any_of(groups.begin(), groups.end(), [&](const group& g) { return g.first == pos; }))
+      out << (pos ? "\n" : "") << "  /* mask 0x" << std::hex << std::setfill('0') << std::setw(8) << op.mask
+          << std::dec << std::setfill(' ') << " */\n";
+    out << "  { \"" << op.mnemonic << "\", 0x" << std::hex << std::setfill('0') << std::setw(8) << op.mask
+        << ", 0x" << std::setw(8) << op.match << ", 0x" << std::setw(4) << uint16_t(std::get<isa>(op.entry->source->details))
+        << std::dec << std::setfill(' ') << ", " << op.entry->pattern.width / 8 << ", {";
+    for(std::size_t arg = 0; arg < op.kinds.size(); ++arg)
+      out << (arg ? ", " : " ") << operand_kind_name(kinds[op.kinds[arg]]);
+    out << (op.kinds.empty() ? " 0 } },\n" : " } },\n");
+  }
+  out << "};\n\n";
+
+  out << "static const struct sh_opcode_group sh_opcode_groups[" << groups.size() << "] =\n{\n";
+  for(const group& g : groups)
+    out << "  { 0x" << std::hex << std::setfill('0') << std::setw(8) << g.mask << std::dec << std::setfill(' ')
+        << ", " << g.first << ", " << g.count << " },\n";
+  out << "};\n\n"
+      << "/* the groups of top nibble k are [sh_opcode_buckets[k], sh_opcode_buckets[k + 1]) */\n"
+      << "static const uint16_t sh_opcode_buckets[17] =\n{\n ";
+  for(std::size_t b : buckets)
+    out << " " << b << ",";
+  out << "\n};\n\n";
+
+  out << "/* the entry that decodes the halfwords on a CPU executing the instruction\n"
+      << "   sets 'isa' (SH_CPU_*), 0 if none.  'second' is the halfword after 'first',\n"
+      << "   only 32-bit forms look at it. */\n"
+      << "static inline const struct sh_opcode* sh_find_opcode(uint16_t first, uint16_t second, unsigned isa)\n{\n"
+      << "  const uint32_t word = ((uint32_t)first << 16) | second;\n"
+      << "  unsigned g;\n"
+      << "  for(g = sh_opcode_buckets[first >> 12]; g != sh_opcode_buckets[(first >> 12) + 1]; ++g)\n"
+      << "  {\n"
+      << "    const struct sh_opcode_group* group = &sh_opcode_groups[g];\n"
+      << "    const uint32_t key = word & group->mask;\n"
+      << "    unsigned low = group->first, high = group->first + group->count;\n"
+      << "    while(low < high)\n"
+      << "    {\n"
+      << "      const unsigned mid = (low + high) / 2;\n"
+      << "      if(sh_opcodes[mid].match < key)\n"
+      << "        low = mid + 1;\n"
+      << "      else\n"
+      << "        high = mid;\n"
+      << "    }\n"
+      << "    for(; low != group->first + group->count && sh_opcodes[low].match == key; ++low)\n"
+      << "      if(sh_opcodes[low].isa & isa)\n"
+      << "        return &sh_opcodes[low];\n"
+      << "  }\n"
+      << "  return 0;\n"
+      << "}\n\n"
+      << "#endif /* SH_OPCODES_H */\n";
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// cycles of an issue or latency entry: "2", "1-16" (from 1 to 16),
+// "3/4" (3, another result after 4) or "ud" (undefined, unknown)
+struct cycles
+{
+  static constexpr uint8_t unknown = 0xFF;
+
+  uint8_t min = unknown;
+  uint8_t max = unknown;
+  uint8_t other = unknown; // after the '/'
+
+  bool operator<(const cycles& o) const
+    { return std::tie(min, max, other) < std::tie(o.min, o.max, o.other); }
+};
+
+cycles parse_cycles(const std::string& text)
+{
+  cycles rval;
+  if(text.empty() || !std::isdigit(uint8_t(text[0])))
+    return rval;
+
+  std::size_t end;
+  rval.min = rval.max = uint8_t(std::stoi(text, &end));
+  if(end < text.size() && text[end] == '-')
+    rval.max = uint8_t(std::stoi(text.substr(end + 1)));
+  else if(end < text.size() && text[end] == '/')
+    rval.other = uint8_t(std::stoi(text.substr(end + 1)));
+  return rval;
+}
+
+// the value of a variant, from its own instruction set first
+std::string property_for(const isa_property& property, isa cpu)
+{
+  if(!property[cpu].empty())
+    return property[cpu];
+  const isa instruction_sets = cpu_instruction_sets(cpu);
+  for(uint16_t bit = 1; bit & SH_ALL; bit = uint16_t(bit << 1))
+    if((instruction_sets & bit) && !property[bit].empty())
+      return property[bit];
+  return "";
+}
+
+// SH4 execution groups in the order of sh_sched_group
+const std::array<std::string, 7> sched_groups = { "", "MT", "EX", "BR", "LS", "FE", "CO" };
+
+// issue slots and execution units the SH4 groups take.  two instructions
+// issue in the same cycle when they fit the two slots and use different units:
+// MT pairs with every group but CO, the others with every other group but CO.
+struct sched_resource
+{
+  uint8_t slots;
+  uint8_t units; // EX 1, LS 2, BR 4, FE 8
+};
+
+const std::array<sched_resource, 7> sh4_resources =
+{{
+  { 2, 15 },  // unknown, alone
+  { 1, 0 },   // MT, either pipeline
+  { 1, 1 },   // EX
+  { 1, 4 },   // BR
+  { 1, 2 },   // LS
+  { 1, 8 },   // FE
+  { 2, 15 },  // CO, alone
+}};
+
+int gen_schedule(const gen_options& options)
+{
+  struct sched_class
+  {
+    std::size_t group;
+    cycles issue;
+    cycles latency;
+
+    bool operator<(const sched_class& o) const
+      { return std::tie(group, issue, latency) < std::tie(o.group, o.issue, o.latency); }
+  };
+
+  auto cycles_text = [](uint8_t value) { return value == cycles::unknown ? "SH_SCHED_UNKNOWN"s : std::to_string(value); };
+
+  std::ostream& out = std::cout;
+  out << "/* generated by sh_gen schedule from the SuperH instruction database */\n\n"
+      << "/*\n"
+      << "  scheduling model of the documented execution groups, issue and latency\n"
+      << "  cycles.  every CPU variant has a table of instruction classes and the class\n"
+      << "  of each of its instructions, found by (first << 16 | second) & mask == match\n"
+      << "  (16-bit forms in the upper half).  cycles given as a range (\"1-16\") have a\n"
+      << "  min and a max, \"3/4\" has a second latency for another result (other).\n"
+      << "*/\n\n"
+      << "#ifndef SH_SCHEDULE_H\n"
+      << "#define SH_SCHEDULE_H\n\n"
+      << "#include <stdint.h>\n\n"
+      << "#define SH_SCHED_UNKNOWN 0xff\n\n"
+      << "/* SH4 / SH4A execution groups */\n"
+      << "enum sh_sched_group\n{\n"
+      << "  SH_GROUP_NONE,\n";
+  for(std::size_t g = 1; g < sched_groups.size(); ++g)
+    out << "  SH_GROUP_" << sched_groups[g] << ",\n";
+  out << "};\n\n"
+      << "struct sh_sched_class\n{\n"
+      << "  uint8_t group;       /* enum sh_sched_group */\n"
+      << "  uint8_t issue_min;   /* issue cycles */\n"
+      << "  uint8_t issue_max;\n"
+      << "  uint8_t latency_min; /* latency cycles */\n"
+      << "  uint8_t latency_max;\n"
+      << "  uint8_t latency_other;\n"
+      << "};\n\n"
+      << "struct sh_sched_insn\n{\n"
+      << "  uint32_t mask;\n"
+      << "  uint32_t match;\n"
+      << "  uint8_t sched_class; /* in the class table of the variant */\n"
+      << "};\n\n";
+
+  for_each_cpu(options, [&](isa cpu)
+  {
+    const isa instruction_sets = cpu_instruction_sets(cpu);
+    const std::string name = lowercase(cpu_name(cpu));
+
+    std::map<sched_class, std::size_t> classes;
+    std::vector<sched_class> class_list;
+    std::vector<std::pair<const instruction_entry*, std::size_t>> insns;
+    for(const instruction_entry& entry : instruction_entries())
+    {
+      if(!entry.source->for_isa(instruction_sets))
+        continue;
+
+      sched_class c;
+      const std::string g = property_for(entry.source->data<::group>(), cpu);
+      c.group = std::size_t(std::find(sched_groups.begin(), sched_groups.end(), g) - sched_groups.begin());
+      if(c.group == sched_groups.size())
+        throw("unknown execution group "s + g + " of " + format_of(entry.id));
+      c.issue = parse_cycles(property_for(entry.source->data<issue>(), cpu));
+      c.latency = parse_cycles(property_for(entry.source->data<latency>(), cpu));
+
+      auto pos = classes.find(c);
+      if(pos == classes.end())
+      {
+        pos = classes.emplace(c, class_list.size()).first;
+        class_list.push_back(c);
+      }
+      insns.emplace_back(&entry, pos->second);
+    }
+
+    out << "/* " << cpu_name(cpu) << ": " << class_list.size() << " classes, " << insns.size() << " instructions */\n"
+        << "static const struct sh_sched_class sh_sched_classes_" << name << "[" << class_list.size() << "] =\n{\n";
+    for(const sched_class& c : class_list)
+      out << "  { SH_GROUP_" << (c.group ? sched_groups[c.group] : "NONE"s) << ", "
+          << cycles_text(c.issue.min) << ", " << cycles_text(c.issue.max) << ", "
+          << cycles_text(c.latency.min) << ", " << cycles_text(c.latency.max) << ", "
+          << cycles_text(c.latency.other) << " },\n";
+    out << "};\n\n"
+        << "static const struct sh_sched_insn sh_sched_insns_" << name << "[" << insns.size() << "] =\n{\n";
+    for(const auto& insn : insns)
+    {
+      const opcode_pattern& p = insn.first->pattern;
+      out << "  { 0x" << std::hex << std::setfill('0') << std::setw(8) << (p.mask << (32 - p.width))
+          << ", 0x" << std::setw(8) << (p.match << (32 - p.width)) << std::dec << std::setfill(' ')
+          << ", " << std::setw(2) << insn.second << " }, /* " << format_of(insn.first->id) << " */\n";
+    }
+    out << "};\n\n";
+  });
+
+  out << "/* SH4 dual issue.  every group takes issue slots (of 2) and execution units\n"
+      << "   (EX 1, LS 2, BR 4, FE 8); two instructions issue in the same cycle when\n"
+      << "   their slots fit and their units differ. */\n"
+      << "struct sh_sched_resource\n{\n"
+      << "  uint8_t slots;\n"
+      << "  uint8_t units;\n"
+      << "};\n\n"
+      << "static const struct sh_sched_resource sh_sched_resources_sh4[" << sh4_resources.size() << "] =\n{\n";
+  for(std::size_t g = 0; g < sh4_resources.size(); ++g)
+    out << "  { " << int(sh4_resources[g].slots) << ", 0x" << std::hex << int(sh4_resources[g].units) << std::dec
+        << " }, /* " << (g ? sched_groups[g] : "NONE"s) << " */\n";
+  out << "};\n\n"
+      << "/* bit g2 of sh_sched_pairs_sh4[g1]: groups g1 and g2 issue together */\n"
+      << "static const uint8_t sh_sched_pairs_sh4[" << sh4_resources.size() << "] =\n{\n";
+  for(std::size_t a = 0; a < sh4_resources.size(); ++a)
+  {
+    unsigned pairs = 0;
+    for(std::size_t b = 1; b < sh4_resources.size(); ++b)
+      if(a && sh4_resources[a].slots + sh4_resources[b].slots <= 2 && !(sh4_resources[a].units & sh4_resources[b].units))
+        pairs |= 1u << b;
+    out << "  0x" << std::hex << std::setfill('0') << std::setw(2) << pairs << std::dec << std::setfill(' ')
+        << ", /* " << (a ? sched_groups[a] : "NONE"s) << " */\n";
+  }
+  out << "};\n\n"
+      << "#endif /* SH_SCHEDULE_H */\n";
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// lowercase with single spaces ("dcf psub \tSx,Sy,Dz" -> "dcf psub sx,sy,dz")
+std::string name_key(const std::string& text)
+{
+  std::string rval;
+  for(char c : text)
+  {
+    if(std::isspace(uint8_t(c)))
+    {
+      if(!rval.empty() && rval.back() != ' ')
+        rval += ' ';
+    }
+    else
+      rval += char(std::tolower(uint8_t(c)));
+  }
+  if(!rval.empty() && rval.back() == ' ')
+    rval.pop_back();
+  return rval;
+}
+
+int gen_names(const gen_options&)
+{
+  // the forms of a mnemonic are listed shortest first, as the assembler tries them
+  std::vector<const instruction_entry*> entries;
+  for(const instruction_entry& entry : instruction_entries())
+    entries.push_back(&entry);
+  std::stable_sort(entries.begin(), entries.end(), [](const instruction_entry* a, const instruction_entry* b)
+    { return a->pattern.width < b->pattern.width; });
+
+  std::map<std::string, std::vector<uint16_t>> mnemonics;
+  std::map<std::string, std::vector<uint16_t>> formats;
+  for(const instruction_entry* entry : entries)
+  {
+    const std::string& fmt = entry->source->data<format>();
+    mnemonics[name_key(fmt.substr(0, fmt.find('\t')))].push_back(entry->id);
+  }
+  for(const instruction_entry& entry : instruction_entries())
+    formats[name_key(entry.source->data<format>())].push_back(entry.id);
+
+  std::vector<uint16_t> ids;
+  auto write_names = [&](const std::string& name, const std::map<std::string, std::vector<uint16_t>>& names)
+  {
+    std::cout << "constexpr std::array<hashed_name, " << names.size() << "> " << name << "_list =\n{{\n";
+    for(const auto& n : names)
+    {
+      std::cout << "  { \"" << n.first << "\", " << ids.size() << ", " << n.second.size() << " },\n";
+      ids.insert(ids.end(), n.second.begin(), n.second.end());
+    }
+    std::cout << "}};\n\n"
+              << "inline constexpr name_hash_table<" << names.size() << "> " << name << "(" << name << "_list);\n\n";
+  };
+
+  std::cout << "// generated by sh_gen names from the SuperH instruction database, \"make names\"\n"
+            << "// after changing it.\n\n"
+            << "#ifndef INSTRUCTION_NAMES_H\n"
+            << "#define INSTRUCTION_NAMES_H\n\n"
+            << "#include \"name_hash.h\"\n\n"
+            << "// keys are lowercase with single spaces: mnemonics (\"mov.l\", \"dcf psub\") list\n"
+            << "// their forms shortest first, format strings (\"mov.l @(disp,rm),rn\") the\n"
+            << "// instructions written the same way on different variants.\n\n";
+  write_names("instruction_mnemonics", mnemonics);
+  write_names("instruction_formats", formats);
+
+  std::cout << "inline constexpr uint16_t instruction_name_ids[" << ids.size() << "] =\n{";
+  for(std::size_t pos = 0; pos < ids.size(); ++pos)
+    std::cout << (pos % 16 ? " " : "\n  ") << ids[pos] << ",";
+  std::cout << "\n};\n\n"
+            << "// ids of the forms of a mnemonic, none if unknown\n"
+            << "constexpr name_ids find_instruction_mnemonic(std::string_view name)\n"
+            << "{\n"
+            << "  const hashed_name* n = instruction_mnemonics.find(name);\n"
+            << "  return n ? name_ids{ instruction_name_ids + n->first, n->count } : name_ids{};\n"
+            << "}\n\n"
+            << "// ids of the instructions written as 'format', none if unknown\n"
+            << "constexpr name_ids find_instruction_format(std::string_view format)\n"
+            << "{\n"
+            << "  const hashed_name* n = instruction_formats.find(format);\n"
+            << "  return n ? name_ids{ instruction_name_ids + n->first, n->count } : name_ids{};\n"
+            << "}\n\n"
+            << "#endif // INSTRUCTION_NAMES_H\n";
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+// the C of an operation snippet as tokens, enough to find its functions and
+// the names it uses
+struct c_token
+{
+  enum kind_t { identifier, number, literal, punct } kind;
+  std::string text;
+  std::size_t offset; // in the code
+};
+
+std::vector<c_token> tokenize_c(const std::string& code)
+{
+  std::vector<c_token> rval;
+  for(std::size_t pos = 0; pos < code.size(); )
+  {
+    const char c = code[pos];
+    if(std::isspace(uint8_t(c)))
+      ++pos;
+    else if(code.compare(pos, 2, "//") == 0)
+      pos = std::min(code.find('\n', pos), code.size());
+    else if(code.compare(pos, 2, "/*") == 0)
+      pos = std::min(code.find("*/", pos) + 2, code.size());
+    else if(std::isalpha(uint8_t(c)) || c == '_' || std::isdigit(uint8_t(c)))
+    {
+      std::size_t end = pos + 1;
+      while(end < code.size() && (std::isalnum(uint8_t(code[end])) || code[end] == '_' || code[end] == '.'))
+        ++end;
+      const bool number = std::isdigit(uint8_t(c));
+      if(!number)
+        end = std::min(end, code.find('.', pos)); // a member access
+      rval.push_back({ number ? c_token::number : c_token::identifier, code.substr(pos, end - pos), pos });
+      pos = end;
+    }
+    else if(c == '"' || c == '\'')
+    {
+      std::size_t end = pos + 1;
+      while(end < code.size() && code[end] != c)
+        end += code[end] == '\\' ? 2 : 1;
+      rval.push_back({ c_token::literal, code.substr(pos, end + 1 - pos), pos });
+      pos = end + 1;
+    }
+    else
+    {
+      rval.push_back({ c_token::punct, std::string(1, c), pos });
+      ++pos;
+    }
+  }
+  return rval;
+}
+
+// calls each identifier of 'code' outside of comments and literals, and
+// whether a call follows it, and replaces it with the result
+template<typename Func>
+std::string rename_identifiers(const std::string& code, Func rename)
+{
+  std::string rval;
+  for(std::size_t pos = 0; pos < code.size(); )
+  {
+    const char c = code[pos];
+    std::size_t end = pos + 1;
+    if(code.compare(pos, 2, "//") == 0)
+      end = std::min(code.find('\n', pos), code.size());
+    else if(code.compare(pos, 2, "/*") == 0)
+      end = std::min(code.find("*/", pos) + 2, code.size());
+    else if(c == '"' || c == '\'')
+    {
+      while(end < code.size() && code[end] != c)
+        end += code[end] == '\\' ? 2 : 1;
+      ++end;
+    }
+    else if(std::isalnum(uint8_t(c)) || c == '_')
+    {
+      while(end < code.size() && (std::isalnum(uint8_t(code[end])) || code[end] == '_'))
+        ++end;
+      if(!std::isdigit(uint8_t(c)) && (pos == 0 || code[pos - 1] != '.'))
+      {
+        const std::size_t next = code.find_first_not_of(" \t\n", end);
+        rval += rename(code.substr(pos, end - pos), next != std::string::npos && code[next] == '(');
+        pos = end;
+        continue;
+      }
+    }
+    end = std::min(end, code.size());
+    rval.append(code, pos, end - pos);
+    pos = end;
+  }
+  return rval;
+}
+
+struct c_function
+{
+  std::string name;
+  std::vector<std::string> params;
+};
+
+// what an operation snippet defines and what it takes from its surroundings
+struct snippet_analysis
+{
+  std::string code;                 // #if CPU blocks turned into if statements
+  std::vector<std::string> macros;  // #defined by the snippet
+  std::vector<c_function> functions;
+  std::set<std::string> variables;  // free names
+  std::set<std::string> calls;      // free functions
+  std::set<std::string> assigned;   // free names on the left of an assignment
+  std::string problem;              // why the snippet cannot be used as it is
+};
+
+const std::set<std::string>& c_keywords(void)
+{
+  static const std::set<std::string> rval =
+  {
+    "void", "int", "unsigned", "signed", "long", "char", "short", "float", "double", "bool", "const", "static",
+    "volatile", "register", "if", "else", "while", "for", "do", "switch", "case", "default", "break", "return",
+    "continue", "sizeof", "true", "false", "int32_t", "uint32_t", "int64_t", "uint64_t", "constexpr",
+  };
+  return rval;
+}
+
+bool is_c_type(const std::string& word)
+{
+  static const std::set<std::string> types =
+    { "void", "int", "unsigned", "signed", "long", "char", "short", "float", "double", "bool", "const", "static",
+      "volatile", "register", "int32_t", "uint32_t", "int64_t", "uint64_t" };
+  return types.count(word) != 0;
+}
+
+bool is_cpu_name(const std::string& name)
+{
+  return std::any_of(cpu_variants.begin(), cpu_variants.end(), [&](isa cpu) { return name == cpu_name(cpu); });
+}
+
+// "SH1 || SH2" -> "(is_cpu(SH1) || is_cpu(SH2))", variants the database does
+// not know are never true
+std::string cpu_condition(const std::string& expression)
+{
+  return "(" + rename_identifiers(expression, [](const std::string& name, bool)
+  {
+    return is_cpu_name(name) ? "is_cpu(" + name + ")" : "false"s;
+  }) + ")";
+}
+
+snippet_analysis analyze_snippet(const std::string& operation)
+{
+  snippet_analysis rval;
+
+  // preprocessor lines
+  std::istringstream lines(operation);
+  for(std::string line; std::getline(lines, line); )
+  {
+    const std::size_t hash = line.find_first_not_of(" \t");
+    if(hash == std::string::npos || line[hash] != '#')
+    {
+      rval.code += line + "\n";
+      continue;
+    }
+    std::istringstream directive(line.substr(hash + 1));
+    std::string word, rest;
+    directive >> word;
+    std::getline(directive, rest);
+    if(word == "define")
+    {
+      std::istringstream name(rest);
+      rval.macros.emplace_back();
+      name >> rval.macros.back();
+      rval.code += line + "\n";
+    }
+    else if(word == "if")
+      rval.code += "if constexpr" + cpu_condition(rest) + " {\n";
+    else if(word == "elif")
+      rval.code += "} else if constexpr" + cpu_condition(rest) + " {\n";
+    else if(word == "else")
+      rval.code += "} else {\n";
+    else if(word == "endif")
+      rval.code += "}\n";
+    else
+      rval.problem = "#" + word + rest;
+  }
+
+  // long is 32 bits in the manuals, SR.MD and the like become SR_MD
+  static const std::array<std::pair<std::regex, const char*>, 5> types =
+  {{
+    { std::regex("\\bSR\\.(\\w+)"), "SR_$1" },
+    { std::regex("\\bunsigned\\s+long\\s+long\\b"), "uint64_t" },
+    { std::regex("\\b(signed\\s+)?long\\s+long\\b"), "int64_t" },
+    { std::regex("\\bunsigned\\s+long\\b"), "uint32_t" },
+    { std::regex("\\b(signed\\s+)?long\\b"), "int32_t" },
+  }};
+  for(const auto& t : types)
+    rval.code = std::regex_replace(rval.code, t.first, t.second);
+
+  const std::vector<c_token> tokens = tokenize_c(rval.code);
+  auto is = [&](std::size_t pos, const char* text) { return pos < tokens.size() && tokens[pos].text == text; };
+
+  int depth = 0;
+  for(const c_token& t : tokens)
+  {
+    depth += t.text == "(" || t.text == "[" || t.text == "{" ? 1 : t.text == ")" || t.text == "]" || t.text == "}" ? -1 : 0;
+    if(depth < 0)
+      break;
+  }
+  if(depth != 0 && rval.problem.empty())
+    rval.problem = "unbalanced brackets";
+
+  // top level: function definitions only
+  std::set<std::string> locals(rval.macros.begin(), rval.macros.end());
+  locals.insert("is_cpu");
+  std::set<std::string> defined;
+  std::vector<std::pair<std::size_t, std::size_t>> bodies;
+  for(std::size_t pos = 0; pos < tokens.size() && rval.problem.empty(); )
+  {
+    std::size_t open = pos;
+    while(open < tokens.size() && !is(open, "{") && !is(open, ";"))
+      ++open;
+    if(!is(open, "{") || open < pos + 4 || !is(open - 1, ")"))
+    {
+      rval.problem = "not a function definition";
+      break;
+    }
+    std::size_t paren = open - 1;
+    for(int level = 0; ; --paren)
+    {
+      level += is(paren, ")") ? 1 : is(paren, "(") ? -1 : 0;
+      if(!level)
+        break;
+    }
+    c_function f;
+    f.name = tokens[paren - 1].text;
+    for(std::size_t arg = paren + 1; arg < open - 1; ++arg)
+      if(tokens[arg].kind == c_token::identifier && (is(arg + 1, ",") || is(arg + 1, ")")) && tokens[arg].text != "void")
+        f.params.push_back(tokens[arg].text);
+    locals.insert(f.params.begin(), f.params.end());
+    defined.insert(f.name);
+    rval.functions.push_back(f);
+
+    std::size_t close = open;
+    for(int level = 0; ; ++close)
+    {
+      level += is(close, "{") ? 1 : is(close, "}") ? -1 : 0;
+      if(!level)
+        break;
+    }
+    bodies.emplace_back(open + 1, close);
+    pos = close + 1;
+  }
+  if(!rval.problem.empty())
+    return rval;
+
+  // declarations start statements (or the initialization of a for loop).
+  // the variables a body never reads get a (void) after their declaration,
+  // for -Wall
+  std::vector<std::pair<std::size_t, std::string>> unread;
+  for(const auto& body : bodies)
+    for(std::size_t pos = body.first; pos < body.second; ++pos)
+    {
+      const bool in_for = is(pos - 1, "(") && is(pos - 2, "for");
+      const bool start = is(pos - 1, ";") || is(pos - 1, "{") || is(pos - 1, "}") || in_for;
+      if(!start || !is_c_type(tokens[pos].text))
+        continue;
+      while(pos < body.second && is_c_type(tokens[pos].text))
+        ++pos;
+      std::vector<std::size_t> names;
+      for(;;)
+      {
+        while(is(pos, "*"))
+          ++pos;
+        if(pos < body.second && tokens[pos].kind == c_token::identifier)
+        {
+          locals.insert(tokens[pos].text);
+          names.push_back(pos);
+        }
+        for(int level = 0; pos < body.second; ++pos)
+        {
+          level += is(pos, "(") || is(pos, "[") || is(pos, "{") ? 1 : is(pos, ")") || is(pos, "]") || is(pos, "}") ? -1 : 0;
+          if(level == 0 && (is(pos, ",") || is(pos, ";")))
+            break;
+        }
+        if(!is(pos, ","))
+          break;
+        ++pos;
+      }
+      if(in_for || !is(pos, ";"))
+        continue;
+
+      // read: anything but the declaration and the left side of a plain
+      // assignment
+      for(const std::size_t name : names)
+      {
+        bool read = false;
+        for(std::size_t use = body.first; use < body.second && !read; ++use)
+          read = use != name && tokens[use].text == tokens[name].text && !(is(use + 1, "=") && !is(use + 2, "="));
+        if(!read)
+          unread.emplace_back(tokens[pos].offset + 1, tokens[name].text);
+      }
+    }
+
+  for(std::size_t pos = 0; pos < tokens.size(); ++pos)
+  {
+    const std::string& name = tokens[pos].text;
+    if(tokens[pos].kind != c_token::identifier || c_keywords().count(name) || locals.count(name) || defined.count(name))
+      continue;
+    if((pos > 0 && is(pos - 1, ".")) || is_cpu_name(name))
+      continue;
+    (is(pos + 1, "(") ? rval.calls : rval.variables).insert(name);
+
+    // name = ..., name += ..., name <<= ..., but not name == ...
+    std::size_t op = pos + 1;
+    if((is(op, "<") && is(op + 1, "<")) || (is(op, ">") && is(op + 1, ">")))
+      op += 2;
+    else if(is(op, "+") || is(op, "-") || is(op, "*") || is(op, "/") || is(op, "%") || is(op, "&") || is(op, "|") ||
+            is(op, "^"))
+      ++op;
+    if(is(op, "=") && !is(op + 1, "="))
+      rval.assigned.insert(name);
+  }
+
+  for(auto u = unread.rbegin(); u != unread.rend(); ++u)
+    rval.code.insert(u->first, " (void)" + u->second + ";");
+  return rval;
+}
+
+// state and functions of the interpreter runtime the snippets may use
+const std::set<std::string>& interpreter_variables(void)
+{
+  static const std::set<std::string> rval =
+  {
+    "R", "R0", "R15", "PC", "T", "Q", "M", "S", "SR", "SR_MD", "SR_RB", "SR_BL", "MACH", "MACL", "GBR", "VBR", "PR",
+    "SSR", "SPC", "SGR", "DBR", "TBR", "FPUL", "FPSCR", "TRA", "EXPEVT", "FR", "XF", "DR", "XD", "FPSCR_PR",
+    "FPSCR_SZ", "A0", "A0G", "X0", "X1", "Y0", "Y1", "DSR", "MOD", "RS", "RE",
+  };
+  return rval;
+}
+
+const std::set<std::string>& interpreter_functions(void)
+{
+  static const std::set<std::string> rval =
+  {
+    "Read_8", "Read_16", "Read_32", "Write_8", "Write_16", "Write_32", "Read_Unaligned_32", "Delay_Slot",
+    "Sleep_standby", "invalidate_instruction_cache_block", "Read_64", "Write_64", "undefined_operation",
+  };
+  return rval;
+}
+
+// operations of the core written by hand, by the entry function of their
+// snippet: the SH4 vector instructions, whose snippets rely on helpers of the
+// manual, run on the kernels of fpu_kernels.h, and setrc sets the repeat
+// flags of SR from RS and RE
+const std::set<std::string>& interpreter_natives(void)
+{
+  static const std::set<std::string> rval = { "FIPR", "FTRV", "FSCA", "FSRRA", "SETRC", "SETRCI" };
+  return rval;
+}
+
+// the operand field 'letter' of 'id': its position in the operand extractor
+// and how it comes out of the instruction word.  the fields of register
+// pairs and vectors (DRn, XDn, FVn) hold the number of the first register
+// over 2 or 4, the snippets take the register number.
+std::string field_expression(uint16_t id, char letter)
+{
+  const std::string text = instruction_entries()[id].source->data<format>();
+  const std::regex pair("\\b(DR|XD)"s + letter + "\\b");
+  const std::regex vector("\\bFV"s + letter + "\\b");
+  const int scale_bits = std::regex_search(text, pair) ? 1 : std::regex_search(text, vector) ? 2 : 0;
+
+  const operand_extractor& extractor = operand_extractors()[id];
+  for(std::size_t pos = 0; pos < extractor.count; ++pos)
+    if(extractor.letter[pos] == letter)
+    {
+      std::ostringstream out;
+      out << (scale_bits ? "(" : "") << "SH_ARG(" << pos << std::hex << std::uppercase << ", SH_FIELD(0x"
+          << extractor.low_mask[pos] << ", " << std::dec << int(extractor.low_shift[pos]) << ")";
+      if(extractor.high_mask[pos])
+        out << std::hex << " | SH_FIELD(0x" << extractor.high_mask[pos] << ", " << std::dec
+            << int(extractor.high_shift[pos]) << ")";
+      out << ")";
+      if(scale_bits)
+        out << " << " << scale_bits << ")";
+      return out.str();
+    }
+  return {};
+}
+
+// "a == b" as the call of the core's T bit that sets T to 'value' when
+// the condition holds and to the other value when not, "T.equal(a, b)".  empty
+// when the condition is not a single comparison.
+std::string t_bit_call(const std::string& condition, bool value)
+{
+  std::size_t op = std::string::npos;
+  std::size_t op_size = 0;
+  int depth = 0;
+  for(std::size_t pos = 0; pos < condition.size(); ++pos)
+  {
+    const char c = condition[pos];
+    const char next = pos + 1 < condition.size() ? condition[pos + 1] : 0;
+    depth += c == '(' || c == '[' ? 1 : c == ')' || c == ']' ? -1 : 0;
+    if(depth)
+      continue;
+    if(c == '?' || (c == '&' && next == '&') || (c == '|' && next == '|'))
+      return {};
+    if((c == '<' || c == '>') && next == c)
+    {
+      ++pos; // a shift
+      continue;
+    }
+    std::size_t size = 0;
+    if((c == '=' || c == '!' || c == '<' || c == '>') && next == '=')
+      size = 2;
+    else if((c == '<' || c == '>') && (pos == 0 || condition[pos - 1] != '-'))
+      size = 1;
+    if(!size)
+      continue;
+    if(op != std::string::npos)
+      return {};
+    op = pos;
+    op_size = size;
+    ++pos;
+  }
+  if(op == std::string::npos)
+    return {};
+
+  auto trim = [](const std::string& text)
+  {
+    const std::size_t first = text.find_first_not_of(" \t");
+    return text.substr(first, text.find_last_not_of(" \t") + 1 - first);
+  };
+  const std::string a = trim(condition.substr(0, op));
+  const std::string b = trim(condition.substr(op + op_size));
+  std::string cmp = condition.substr(op, op_size);
+  if(a.empty() || b.empty())
+    return {};
+
+  // the condition that sets T to 1
+  if(!value)
+    cmp = cmp == "==" ? "!=" : cmp == "!=" ? "==" : cmp == ">=" ? "<" : cmp == ">" ? "<=" : cmp == "<=" ? ">" : ">=";
+  if(cmp == "==")
+    return "T.equal(" + a + ", " + b + ");";
+  if(cmp == "!=")
+    return "T.not_equal(" + a + ", " + b + ");";
+  if(cmp == ">=" || cmp == ">")
+    return "T.greater" + std::string(cmp == ">=" ? "_equal" : "") + "(" + a + ", " + b + ");";
+  return "T.greater" + std::string(cmp == "<=" ? "_equal" : "") + "(" + b + ", " + a + ");";
+}
+
+// the snippets of the instructions whose flags take T from a comparison
+// ("Result -> T", "MSB -> T", "LSB -> T") set it through the T bit of the
+// core: "if (a OP b) T = 1; else T = 0;" becomes a call without the branch
+std::string compare_to_t(const std::string& code, const std::string& flags)
+{
+  if(flags != "Result -> T" && flags != "MSB -> T" && flags != "LSB -> T")
+    return code;
+
+  static const std::regex assignment("if\\s*\\((.*)\\)\\s*T\\s*=\\s*([01])\\s*;\\s*else\\s*T\\s*=\\s*([01])\\s*;");
+  std::string rval;
+  auto last = code.cbegin();
+  for(std::sregex_iterator i(code.begin(), code.end(), assignment), end; i != end; ++i)
+  {
+    const std::smatch& m = *i;
+    const std::string call = m[2] != m[3] ? t_bit_call(m[1], m[2] == "1") : ""s;
+    rval.append(last, m[0].first);
+    rval += call.empty() ? m[0].str() : call;
+    last = m[0].second;
+  }
+  rval.append(last, code.cend());
+  return rval;
+}
+
+// a member function made from an operation snippet, shared by the
+// instructions with the same snippet
+struct interpreter_handler
+{
+  std::string function;
+  std::vector<std::string> params; // operand letters
+  bool switches_fpu_mode = false;  // assigns FPSCR or runs a delay slot that may
+  bool changes_repeat = false;     // assigns SR, RS or RE
+  std::string problem;             // no handler
+};
+
+interpreter_handler make_handler(uint16_t id, const std::string& operation, std::ostream& out)
+{
+  interpreter_handler rval;
+  if(operation.find_first_not_of(" \t\n") == std::string::npos)
+  {
+    rval.problem = "no operation";
+    return rval;
+  }
+
+  const snippet_analysis snippet = analyze_snippet(operation);
+
+  // the entry is the last function that no other one calls
+  const c_function* main = nullptr;
+  for(const c_function& f : snippet.functions)
+  {
+    const std::regex use("\\b" + f.name + "\\s*\\(");
+    if(std::distance(std::sregex_iterator(operation.begin(), operation.end(), use), std::sregex_iterator()) == 1)
+      main = &f;
+  }
+
+  // the core has its own version of some, the rest of the snippet is not used
+  const bool native = main && interpreter_natives().count(main->name);
+  if(!native)
+  {
+    rval.problem = snippet.problem;
+    for(const std::string& name : snippet.variables)
+      if(rval.problem.empty() && !interpreter_variables().count(name))
+        rval.problem = "uses " + name;
+    for(const std::string& name : snippet.calls)
+      if(rval.problem.empty() && !interpreter_functions().count(name))
+        rval.problem = "calls " + name + "()";
+  }
+  if(rval.problem.empty() && !main)
+    rval.problem = "no entry function";
+  if(!rval.problem.empty())
+    return rval;
+
+  for(const std::string& param : main->params)
+    if(rval.problem.empty() && (param.size() != 1 || field_expression(id, param[0]).empty()))
+      rval.problem = "parameter " + param + " is not an operand";
+  if(!rval.problem.empty())
+    return rval;
+
+  rval.changes_repeat = snippet.assigned.count("SR") || snippet.assigned.count("RS") || snippet.assigned.count("RE");
+  if(native)
+  {
+    rval.function = "native_" + main->name;
+    rval.params = main->params;
+    return rval;
+  }
+
+  const std::string prefix = "op_" + std::to_string(id) + "_";
+  rval.function = prefix + main->name;
+  rval.params = main->params;
+  rval.switches_fpu_mode = snippet.assigned.count("FPSCR") || snippet.calls.count("Delay_Slot");
+
+  std::set<std::string> names;
+  for(const c_function& f : snippet.functions)
+    names.insert(f.name);
+  out << "// " << id << ": " << format_of(id) << "\n"
+      << rename_identifiers(compare_to_t(snippet.code, instruction_entries()[id].source->data<flags>()),
+                            [&](const std::string& name, bool call)
+         {
+           if(call && names.count(name))
+             return prefix + name;
+           if(name == "R0" || name == "R15")
+             return "R[" + name.substr(1) + "]";
+           return name;
+         });
+  for(const std::string& macro : snippet.macros)
+    out << "#undef " << macro << "\n";
+  out << "\n";
+  return rval;
+}
+
+int gen_interpreter(const gen_options&)
+{
+  std::ostringstream operations;
+  std::ostringstream dispatch;
+  std::ostringstream fpu_mode;
+  std::ostringstream repeat_control;
+  std::map<std::string, interpreter_handler> handlers; // by operation text
+  std::size_t handled = 0;
+
+  for(const instruction_entry& entry : instruction_entries())
+  {
+    std::ostringstream sets;
+    sets << "0x" << std::hex << std::setw(4) << std::setfill('0') << uint16_t(std::get<isa>(entry.source->details));
+
+    // the DSP unit decodes the transfers and operations itself
+    if(std::string(entry.section->section_title).compare(0, 4, "DSP ") == 0)
+    {
+      dispatch << "SH_HANDLER(" << entry.id << ", " << sets.str() << ", native_DSP(SH_WORD))\n";
+      ++handled;
+      continue;
+    }
+
+    const std::string& operation = entry.source->data<::operation>();
+    auto known = handlers.find(operation);
+    if(known == handlers.end())
+      known = handlers.emplace(operation, make_handler(entry.id, operation, operations)).first;
+    const interpreter_handler& h = known->second;
+
+    std::string problem = h.problem;
+    std::string args;
+    for(const std::string& param : h.params)
+    {
+      const std::string field = field_expression(entry.id, param[0]);
+      if(field.empty() && problem.empty())
+        problem = "parameter " + param + " is not an operand";
+      args += (args.empty() ? "" : ", ") + field;
+    }
+
+    if(problem.empty())
+    {
+      dispatch << "SH_HANDLER(" << entry.id << ", " << sets.str() << ", " << h.function << "(" << args << "))\n";
+      if(h.switches_fpu_mode)
+        fpu_mode << "SH_FPU_MODE_SWITCH(" << entry.id << ")\n";
+      if(h.changes_repeat)
+        repeat_control << "SH_REPEAT_CHANGE(" << entry.id << ")\n";
+      ++handled;
+    }
+    else
+      dispatch << "SH_UNIMPLEMENTED(" << entry.id << ", " << sets.str() << ") // " << problem << "\n";
+  }
+
+  std::cout << "// generated by sh_gen interpreter from the operation snippets of the SuperH\n"
+            << "// instruction database.\n"
+            << "// " << handled << " of " << instruction_entries().size() << " instructions have a handler.\n\n"
+            << "// the operations, member functions of the interpreter core\n"
+            << "#ifdef SH_OPERATIONS\n\n"
+            << operations.str()
+            << "#endif // SH_OPERATIONS\n\n"
+            << "// every instruction id in order with its instruction sets: SH_HANDLER(id, sets,\n"
+            << "// call) or SH_UNIMPLEMENTED(id, sets).  the arguments of the calls are the\n"
+            << "// operand fields as SH_ARG(position in the operand extractor, expression of the\n"
+            << "// instruction word with SH_FIELD(mask, shift)).  the DSP instructions call\n"
+            << "// native_DSP with the instruction word, SH_WORD\n"
+            << "#ifdef SH_DISPATCH\n\n"
+            << dispatch.str()
+            << "\n#endif // SH_DISPATCH\n\n"
+            << "// the handlers after which FPSCR.PR, FPSCR.SZ and FPSCR.FR may have changed:\n"
+            << "// those that assign FPSCR and the delayed branches, for their slot\n"
+            << "#ifdef SH_FPU_MODE\n\n"
+            << fpu_mode.str()
+            << "\n#endif // SH_FPU_MODE\n\n"
+            << "// the handlers after which a repeat loop (SH-DSP) may have started, ended or\n"
+            << "// moved: those that assign SR, RS or RE\n"
+            << "#ifdef SH_REPEAT_CONTROL\n\n"
+            << repeat_control.str()
+            << "\n#endif // SH_REPEAT_CONTROL\n";
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argc, char* argv[])
+{
+  try
+  {
+    if(argc < 2)
+      throw("usage: sh_gen coverage|illegal|compact|opcodes|schedule|names|interpreter [--cpu NAME] [--ranges] [--overlaps]"s);
+
+    std::string mode = argv[1];
+    gen_options options;
+    for(int arg = 2; arg < argc; ++arg)
+    {
+      std::string opt = argv[arg];
+      if(opt == "--ranges")
+        options.ranges = true;
+      else if(opt == "--overlaps")
+        options.overlaps = true;
+      else if(arg + 1 >= argc)
+        throw("missing value for: "s + opt);
+      else if(opt == "--cpu")
+      {
+        options.cpu = parse_cpu_name(argv[++arg]);
+        if(options.cpu == SH_NONE)
+          throw("unknown cpu: "s + argv[arg]);
+      }
+      else
+        throw("unknown option: "s + opt);
+    }
+
+    if(mode == "coverage")
+      return gen_coverage(options);
+    if(mode == "illegal")
+      return gen_illegal(options);
+    if(mode == "compact")
+      return gen_compact(options);
+    if(mode == "opcodes")
+      return gen_opcodes(options);
+    if(mode == "schedule")
+      return gen_schedule(options);
+    if(mode == "names")
+      return gen_names(options);
+    if(mode == "interpreter")
+      return gen_interpreter(options);
+    throw("unknown mode: "s + mode);
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+  }
+  return 1;
+}
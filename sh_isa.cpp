@@ -0,0 +1,183 @@
+/*
+sh_isa - finds the CPU variants that can execute SuperH binaries
+
+Usage: sh_isa [--little-endian] [--threads N] [--verbose] PATH...
+
+Every file (directories are searched recursively) is decoded as raw code with
+the instructions of all CPU variants.  The variants that know every decoded
+instruction are reported, with the first instruction that rules out the
+others ("SH2A (not SH2E: movi20 #imm20,Rn at 0x00001234)").  Halfwords no
+variant decodes are taken as data.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "isa_detector.h"
+#include "mapped_file.h"
+
+using namespace std::literals::string_literals;
+
+// ----------------------------------------------------------------------------
+
+struct isa_options
+{
+  bool little_endian = false;
+  bool verbose = false;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> paths;
+};
+
+std::string describe(const isa_exclusion& exclusion)
+{
+  std::string fmt = instruction_entries()[exclusion.id].source->data<format>();
+  std::replace(fmt.begin(), fmt.end(), '\t', ' ');
+  std::replace(fmt.begin(), fmt.end(), '\n', '|');
+
+  std::ostringstream rval;
+  rval << "not " << cpu_name(exclusion.cpu) << ": " << fmt << " at 0x"
+       << std::hex << std::setfill('0') << std::setw(8) << exclusion.offset;
+  return rval.str();
+}
+
+std::string scan_file(const isa_detector& detector, const std::string& path, const isa_options& options)
+{
+  const mapped_file file(path);
+  const uint8_t* bytes = file.data();
+  std::vector<uint16_t> words(file.size() / 2);
+  for(std::size_t pos = 0; pos < words.size(); ++pos)
+    words[pos] = options.little_endian ? uint16_t(bytes[pos * 2] | (bytes[pos * 2 + 1] << 8))
+                                       : uint16_t((bytes[pos * 2] << 8) | bytes[pos * 2 + 1]);
+
+  const isa_scan scan = detector.scan(words.data(), words.size());
+  const isa minimum = scan.minimum();
+
+  std::string rval = path + ": ";
+  if(minimum == SH_NONE)
+    rval += "no single CPU variant";
+  else
+  {
+    rval += cpu_name(minimum);
+
+    // the reason the variant listed just before the minimum is ruled out
+    const auto pos = std::find(cpu_variants.begin(), cpu_variants.end(), minimum);
+    const isa_exclusion* reason = nullptr;
+    for(const isa_exclusion& e : scan.excluded)
+    {
+      const auto index = std::find(cpu_variants.begin(), cpu_variants.end(), e.cpu);
+      if(index < pos && (!reason || index > std::find(cpu_variants.begin(), cpu_variants.end(), reason->cpu)))
+        reason = &e;
+    }
+    if(reason)
+      rval += " (" + describe(*reason) + ")";
+  }
+  rval += '\n';
+
+  if(options.verbose)
+  {
+    rval += "  runs on:      " + cpu_set_names(scan.cpus) + "\n";
+    rval += "  instructions: " + std::to_string(scan.instructions) + ", "
+          + std::to_string(scan.unknown) + " unknown halfwords\n";
+    for(const isa_exclusion& e : scan.excluded)
+      rval += "  " + describe(e) + "\n";
+  }
+  return rval;
+}
+
+void collect_files(const std::string& path, std::vector<std::string>& files)
+{
+  namespace fs = std::filesystem;
+  if(!fs::is_directory(path))
+  {
+    files.push_back(path);
+    return;
+  }
+
+  std::vector<std::string> found;
+  for(const fs::directory_entry& entry : fs::recursive_directory_iterator(path))
+    if(entry.is_regular_file())
+      found.push_back(entry.path().string());
+  std::sort(found.begin(), found.end());
+  files.insert(files.end(), found.begin(), found.end());
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argc, char* argv[])
+{
+  try
+  {
+    isa_options options;
+    for(int arg = 1; arg < argc; ++arg)
+    {
+      std::string opt = argv[arg];
+      if(opt == "--little-endian")
+        options.little_endian = true;
+      else if(opt == "--verbose")
+        options.verbose = true;
+      else if(opt.empty() || opt[0] != '-')
+        options.paths.push_back(opt);
+      else if(arg + 1 >= argc)
+        throw("missing value for: "s + opt);
+      else if(opt == "--threads")
+        options.threads = std::max(1u, unsigned(std::stoul(argv[++arg])));
+      else
+        throw("unknown option: "s + opt);
+    }
+
+    if(options.paths.empty())
+      throw("usage: sh_isa [--little-endian] [--threads N] [--verbose] PATH..."s);
+
+    std::vector<std::string> files;
+    for(const std::string& path : options.paths)
+      collect_files(path, files);
+
+    const isa_detector detector;
+    std::vector<std::string> reports(files.size());
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+
+    auto worker = [&]
+    {
+      for(std::size_t n = next++; n < files.size(); n = next++)
+      {
+        try
+        {
+          reports[n] = scan_file(detector, files[n], options);
+        }
+        catch(const std::string& message)
+        {
+          reports[n] = files[n] + ": " + message + "\n";
+          failed = true;
+        }
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < std::min<std::size_t>(options.threads, files.size()); ++t)
+      pool.emplace_back(worker);
+    worker();
+    for(std::thread& t : pool)
+      t.join();
+
+    for(const std::string& report : reports)
+      std::cout << report;
+    return failed ? 1 : 0;
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 1;
+}
@@ -0,0 +1,193 @@
+/*
+sh_run - runs a raw SuperH image on the interpreter made from the instruction database
+
+Usage: sh_run [--cpu NAME] [--base ADDRESS] [--entry ADDRESS] [--memory KB] [--count N]
+              [--dispatch threaded|switch|blocks|jit] IMAGE
+
+The image is loaded at --base (0 by default) into a memory block of --memory
+KB (16 MB by default, at least the image).  Execution starts at --entry (the
+base by default) with R15 at the end of the memory and SR and FPSCR as after
+a reset, and stops at a sleep instruction, after --count instructions, or at
+an illegal or unimplemented instruction or a memory fault.  The registers (and
+the FPU registers of the FPU variants, the DSP registers of the DSP variants),
+the number of instructions and the rate are printed at the end.
+
+The instructions run the operation snippets of the database (sh_gen
+interpreter), dispatched through computed gotos, a switch, or from the
+predecoded basic blocks of the block cache.  jit dispatch also translates the
+hot blocks of SH1/SH2 integer code to x86-64.  Floating-point instructions
+decode in the mode of FPSCR.PR and FPSCR.SZ, from a table per mode.  DSP
+instructions run on the DSP unit, and SETRC repeat loops are supported.  The
+block cache runs div0u/div1 divisions and mac chains at once.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "interpreter.h"
+#include "mapped_file.h"
+
+using namespace std::literals::string_literals;
+
+// ----------------------------------------------------------------------------
+
+struct run_options
+{
+  isa cpu = SH2;
+  uint32_t base = 0;
+  uint32_t entry = 0;
+  bool has_entry = false;
+  std::size_t memory = 16 << 20; // bytes
+  uint64_t count = ~uint64_t(0);
+  interpreter::dispatch_mode dispatch = interpreter::threaded;
+  std::string input;
+};
+
+void print_registers(const cpu_state& s, bool fpu, bool dsp)
+{
+  std::cout << std::hex << std::setfill('0');
+  for(std::size_t n = 0; n < s.R.size(); ++n)
+    std::cout << "r" << std::dec << n << (n < 10 ? "   " : "  ") << std::hex << std::setw(8) << s.R[n]
+              << (n % 4 == 3 ? "\n" : "  ");
+  std::cout << "pc   " << std::setw(8) << s.PC << "  pr   " << std::setw(8) << s.PR
+            << "  sr   " << std::setw(8) << s.SR << "  gbr  " << std::setw(8) << s.GBR << "\n"
+            << "mach " << std::setw(8) << s.MACH << "  macl " << std::setw(8) << s.MACL
+            << "  vbr  " << std::setw(8) << s.VBR << "\n";
+  if(fpu)
+  {
+    std::cout << "fpul " << std::setw(8) << s.FPUL << "  fpscr " << std::setw(8) << s.FPSCR << "\n";
+    // the bank of FPSCR.FR first
+    const std::size_t fr = (s.FPSCR >> 21 & 1) * 16;
+    for(std::size_t n = 0; n < s.FPR.size(); ++n)
+      std::cout << (n < 16 ? "fr" : "xf") << std::dec << n % 16 << (n % 16 < 10 ? "  " : " ") << std::hex
+                << std::setw(8) << s.FPR[(fr + n) % 32] << (n % 4 == 3 ? "\n" : "  ");
+  }
+  if(dsp)
+  {
+    // the guard bits as the low byte of A0G and A1G
+    std::cout << "a0g  " << std::setw(2) << (s.A0G & 0xFF) << "        a0   " << std::setw(8) << s.A0
+              << "  a1g  " << std::setw(2) << (s.A1G & 0xFF) << "        a1   " << std::setw(8) << s.A1 << "\n"
+              << "m0   " << std::setw(8) << s.M0 << "  m1   " << std::setw(8) << s.M1
+              << "  x0   " << std::setw(8) << s.X0 << "  x1   " << std::setw(8) << s.X1 << "\n"
+              << "y0   " << std::setw(8) << s.Y0 << "  y1   " << std::setw(8) << s.Y1
+              << "  dsr  " << std::setw(8) << s.DSR << "  mod  " << std::setw(8) << s.MOD << "\n"
+              << "rs   " << std::setw(8) << s.RS << "  re   " << std::setw(8) << s.RE << "\n";
+  }
+  std::cout << std::dec << std::setfill(' ');
+}
+
+int run(const run_options& options)
+{
+  mapped_file image(options.input);
+  guest_memory memory(options.base, std::max(options.memory, image.size()));
+  if(image.size())
+    std::memcpy(memory.data(), image.data(), image.size());
+
+  interpreter cpu(options.cpu, memory);
+  cpu_state& s = cpu.state();
+  s.PC = options.has_entry ? options.entry : options.base;
+  s.R[15] = (options.base & 0xE0000000) + memory.base() + uint32_t(memory.size());
+  // interrupts masked, SH3 and SH4 in privileged mode with the exceptions blocked
+  s.SR = cpu_instruction_sets(options.cpu) & (SH3 | SH3_FPU | SH3_DSP | SH4 | SH4A) ? 0x700000F0 : 0x000000F0;
+  // denormals as zero, round to zero
+  const bool fpu = cpu_instruction_sets(options.cpu) & (SH2E | SH2A_FPU | SH3_FPU | SH4 | SH4A);
+  const bool dsp = cpu_instruction_sets(options.cpu) & (SH1_DSP | SH2_DSP | SH3_DSP);
+  if(cpu_instruction_sets(options.cpu) & (SH2A_FPU | SH4 | SH4A))
+    s.FPSCR = 0x00040001;
+
+  int rval = 0;
+  uint64_t executed = 0;
+  const auto start = std::chrono::steady_clock::now();
+  try
+  {
+    executed = cpu.run(options.count, options.dispatch);
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+    rval = 1;
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  print_registers(s, fpu, dsp);
+  std::cout << (cpu.sleeping() ? "sleeping, " : "") << executed << " instructions in " << std::fixed
+            << std::setprecision(3) << seconds << " s";
+  if(seconds > 0 && executed)
+    std::cout << " (" << std::setprecision(1) << executed / seconds / 1e6 << " MIPS)";
+  std::cout << std::endl;
+  return rval;
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argc, char* argv[])
+{
+  try
+  {
+    const std::string usage = "usage: sh_run [--cpu NAME] [--base ADDRESS] [--entry ADDRESS] [--memory KB] "
+                              "[--count N] [--dispatch threaded|switch|blocks|jit] IMAGE";
+    run_options options;
+    for(int arg = 1; arg < argc; ++arg)
+    {
+      std::string opt = argv[arg];
+      if(opt.empty() || opt[0] != '-')
+      {
+        if(!options.input.empty())
+          throw(usage);
+        options.input = opt;
+      }
+      else if(arg + 1 >= argc)
+        throw("missing value for: "s + opt);
+      else if(opt == "--cpu")
+      {
+        options.cpu = parse_cpu_name(argv[++arg]);
+        if(options.cpu == SH_NONE)
+          throw("unknown cpu: "s + argv[arg]);
+      }
+      else if(opt == "--base")
+        options.base = uint32_t(std::stoul(argv[++arg], nullptr, 0));
+      else if(opt == "--entry")
+      {
+        options.entry = uint32_t(std::stoul(argv[++arg], nullptr, 0));
+        options.has_entry = true;
+      }
+      else if(opt == "--memory")
+        options.memory = std::max<std::size_t>(1, std::stoul(argv[++arg])) << 10;
+      else if(opt == "--count")
+        options.count = std::stoull(argv[++arg]);
+      else if(opt == "--dispatch")
+      {
+        const std::string mode = argv[++arg];
+        if(mode == "threaded")
+          options.dispatch = interpreter::threaded;
+        else if(mode == "switch")
+          options.dispatch = interpreter::switched;
+        else if(mode == "blocks")
+          options.dispatch = interpreter::blocks;
+        else if(mode == "jit")
+          options.dispatch = interpreter::jit;
+        else
+          throw("unknown dispatch: "s + mode);
+      }
+      else
+        throw("unknown option: "s + opt);
+    }
+
+    if(options.input.empty())
+      throw(usage);
+    return run(options);
+  }
+  catch(const std::string& message)
+  {
+    std::cerr << message << std::endl;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 1;
+}
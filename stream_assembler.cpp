@@ -0,0 +1,370 @@
+#include "stream_assembler.h"
+#include "asm_lexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std::literals::string_literals;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+  // hands out the lines of a file descriptor from a fixed buffer
+  class line_reader
+  {
+  public:
+    line_reader(int descriptor, std::size_t size) : fd(descriptor), buffer(size) { }
+
+    bool next(std::string_view& line)
+    {
+      for(;;)
+      {
+        const char* start = buffer.data() + begin;
+        const void* eol = std::memchr(buffer.data() + scanned, '\n', end - scanned);
+        if(eol)
+        {
+          line = std::string_view(start, std::size_t(static_cast<const char*>(eol) - start));
+          begin += line.size() + 1;
+          scanned = begin;
+          return true;
+        }
+        if(eof)
+        {
+          if(begin == end)
+            return false;
+          line = std::string_view(start, end - begin); // no newline at the end of the file
+          begin = scanned = end;
+          return true;
+        }
+
+        // keep the partial line and refill the rest of the buffer
+        std::memmove(buffer.data(), start, end - begin);
+        end -= begin;
+        scanned = end;
+        begin = 0;
+        if(end == buffer.size())
+          throw("line longer than the input buffer"s);
+
+        ssize_t count;
+        do
+          count = ::read(fd, buffer.data() + end, buffer.size() - end);
+        while(count < 0 && errno == EINTR);
+        if(count < 0)
+          throw("read failed: "s + std::strerror(errno));
+        eof = count == 0;
+        end += std::size_t(count);
+        total += std::size_t(count);
+      }
+    }
+
+    std::size_t bytes_read(void) const { return total; }
+
+  private:
+    int fd;
+    std::vector<char> buffer;
+    std::size_t begin = 0;   // of the next line
+    std::size_t scanned = 0; // searched for a newline up to here
+    std::size_t end = 0;
+    std::size_t total = 0;
+    bool eof = false;
+  };
+
+  // buffered output that can patch bytes it has written
+  class object_writer
+  {
+  public:
+    object_writer(int descriptor, std::size_t size)
+      : fd(descriptor), buffer(size), origin(::lseek(descriptor, 0, SEEK_CUR)) { }
+
+    uint64_t offset(void) const { return flushed + used; }
+
+    void put(const uint8_t* bytes, std::size_t count)
+    {
+      for(std::size_t n = 0; n < count; ++n)
+      {
+        if(used == buffer.size())
+          flush();
+        buffer[used++] = bytes[n];
+      }
+    }
+
+    // bytes still in the buffer are patched in place, the others in the file
+    void patch(uint64_t at, const uint8_t* bytes, std::size_t count)
+    {
+      for(std::size_t n = 0; n < count; ++n, ++at)
+      {
+        if(at >= flushed)
+          buffer[std::size_t(at - flushed)] = bytes[n];
+        else if(origin < 0)
+          throw("forward reference out of the output buffer on an output that is not seekable"s);
+        else if(::pwrite(fd, bytes + n, 1, off_t(uint64_t(origin) + at)) != 1)
+          throw("write failed: "s + std::strerror(errno));
+      }
+    }
+
+    void flush(void)
+    {
+      for(std::size_t pos = 0; pos < used; )
+      {
+        const ssize_t count = ::write(fd, buffer.data() + pos, used - pos);
+        if(count < 0 && errno == EINTR)
+          continue;
+        if(count <= 0)
+          throw("write failed: "s + std::strerror(errno));
+        pos += std::size_t(count);
+      }
+      flushed += used;
+      used = 0;
+    }
+
+  private:
+    int fd;
+    std::vector<uint8_t> buffer;
+    std::size_t used = 0;
+    uint64_t flushed = 0;
+    off_t origin; // file position of the first byte, -1 for pipes
+  };
+
+  struct pending_fixup
+  {
+    std::size_t line;
+    uint64_t offset; // in the output
+    uint32_t address;
+    assembled_instruction insn;
+    bool data; // .long of a label
+  };
+
+  std::string_view trim(std::string_view text)
+  {
+    const std::size_t start = text.find_first_not_of(" \t\r");
+    if(start == std::string_view::npos)
+      return {};
+    return text.substr(start, text.find_last_not_of(" \t\r") + 1 - start);
+  }
+
+  class source_assembler
+  {
+  public:
+    source_assembler(const assembler& a, const stream_options& opts, object_writer& out)
+      : as(a), options(opts), writer(out) { }
+
+    void line(std::string_view text, std::size_t number);
+    void resolve(const std::string& name, std::ostream& log, stream_stats& stats);
+
+  private:
+    uint32_t address(void) const { return options.base + uint32_t(writer.offset()); }
+    uint32_t value_of(std::string_view text, bool& resolved) const;
+    void put(uint32_t value, std::size_t size);
+    void put_instruction(uint32_t word, std::size_t size);
+    void encode(uint8_t* out, uint32_t value, std::size_t size) const;
+    void encode_instruction(uint8_t* out, uint32_t word, std::size_t size) const;
+    void directive(std::string_view name, std::string_view operands, std::size_t number);
+
+    const assembler& as;
+    const stream_options& options;
+    object_writer& writer;
+    symbol_table symbols;
+    std::vector<pending_fixup> fixups;
+  };
+
+  void source_assembler::encode(uint8_t* out, uint32_t value, std::size_t size) const
+  {
+    for(std::size_t n = 0; n < size; ++n)
+      out[n] = uint8_t(value >> ((options.little_endian ? n : size - 1 - n) * 8));
+  }
+
+  // instructions are stored in halfwords, the first one at the lower address
+  void source_assembler::encode_instruction(uint8_t* out, uint32_t word, std::size_t size) const
+  {
+    if(size == 4)
+      encode(out, word >> 16, 2);
+    encode(out + size - 2, word & 0xFFFF, 2);
+  }
+
+  void source_assembler::put(uint32_t value, std::size_t size)
+  {
+    uint8_t bytes[4];
+    encode(bytes, value, size);
+    writer.put(bytes, size);
+  }
+
+  void source_assembler::put_instruction(uint32_t word, std::size_t size)
+  {
+    uint8_t bytes[4];
+    encode_instruction(bytes, word, size);
+    writer.put(bytes, size);
+  }
+
+  uint32_t source_assembler::value_of(std::string_view text, bool& resolved) const
+  {
+    resolved = true;
+    const std::string value(trim(text));
+    if(value.empty())
+      throw("missing value"s);
+
+    const auto sym = symbols.find(value);
+    if(sym != symbols.end())
+      return sym->second;
+
+    std::size_t end = 0;
+    try
+    {
+      const long long rval = std::stoll(value, &end, 0);
+      if(end == value.size())
+        return uint32_t(rval);
+    }
+    catch(const std::exception&)
+    {
+    }
+
+    if(value[0] == '-' || std::isdigit(uint8_t(value[0])))
+      throw("invalid value: "s + value);
+    resolved = false; // a label defined further down
+    return 0;
+  }
+
+  void source_assembler::directive(std::string_view name, std::string_view operands, std::size_t number)
+  {
+    if(name == ".align"sv)
+    {
+      bool resolved;
+      const uint32_t alignment = value_of(operands, resolved);
+      if(!resolved || alignment == 0 || (alignment & (alignment - 1)))
+        throw("invalid alignment"s);
+      while(address() & (alignment - 1))
+        put(0, 1);
+      return;
+    }
+
+    const std::size_t size = name == ".byte"sv ? 1 : name == ".word"sv ? 2 : name == ".long"sv ? 4 : 0;
+    if(!size)
+      throw("unknown directive: "s + std::string(name));
+
+    for(std::size_t start = 0; start <= operands.size(); )
+    {
+      std::size_t comma = operands.find(',', start);
+      if(comma == std::string_view::npos)
+        comma = operands.size();
+      bool resolved;
+      const std::string_view text = operands.substr(start, comma - start);
+      const uint32_t value = value_of(text, resolved);
+      if(!resolved)
+      {
+        if(size != 4)
+          throw("undefined symbol: "s + std::string(trim(text)));
+        assembled_instruction label;
+        label.label = std::string(trim(text));
+        fixups.push_back({ number, writer.offset(), address(), label, true });
+      }
+      put(value, size);
+      start = comma + 1;
+    }
+  }
+
+  void source_assembler::line(std::string_view text, std::size_t number)
+  {
+    const asm_line parts = split_assembly_line(text, false);
+    const std::size_t code_end = parts.comment.data() ? std::size_t(parts.comment.data() - text.data()) - 1 : text.size();
+
+    if(!parts.label.empty())
+    {
+      const std::string name(parts.label.substr(0, parts.label.size() - 1));
+      if(!symbols.emplace(name, address()).second)
+        throw("duplicate label: "s + name);
+    }
+
+    if(!parts.directive.empty())
+    {
+      const std::size_t start = std::size_t(parts.directive.data() + parts.directive.size() - text.data());
+      const std::string_view operands = text.substr(start, code_end - start);
+      directive(parts.directive, operands.substr(0, operands.find('!')), number);
+      return;
+    }
+
+    if(parts.mnemonic.empty())
+    {
+      const std::string_view rest = trim(parts.rest);
+      if(!parts.operand.empty() || (!rest.empty() && rest[0] != '!'))
+        throw("syntax error"s);
+      return;
+    }
+
+    if(address() & 1)
+      throw("misaligned instruction"s);
+
+    const std::size_t start = std::size_t(parts.mnemonic.data() - text.data());
+    assembled_instruction insn = as.assemble(text.substr(start, code_end - start), address(), symbols);
+    if(!insn.label.empty())
+      fixups.push_back({ number, writer.offset(), address(), insn, false });
+    put_instruction(insn.word, insn.size);
+  }
+
+  // the second pass: labels used before their definition
+  void source_assembler::resolve(const std::string& name, std::ostream& log, stream_stats& stats)
+  {
+    for(pending_fixup& f : fixups)
+    {
+      try
+      {
+        const auto sym = symbols.find(f.insn.label);
+        if(sym == symbols.end())
+          throw("undefined label: "s + f.insn.label);
+
+        uint8_t bytes[4];
+        if(f.data)
+        {
+          encode(bytes, sym->second, 4);
+          writer.patch(f.offset, bytes, 4);
+        }
+        else
+        {
+          as.fixup(f.insn, f.address, sym->second);
+          encode_instruction(bytes, f.insn.word, f.insn.size);
+          writer.patch(f.offset, bytes, f.insn.size);
+        }
+        ++stats.fixups;
+      }
+      catch(const std::string& message)
+      {
+        log << name << ":" << f.line << ": " << message << std::endl;
+        ++stats.errors;
+      }
+    }
+  }
+}
+
+stream_stats assemble_stream(const assembler& as, int input, int output, const stream_options& options,
+                             const std::string& name, std::ostream& log)
+{
+  line_reader reader(input, options.buffer_size);
+  object_writer writer(output, options.buffer_size);
+  source_assembler source(as, options, writer);
+  stream_stats rval;
+
+  std::string_view text;
+  while(reader.next(text))
+  {
+    ++rval.lines;
+    try
+    {
+      source.line(text, rval.lines);
+    }
+    catch(const std::string& message)
+    {
+      log << name << ":" << rval.lines << ": " << message << std::endl;
+      ++rval.errors;
+    }
+  }
+
+  source.resolve(name, log, rval);
+  writer.flush();
+  rval.input_bytes = reader.bytes_read();
+  rval.output_bytes = std::size_t(writer.offset());
+  return rval;
+}
@@ -0,0 +1,39 @@
+#ifndef STREAM_ASSEMBLER_H
+#define STREAM_ASSEMBLER_H
+
+#include "assembler.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+struct stream_options
+{
+  uint32_t base = 0;
+  bool little_endian = false;
+  std::size_t buffer_size = 1 << 20; // of the input and of the output buffer
+};
+
+struct stream_stats
+{
+  std::size_t lines = 0;
+  std::size_t input_bytes = 0;
+  std::size_t output_bytes = 0;
+  std::size_t fixups = 0; // forward references resolved at the end
+  std::size_t errors = 0;
+};
+
+// assembles the source read from the file descriptor 'input' into a raw image
+// written to 'output'.
+// the source goes through a fixed buffer a line at a time (lines are split
+// with split_assembly_line()) and the bytes are written as soon as the buffer
+// is full.  labels used before their definition are kept in a fixup list and
+// patched into the output once the whole source has been read; patches past
+// the buffer need a seekable output.  besides the buffers, memory grows only
+// with the symbols and the forward references.
+// line errors are reported to 'log' as "name:line: message", i/o errors are
+// thrown as std::string.
+stream_stats assemble_stream(const assembler& as, int input, int output, const stream_options& options,
+                             const std::string& name, std::ostream& log);
+
+#endif // STREAM_ASSEMBLER_H
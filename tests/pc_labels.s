@@ -0,0 +1,31 @@
+; PC relative loads and mova with labels for their displacement, next to
+; the numeric form (make check compares the disassembly with pc_labels.dis)
+start:
+  mov.l   long_a,r1
+  mov.l   @(long_b,pc),r2
+  mov.w   word_a,r3
+  mov.w   @(word_b,pc),r4
+  mova    long_b,r0
+  mova    @(long_a,pc),r0
+  mov.l   @(8,pc),r5
+  bra     next
+  nop
+  .align  4
+long_a:
+  .long   0x12345678
+long_b:
+  .long   start
+word_a:
+  .word   0x1234
+word_b:
+  .word   0x5678
+next:
+  mov.w   word_c,r6
+  mova    long_c,r0
+  mov.l   long_c,r7
+  sleep
+word_c:
+  .word   0x7fff
+  .align  4
+long_c:
+  .long   next